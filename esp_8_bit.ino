@@ -34,6 +34,8 @@
 #include "src/gpio_input.h"
 #include "src/analog_glitch.h"
 #include "src/midi_input.h"
+#include "src/trace.h"
+#include "src/perf_counters.h"
 
 // esp_8_bit
 // Atari 8 computers, NES and SMS game consoles on your TV with nothing more than a ESP32 and a sense of nostalgia
@@ -91,6 +93,7 @@ void emu_loop()
     uint32_t t = xthal_get_ccount();
     gui_update();
     _frame_time = xthal_get_ccount() - t;
+    perf_frame(240000000/(_emu->standard ? 60 : 50));   // per subsystem cycle counts
     _lines = _emu->video_buffer();
     _drawn++;
 }
@@ -191,6 +194,10 @@ void perf()
     _blit_ticks_min = 0xFFFFFFFF;
     _blit_ticks_max = 0;
     _isr_us = 0;
+
+    char buf[128];
+    if (perf_summary(buf,sizeof(buf)))
+      printf("%s\n",buf);
   }
 }
 #else
@@ -220,4 +227,7 @@ void loop()
 
   // Dump some stats
   perf();
+
+  // format trace records logged by either core
+  trace_drain();
 }
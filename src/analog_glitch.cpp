@@ -1,4 +1,5 @@
 #include "analog_glitch.h"
+#include "trace.h"
 
 #ifdef ESP_PLATFORM
 #include "driver/adc.h"
@@ -54,14 +55,9 @@ void analog_glitch_set_slot(uint8_t slot) {
 void analog_glitch_update() {
     _debug_call_count++;
     
-    // Print debug info every 100 calls to show it's working (reduced from 1000)
+    // Trace every 100 calls to show it's working
     if (_debug_call_count % 100 == 0) {
-        printf("Analog glitch update called %d times\n", _debug_call_count);
-    }
-    
-    // Also print first few calls
-    if (_debug_call_count <= 5) {
-        printf("Analog glitch update #%d\n", _debug_call_count);
+        TRACE_DEBUG(TRACE_GLITCH_UPDATE, _debug_call_count, 0);
     }
     
     if (!_glitch_state.enabled) {
@@ -106,9 +102,8 @@ void analog_glitch_update() {
         _glitch_state.last_slot = new_slot;
         update_glitch_mask(new_slot);
         
-        // Debug print when slot changes (non-flooding)
-        printf("ADC: %d -> Glitch Slot: %d (mask: 0x%04X)\n", 
-               _glitch_state.raw_adc, new_slot, _glitch_mask);
+        // Trace when slot changes (non-flooding)
+        TRACE_INFO(TRACE_GLITCH_SLOT, _glitch_state.raw_adc, (new_slot << 16) | _glitch_mask);
     }
     
     _glitch_state.last_update_ms = current_ms;
@@ -129,14 +124,13 @@ void set_glitch_enabled(bool enabled) {
     }
 }
 
-// Function to be used by PPU glitch system
-uint16_t analog_ppu_glitch_addr(uint16_t addr) {
-    if (!_glitch_state.enabled || _glitch_mask == 0) {
-        return addr;  // No glitching
+// Address lines the video chip should force low. Each emulator polls this once
+// per frame and switches to its glitched fetch paths only while it is non-zero
+uint16_t analog_glitch_mask() {
+    if (!_glitch_state.enabled) {
+        return 0x0000;  // No glitching
     }
-    
-    // Apply the mask to force selected address lines low
-    return addr & ~_glitch_mask;
+    return _glitch_mask;
 }
 
 } // extern "C"
@@ -167,8 +161,8 @@ void set_glitch_enabled(bool enabled) {
     (void)enabled;
 }
 
-uint16_t analog_ppu_glitch_addr(uint16_t addr) {
-    return addr;
+uint16_t analog_glitch_mask() {
+    return 0x0000;
 }
 
 } // extern "C"
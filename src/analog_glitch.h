@@ -38,8 +38,9 @@ uint8_t get_glitch_slot();
 bool is_glitch_enabled();
 void set_glitch_enabled(bool enabled);
 
-// PPU glitch function - applies analog-controlled glitch to address
-uint16_t analog_ppu_glitch_addr(uint16_t addr);
+// Glitch mask - address lines forced low by the analog control, polled per frame by
+// the NES PPU, SMS VDP and ANTIC
+uint16_t analog_glitch_mask();
 
 #ifdef __cplusplus
 }
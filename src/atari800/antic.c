@@ -37,6 +37,7 @@
 #include "platform.h"
 #include "pokey.h"
 #include "util.h"
+#include "../perf_counters.h"
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 #include "input.h"
 #include "screen.h"
@@ -204,14 +205,21 @@ void ANTIC_VideoPutByte(UBYTE *ptr, UBYTE val)
 #define WRITE_VIDEO_LONG_UNALIGNED(ptr, val)  UNALIGNED_PUT_LONG((ptr), (val), Screen_atari_write_long_stat)
 #endif
 
+/* TRUE if the four pm_scanline bytes at x are outside the part GTIA drew on */
+#ifdef NEW_CYCLE_EXACT
+#define PM_UNDRAWN(x) FALSE
+#else
+#define PM_UNDRAWN(x) ((const UBYTE *) (x) + 4 <= GTIA_pm_lo || (const UBYTE *) (x) >= GTIA_pm_hi)
+#endif
+
 #ifdef WORDS_UNALIGNED_OK
-#define IS_ZERO_ULONG(x) (! UNALIGNED_GET_LONG(x, pm_scanline_read_long_stat))
+#define IS_ZERO_ULONG(x) (PM_UNDRAWN(x) || ! UNALIGNED_GET_LONG(x, pm_scanline_read_long_stat))
 #define DO_GTIA_BYTE(p, l, x) { \
 		WRITE_VIDEO_LONG_UNALIGNED((ULONG *) (p),     (l)[(x) >> 4]); \
 		WRITE_VIDEO_LONG_UNALIGNED((ULONG *) (p) + 1, (l)[(x) & 0xf]); \
 	}
 #else /* WORDS_UNALIGNED_OK */
-#define IS_ZERO_ULONG(x) (!((const UBYTE *)(x))[0] && !((const UBYTE *)(x))[1] && !((const UBYTE *)(x))[2] && !((const UBYTE *)(x))[3])
+#define IS_ZERO_ULONG(x) (PM_UNDRAWN(x) || (!((const UBYTE *)(x))[0] && !((const UBYTE *)(x))[1] && !((const UBYTE *)(x))[2] && !((const UBYTE *)(x))[3]))
 #define DO_GTIA_BYTE(p, l, x) { \
 		WRITE_VIDEO((UWORD *) (p),     (UWORD) ((l)[(x) >> 4])); \
 		WRITE_VIDEO((UWORD *) (p) + 1, (UWORD) ((l)[(x) >> 4])); \
@@ -681,6 +689,49 @@ static UWORD hires_lookup_m[128];
 #define hires_norm(x)	hires_lookup_n[(x) >> 1]
 #define hires_mask(x)	hires_lookup_m[(x) >> 1]
 
+/* Hi-res modes 2, 3 and F draw four hi-res pixels (one long) per nibble of
+   screen data. The longs for all 16 nibbles are kept in hires_nibble and only
+   rebuilt when the colours behind hires_norm change, so a byte of screen data
+   costs two lookups and two long writes when the line is long aligned. On an
+   NTSC composite output these are the pixel patterns that show up as
+   artifact colours. */
+static ULONG hires_nibble[16];
+static UWORD hires_nibble_cl[4];
+static int hires_aligned;
+
+static void setup_hires_nibbles(const UWORD *ptr)
+{
+	int i;
+	hires_aligned = !((uintptr_t) ptr & 2);
+	if (hires_nibble_cl[0] == hires_norm(0x00) && hires_nibble_cl[1] == hires_norm(0x40)
+	 && hires_nibble_cl[2] == hires_norm(0x80) && hires_nibble_cl[3] == hires_norm(0xc0))
+		return;
+	hires_nibble_cl[0] = hires_norm(0x00);
+	hires_nibble_cl[1] = hires_norm(0x40);
+	hires_nibble_cl[2] = hires_norm(0x80);
+	hires_nibble_cl[3] = hires_norm(0xc0);
+	for (i = 0; i < 16; i++) {
+#ifdef WORDS_BIGENDIAN
+		hires_nibble[i] = ((ULONG) hires_nibble_cl[i >> 2] << 16) | hires_nibble_cl[i & 3];
+#else
+		hires_nibble[i] = hires_nibble_cl[i >> 2] | ((ULONG) hires_nibble_cl[i & 3] << 16);
+#endif
+	}
+}
+
+#define DRAW_HIRES(data) \
+	if (hires_aligned) { \
+		WRITE_VIDEO_LONG((ULONG *) ptr, hires_nibble[(data) >> 4]); \
+		WRITE_VIDEO_LONG((ULONG *) ptr + 1, hires_nibble[(data) & 0x0f]); \
+		ptr += 4; \
+	} \
+	else { \
+		WRITE_VIDEO(ptr++, hires_norm((data) & 0xc0)); \
+		WRITE_VIDEO(ptr++, hires_norm((data) & 0x30)); \
+		WRITE_VIDEO(ptr++, hires_norm((data) & 0x0c)); \
+		WRITE_VIDEO(ptr++, hires_norm(((data) & 0x03) << 2)); \
+	}
+
 #ifndef USE_COLOUR_TRANSLATION_TABLE
 int ANTIC_artif_new = FALSE; /* New type of artifacting */
 UWORD ANTIC_hires_lookup_l[128];	/* accessed in gtia.c */
@@ -1828,6 +1879,7 @@ static void draw_antic_2(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	INIT_BACKGROUND_6
 	INIT_ANTIC_2
 	INIT_HIRES
+	setup_hires_nibbles(ptr);
 
 	CHAR_LOOP_BEGIN
 		UBYTE screendata = *antic_memptr++;
@@ -1836,10 +1888,7 @@ static void draw_antic_2(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 		GET_CHDATA_ANTIC_2
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
 			if (chdata) {
-				WRITE_VIDEO(ptr++, hires_norm(chdata & 0xc0));
-				WRITE_VIDEO(ptr++, hires_norm(chdata & 0x30));
-				WRITE_VIDEO(ptr++, hires_norm(chdata & 0x0c));
-				WRITE_VIDEO(ptr++, hires_norm((chdata & 0x03) << 2));
+				DRAW_HIRES(chdata)
 			}
 			else
 				DRAW_BACKGROUND(C_PF2)
@@ -2672,15 +2721,13 @@ static void draw_antic_f(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 {
 	INIT_BACKGROUND_6
 	INIT_HIRES
+	setup_hires_nibbles(ptr);
 
 	CHAR_LOOP_BEGIN
 		int screendata = *antic_memptr++;
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
 			if (screendata) {
-				WRITE_VIDEO(ptr++, hires_norm(screendata & 0xc0));
-				WRITE_VIDEO(ptr++, hires_norm(screendata & 0x30));
-				WRITE_VIDEO(ptr++, hires_norm(screendata & 0x0c));
-				WRITE_VIDEO(ptr++, hires_norm((screendata & 0x03) << 2));
+				DRAW_HIRES(screendata)
 			}
 			else
 				DRAW_BACKGROUND(C_PF2)
@@ -3017,6 +3064,8 @@ void ANTIC_UpdateArtifacting(void)
 	UBYTE q;
 	UBYTE art_white;
 
+	ANTIC_InvalidateLines();
+
 	if (ANTIC_artif_mode == 0) {
 		draw_antic_table[0][2] = draw_antic_table[0][3] = draw_antic_2;
 		draw_antic_table[0][0xf] = draw_antic_f;
@@ -3129,14 +3178,34 @@ UBYTE ANTIC_GetDLByte(UWORD *paddr)
 	return result;
 }
 
+/* Address line glitch ----------------------------------------------------- */
+
+/* ANTIC address lines forced low, 0 when clean. The glitched fetches are
+   separate functions swapped in by ANTIC_SetGlitch so the clean path
+   carries no glitch code. */
+static UWORD glitch_mask = 0;
+
+static UBYTE glitch_GetDLByte(UWORD *paddr)
+{
+	UWORD addr = *paddr & ~glitch_mask;
+	UBYTE result = ANTIC_GetDLByte(&addr);	/* fetch through the masked lines */
+	int next = *paddr + 1;					/* but the counter advances normally */
+	if ((next & 0x3FF) == 0)
+		next -= 0x400;
+	*paddr = (UWORD) next;
+	return result;
+}
+
+static UBYTE (*get_dl_byte)(UWORD *paddr) = ANTIC_GetDLByte;
+
 UWORD ANTIC_GetDLWord(UWORD *paddr)
 {
-	UBYTE lsb = ANTIC_GetDLByte(paddr);
+	UBYTE lsb = get_dl_byte(paddr);
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 	if (ANTIC_player_flickering && ((GTIA_VDELAY & 0x80) == 0 || ANTIC_ypos & 1))
 		GTIA_GRAFP3 = lsb;
 #endif
-	return (ANTIC_GetDLByte(paddr) << 8) + lsb;
+	return (get_dl_byte(paddr) << 8) + lsb;
 }
 
 #if !defined(BASIC) && !defined(CURSES_BASIC)
@@ -3190,6 +3259,41 @@ static void antic_load(void)
 #endif
 }
 
+/* Screen memory fetch through the glitched address lines. In character
+   modes the low six bits of each code drive A3-A8 of the character
+   generator fetch, so the glitch strips them too. */
+static void antic_load_glitch(void)
+{
+	UBYTE *antic_memptr = antic_memory + ANTIC_margin;
+	UBYTE code_mask = anticmode < 8 ? (UBYTE) ~((glitch_mask >> 3) & 0x3f) : 0xff;
+	int n = chars_read[md];
+	while (n--) {
+		UWORD addr = screenaddr & ~glitch_mask;
+		UBYTE data;
+		if (ANTIC_xe_ptr != NULL && addr < 0x8000 && addr >= 0x4000)
+			data = ANTIC_xe_ptr[addr - 0x4000];
+		else
+			data = MEMORY_dGetByte(addr);
+		*antic_memptr++ = data & code_mask;
+		screenaddr = (screenaddr & 0xf000) | ((screenaddr + 1) & 0x0fff);	/* 4K wrap */
+	}
+}
+
+static void (*antic_load_ptr)(void) = antic_load;
+
+void ANTIC_SetGlitch(UWORD mask)
+{
+	glitch_mask = mask;
+	if (mask) {
+		get_dl_byte = glitch_GetDLByte;
+		antic_load_ptr = antic_load_glitch;
+	}
+	else {
+		get_dl_byte = ANTIC_GetDLByte;
+		antic_load_ptr = antic_load;
+	}
+}
+
 #ifdef NEW_CYCLE_EXACT
 int ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
 #endif
@@ -3198,6 +3302,119 @@ int ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
 static int scanlines_to_curses_display = 0;
 #endif
 
+#ifndef NEW_CYCLE_EXACT
+/* Line skip cache. Each scanline gets a signature of everything its expansion
+   depends on: DL instruction, fetched screen data, character set, colour and
+   control registers. When it matches last frame's, the pixels already in
+   Screen_atari are left alone. Lines with players or missiles always draw since
+   the PMG merge also produces collisions. */
+static ULONG line_sig[Screen_HEIGHT];
+static ULONG load_sig;				/* antic_memory as of the last load */
+#ifndef PAGE_GENERATIONS
+static ULONG charset_sig[64];		/* per 1K page, computed once per frame */
+static UBYTE charset_frame[64];
+static UBYTE sig_frame = 0;
+#endif
+int ANTIC_line_hits = 0;
+int ANTIC_line_misses = 0;
+
+#define SIG_SEED 0x811c9dc5
+#define SIG_MIX(h, v) (((h) ^ (ULONG) (v)) * 0x01000193)
+
+static ULONG sig_bytes(ULONG h, const UBYTE *p, int n)
+{
+	while (n--)
+		h = SIG_MIX(h, *p++);
+	return h;
+}
+
+#ifdef PAGE_GENERATIONS
+/* Write generation of the charset. The checkpoint after sampling makes any
+   later write, even one further down this frame, read back as newer. */
+static ULONG charset_page_sig(void)
+{
+	ULONG gen = MEMORY_RangeGen(chbase_20 & 0xfc00, 1024);
+	MEMORY_Checkpoint();
+	return gen;
+}
+#else
+static ULONG charset_page_sig(void)
+{
+	int page = chbase_20 >> 10;
+	if (charset_frame[page] != sig_frame) {
+		charset_frame[page] = sig_frame;
+		charset_sig[page] = sig_bytes(SIG_SEED, MEMORY_mem + (page << 10), 1024);
+	}
+	return charset_sig[page];
+}
+#endif
+
+static ULONG reg_sig(void)
+{
+	ULONG h = SIG_SEED;
+	h = SIG_MIX(h, GTIA_COLPF0 | (GTIA_COLPF1 << 8) | (GTIA_COLPF2 << 16) | (GTIA_COLPF3 << 24));
+	h = SIG_MIX(h, GTIA_COLPM0 | (GTIA_COLPM1 << 8) | (GTIA_COLPM2 << 16) | (GTIA_COLPM3 << 24));
+	h = SIG_MIX(h, GTIA_COLBK | (GTIA_PRIOR << 8) | (ANTIC_DMACTL << 16) | (ANTIC_CHACTL << 24));
+	return SIG_MIX(h, ANTIC_HSCROL);
+}
+
+static ULONG blank_line_sig(void)
+{
+	return SIG_MIX(reg_sig(), (size_t) draw_antic_0_ptr);
+}
+
+static ULONG mode_line_sig(void)
+{
+	ULONG h = reg_sig();
+	h = SIG_MIX(h, IR | (anticmode << 8) | (md << 16) | (dctr << 24));
+	h = SIG_MIX(h, (size_t) draw_antic_ptr);
+	h = SIG_MIX(h, load_sig);
+	if (anticmode < 8)
+		h = SIG_MIX(SIG_MIX(h, chbase_20), charset_page_sig());
+	return h;
+}
+
+/* TRUE if this scanline can be left as drawn last frame */
+static int line_cached(ULONG sig)
+{
+	ULONG *slot = &line_sig[ANTIC_ypos - 8];
+	if (GTIA_pm_dirty || ANTIC_xe_ptr != NULL)
+		sig = 0;
+	else if (sig == 0)
+		sig = 1;
+	if (sig && *slot == sig) {
+		ANTIC_line_hits++;
+		return TRUE;
+	}
+	*slot = sig;
+	ANTIC_line_misses++;
+	return FALSE;
+}
+#endif /* NEW_CYCLE_EXACT */
+
+/* Something other than ANTIC wrote Screen_atari, redraw every line next frame */
+void ANTIC_InvalidateLines(void)
+{
+#ifndef NEW_CYCLE_EXACT
+	memset(line_sig, 0, sizeof(line_sig));
+#endif
+}
+
+/* Overlays drawn on top of Screen_atari rows first..first+count-1 */
+void ANTIC_InvalidateRows(int first, int count)
+{
+#ifndef NEW_CYCLE_EXACT
+	if (first < 0) {
+		count += first;
+		first = 0;
+	}
+	if (first + count > Screen_HEIGHT)
+		count = Screen_HEIGHT - first;
+	if (count > 0)
+		memset(line_sig + first, 0, count * sizeof(line_sig[0]));
+#endif
+}
+
 /* This function emulates one frame drawing screen at Screen_atari */
 void ANTIC_Frame(int draw_display)
 {
@@ -3228,6 +3445,16 @@ void ANTIC_Frame(int draw_display)
 	scrn_ptr = (UWORD *) Screen_atari;
 #ifdef NEW_CYCLE_EXACT
 	ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
+#else
+#ifndef PAGE_GENERATIONS
+	if (++sig_frame == 0)
+		sig_frame = 1;				/* charset_frame starts out zero */
+#endif
+	ANTIC_line_hits = ANTIC_line_misses = 0;
+#ifndef NO_SIMPLE_PAL_BLENDING
+	if (ANTIC_pal_blending)
+		ANTIC_InvalidateLines();	/* blending works in place */
+#endif
 #endif
 	need_dl = TRUE;
 	do {
@@ -3249,7 +3476,7 @@ void ANTIC_Frame(int draw_display)
 		need_load = FALSE;
 		if (need_dl) {
 			if (ANTIC_DMACTL & 0x20) {
-				IR = ANTIC_GetDLByte(&ANTIC_dlist);
+				IR = get_dl_byte(&ANTIC_dlist);
 				anticmode = IR & 0xf;
 				ANTIC_xpos++;
 				/* PMG flickering :-) */
@@ -3459,7 +3686,8 @@ void ANTIC_Frame(int draw_display)
 		ANTIC_xpos += ANTIC_DMAR;
 
 		if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
-			draw_antic_0_ptr();
+			if (!line_cached(blank_line_sig()))
+				draw_antic_0_ptr();
 			GOEOL;
 			YPOS_BREAK_FLICKER;
 			scrn_ptr += Screen_WIDTH / 2;
@@ -3471,7 +3699,8 @@ void ANTIC_Frame(int draw_display)
 		}
 
 		if (need_load) {
-			antic_load();
+			antic_load_ptr();
+			load_sig = sig_bytes(SIG_SEED, antic_memory, sizeof(antic_memory));
 #ifdef USE_CURSES
 			/* Normally, we would call curses_display_line here,
 			   and not use scanlines_to_curses_display at all.
@@ -3486,10 +3715,16 @@ void ANTIC_Frame(int draw_display)
 				ANTIC_xpos -= extra_cycles[md];
 		}
 
-		draw_antic_ptr(chars_displayed[md],
-			antic_memory + ANTIC_margin + ch_offset[md],
-			scrn_ptr + x_min[md],
-			(ULONG *) &GTIA_pm_scanline[x_min[md]]);
+		if (!line_cached(mode_line_sig())) {
+			PERF_BEGIN(PERF_RENDER);
+			draw_antic_ptr(chars_displayed[md],
+				antic_memory + ANTIC_margin + ch_offset[md],
+				scrn_ptr + x_min[md],
+				(ULONG *) &GTIA_pm_scanline[x_min[md]]);
+			PERF_END();
+		}
+		else if (anticmode < 8)
+			ADD_FONT_CYCLES;	/* the skipped draw would have stolen them */
 
 		GOEOL;
 #endif /* NEW_CYCLE_EXACT */
@@ -3771,7 +4006,7 @@ void draw_partial_scanline(int l, int r)
 	else { /* right point is past start of playfield */
 		/* now load ANTIC data: needed for ANTIC glitches */
 		if (need_load) {
-			antic_load();
+			antic_load_ptr();
 #ifdef USE_CURSES
 			/* Normally, we would call curses_display_line here,
 			   and not use scanlines_to_curses_display at all.
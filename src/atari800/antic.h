@@ -80,6 +80,15 @@ void ANTIC_PutByte(UWORD addr, UBYTE byte);
 UBYTE ANTIC_GetDLByte(UWORD *paddr);
 UWORD ANTIC_GetDLWord(UWORD *paddr);
 
+/* Force ANTIC address lines low on display list and screen fetches */
+void ANTIC_SetGlitch(UWORD mask);
+
+/* Forget the line skip cache, Screen_atari was written behind ANTIC's back */
+void ANTIC_InvalidateLines(void);
+void ANTIC_InvalidateRows(int first, int count);
+extern int ANTIC_line_hits;		/* scanlines skipped/drawn last frame */
+extern int ANTIC_line_misses;
+
 /* always call ANTIC_UpdateArtifacting after changing ANTIC_artif_mode */
 void ANTIC_UpdateArtifacting(void);
 
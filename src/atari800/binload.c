@@ -33,6 +33,7 @@
 #include "log.h"
 #include "memory.h"
 #include "sio.h"
+#include "util.h"
 
 int BINLOAD_start_binloading = FALSE;
 int BINLOAD_loading_basic = 0;
@@ -71,6 +72,43 @@ static int read_word(void)
 	return buf[0] + (buf[1] << 8);
 }
 
+/* Reads SIZE bytes of a segment body from FP and stores them from address
+   FROM on, a page at a time. Returns the number of bytes stored, which is
+   less than SIZE at end of file. */
+int BINLOAD_ReadSegment(FILE *fp, UWORD from, int size)
+{
+	UBYTE buf[256];
+	int done = 0;
+	while (done < size) {
+		int n = 0x100 - (from & 0xff);
+		int got;
+		if (n > size - done)
+			n = size - done;
+		got = (int) fread(buf, 1, n, fp);
+		MEMORY_CopyToMem(buf, from, got);
+		done += got;
+		if (got < n)
+			break;
+		from += n;
+	}
+	return done;
+}
+
+/* End of file: jump to RUNAD, through INITAD if it was set */
+static void loader_eof(void)
+{
+	fclose(BINLOAD_bin_file);
+	BINLOAD_bin_file = NULL;
+	CPU_regPC = MEMORY_dGetWordAligned(0x2e0);
+	if (MEMORY_dGetByte(0x2e3) != 0xd7) {
+		/* run INIT routine which RTSes directly to RUN routine */
+		CPU_regPC--;
+		MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC >> 8);		/* high */
+		MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC & 0xff);	/* low */
+		CPU_regPC = MEMORY_dGetWordAligned(0x2e2);
+	}
+}
+
 /* Start or continue loading */
 static void loader_cont(void)
 {
@@ -108,7 +146,17 @@ static void loader_cont(void)
 			to++;
 			segfinished = FALSE;
 		}
-		do {
+		if (!BINLOAD_slow_xex_loading) {
+			/* the whole segment at once */
+			int size = ((to - from - 1) & 0xffff) + 1;
+			int n = BINLOAD_ReadSegment(BINLOAD_bin_file, from, size);
+			from += n;
+			if (n < size) {
+				loader_eof();
+				return;
+			}
+		}
+		else do {
 			int byte;
 			if (BINLOAD_slow_xex_loading) {
 				instr_elapsed++;
@@ -125,16 +173,7 @@ static void loader_cont(void)
 			}
 			byte = fgetc(BINLOAD_bin_file);
 			if (byte == EOF) {
-				fclose(BINLOAD_bin_file);
-				BINLOAD_bin_file = NULL;
-				CPU_regPC = MEMORY_dGetWordAligned(0x2e0);
-				if (MEMORY_dGetByte(0x2e3) != 0xd7) {
-					/* run INIT routine which RTSes directly to RUN routine */
-					CPU_regPC--;
-					MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC >> 8);		/* high */
-					MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC & 0xff);	/* low */
-					CPU_regPC = MEMORY_dGetWordAligned(0x2e2);
-				}
+				loader_eof();
 				return;
 			}
 			MEMORY_PutByte(from, (UBYTE) byte);
@@ -195,6 +234,7 @@ int BINLOAD_Loader(const char *filename)
 		Log_print("binload: can't open \"%s\"", filename);
 		return FALSE;
 	}
+	Util_fbuffer(BINLOAD_bin_file);
 	/* Avoid "BOOT ERROR" when loading a BASIC program */
 	if (SIO_drive_status[0] == SIO_NO_DISK)
 		SIO_DisableDrive(1);
@@ -28,4 +28,8 @@ extern int BINLOAD_pause_loading;
 #define BINLOAD_LOADING_BASIC_RUN                7
 int BINLOAD_LoaderStart(UBYTE *buffer);
 
+/* Stores the next SIZE bytes of FP from address FROM on.
+   Returns the number of bytes stored. */
+int BINLOAD_ReadSegment(FILE *fp, UWORD from, int size);
+
 #endif /* BINLOAD_H_ */
@@ -344,6 +344,9 @@
 /* Define to 1 if you have the `_mkdir' function. */
 /* #undef HAVE__MKDIR */
 
+/* Define to the stdio buffer size used for H: device and executable files. */
+#define HOST_FILE_BUFFER 4096
+
 /* Define to add IDE harddisk emulation. */
 //#define IDE 1
 
@@ -430,6 +433,9 @@
 /* #undef PAGED_ATTRIB */
 #define PAGED_ATTRIB
 
+/* Define to keep a write generation for each 256 byte page of memory. */
+#define PAGE_GENERATIONS 1
+
 /* Use accurate PAL color blending. */
 #define PAL_BLENDING 1
 
@@ -451,6 +457,9 @@
 /* Define to add Pokey registers recording. */
 //#define POKEYREC 1
 
+/* Define to render Pokey channels a block of samples at a time. */
+#define POKEYSND_BLOCK 1
+
 /* Use 8-bit signed samples. */
 /* #undef POKEYSND_SIGNED_SAMPLES */
 
@@ -491,6 +500,9 @@
 /* Target: X11 with shared memory extensions. */
 /* #undef SHM */
 
+/* Define to the number of 1k lines used to cache disk image sectors. */
+#define SIO_SECTOR_CACHE 4
+
 /* Define to activate sound support. */
 #define SOUND 1
 
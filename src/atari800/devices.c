@@ -839,6 +839,7 @@ static void Devices_H_Open(void)
 		   we want to support LF, CR/LF and CR, not only native EOLs */
 		fp = Util_fopen(host_path, "rb", h_tmpbuf[h_iocb]);
 		if (fp != NULL) {
+			Util_fbuffer(fp);
 			CPU_regY = 1;
 			CPU_ClrN;
 		}
@@ -957,6 +958,7 @@ static void Devices_H_Open(void)
 			}
 		}
 		if (fp != NULL) {
+			Util_fbuffer(fp);
 			CPU_regY = 1;
 			CPU_ClrN;
 		}
@@ -1429,6 +1431,7 @@ static void Devices_H_BinLoaderCont(void)
 	MEMORY_dPutByte(0x2e3, 0xd7);
 	do {
 		int temp;
+		int size;
 		UWORD from;
 		UWORD to;
 		do
@@ -1452,26 +1455,21 @@ static void Devices_H_BinLoaderCont(void)
 			BINLOAD_start_binloading = FALSE;
 		}
 
-		to++;
-		do {
-			int byte = fgetc(*binf);
-			if (byte == EOF) {
-				fclose(*binf);
-				*binf = NULL;
-				if (runBinFile)
-					CPU_regPC = MEMORY_dGetWordAligned(0x2e0);
-				if (initBinFile && (MEMORY_dGetByte(0x2e3) != 0xd7)) {
-					/* run INIT routine which RTSes directly to RUN routine */
-					CPU_regPC--;
-					MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC >> 8);	/* high */
-					MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC & 0xff);	/* low */
-					CPU_regPC = MEMORY_dGetWordAligned(0x2e2);
-				}
-				return;
+		size = ((to - from) & 0xffff) + 1;
+		if (BINLOAD_ReadSegment(*binf, from, size) < size) {
+			fclose(*binf);
+			*binf = NULL;
+			if (runBinFile)
+				CPU_regPC = MEMORY_dGetWordAligned(0x2e0);
+			if (initBinFile && (MEMORY_dGetByte(0x2e3) != 0xd7)) {
+				/* run INIT routine which RTSes directly to RUN routine */
+				CPU_regPC--;
+				MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC >> 8);	/* high */
+				MEMORY_dPutByte(0x0100 + CPU_regS--, CPU_regPC & 0xff);	/* low */
+				CPU_regPC = MEMORY_dGetWordAligned(0x2e2);
 			}
-			MEMORY_PutByte(from, (UBYTE) byte);
-			from++;
-		} while (from != to);
+			return;
+		}
 	} while (!initBinFile || MEMORY_dGetByte(0x2e3) == 0xd7);
 
 	CPU_regS--;
@@ -1572,6 +1570,8 @@ static void Devices_H_Load(int mydos)
 		}
 	}
 
+	Util_fbuffer(*binf);
+
 	/* check header */
 	if (fread(buf, 1, 2, *binf) != 2 || buf[0] != 0xff || buf[1] != 0xff) {
 		fclose(*binf);
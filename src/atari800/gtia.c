@@ -296,6 +296,8 @@ bit 7 - Missile 3
 
 UBYTE GTIA_pm_scanline[Screen_WIDTH / 2 + 8];	/* there's a byte for every *pair* of pixels */
 int GTIA_pm_dirty = TRUE;
+const UBYTE *GTIA_pm_lo = GTIA_pm_scanline;
+const UBYTE *GTIA_pm_hi = GTIA_pm_scanline + Screen_WIDTH / 2;
 
 #define C_PM0	0x01
 #define C_PM1	0x02
@@ -468,6 +470,8 @@ void GTIA_UpdatePmplColls(void)
 
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 
+#ifdef NEW_CYCLE_EXACT
+
 void GTIA_NewPmScanline(void)
 {
 #ifdef NEW_CYCLE_EXACT
@@ -548,6 +552,132 @@ void GTIA_NewPmScanline(void)
 	}
 }
 
+#else /* NEW_CYCLE_EXACT */
+
+/* Each object drawn on the line is kept as a mask of the pixel pairs it
+   covers from its first one on. Player/player and missile/player collisions
+   are found by shifting these masks against each other instead of testing
+   every pixel pair, so drawing only ORs into GTIA_pm_scanline. Only the part
+   that was drawn on is cleared for the next line, and the renderers skip
+   everything outside of it without reading it. */
+
+/* TRUE if mask a at offset oa and mask b at offset ob share a pixel pair */
+static int pm_overlap(int oa, ULONG a, int ob, ULONG b)
+{
+	if (ob >= oa)
+		return ob - oa < 32 && ((a >> (ob - oa)) & b) != 0;
+	return oa - ob < 32 && ((b >> (oa - ob)) & a) != 0;
+}
+
+void GTIA_NewPmScanline(void)
+{
+	static UBYTE * const pl_colls[4] = { &GTIA_P0PL, &GTIA_P1PL, &GTIA_P2PL, &GTIA_P3PL };
+	static UBYTE * const ml_colls[4] = { &GTIA_M0PL, &GTIA_M1PL, &GTIA_M2PL, &GTIA_M3PL };
+	UBYTE grafp_reg[4];
+	int off[8];			/* players 0-3, missiles 0-3 */
+	ULONG mask[8];
+	UBYTE *lo = GTIA_pm_scanline + Screen_WIDTH / 2;
+	UBYTE *hi = GTIA_pm_scanline;
+	int n;
+	int m;
+
+/* Clear if necessary */
+	if (GTIA_pm_dirty) {
+		memset(GTIA_pm_scanline + (GTIA_pm_lo - GTIA_pm_scanline), 0, GTIA_pm_hi - GTIA_pm_lo);
+		GTIA_pm_dirty = FALSE;
+	}
+
+/* Draw Players */
+	grafp_reg[0] = GTIA_GRAFP0;
+	grafp_reg[1] = GTIA_GRAFP1;
+	grafp_reg[2] = GTIA_GRAFP2;
+	grafp_reg[3] = GTIA_GRAFP3;
+	for (n = 0; n < 4; n++) {
+		ULONG grafp = grafp_ptr[n][grafp_reg[n]] & hposp_mask[n];
+		mask[n] = 0;
+		if (grafp) {
+			UBYTE *ptr = hposp_ptr[n];
+			UBYTE bit = 1 << n;
+			while (!(grafp & 1)) {
+				ptr++;
+				grafp >>= 1;
+			}
+			off[n] = ptr - GTIA_pm_scanline;
+			mask[n] = grafp;
+			if (n > 0) {
+				/* P0PL is built from the other players' bits when read */
+				UBYTE colls = bit;
+				for (m = 0; m < n; m++)
+					if (mask[m] && pm_overlap(off[m], mask[m], off[n], grafp))
+						colls |= 1 << m;
+				*pl_colls[n] |= colls;
+			}
+			if (ptr < lo)
+				lo = ptr;
+			do {
+				if (grafp & 1)
+					*ptr |= bit;
+				ptr++;
+				grafp >>= 1;
+			} while (grafp);
+			if (ptr > hi)
+				hi = ptr;
+			GTIA_pm_dirty = TRUE;
+		}
+	}
+
+/* Draw Missiles, 3 to 0 */
+	if (GTIA_GRAFM) {
+		GTIA_pm_dirty = TRUE;
+		mask[4] = mask[5] = mask[6] = mask[7] = 0;
+		for (n = 3; n >= 0; n--) {
+			int j = global_sizem[n];
+			UBYTE *ptr = hposm_ptr[n];
+			UBYTE p = 0x10 << n;
+			UBYTE colls;
+			if (!(GTIA_GRAFM & (0x03 << (n * 2))))
+				continue;
+			if (GTIA_GRAFM & (0x02 << (n * 2))) {
+				if (GTIA_GRAFM & (0x01 << (n * 2)))
+					j <<= 1;
+			}
+			else
+				ptr += j;
+			if (ptr < GTIA_pm_scanline + 2) {
+				j += ptr - GTIA_pm_scanline - 2;
+				ptr = GTIA_pm_scanline + 2;
+			}
+			else if (ptr + j > GTIA_pm_scanline + Screen_WIDTH / 2 - 2)
+				j = GTIA_pm_scanline + Screen_WIDTH / 2 - 2 - ptr;
+			if (j <= 0)
+				continue;
+			off[4 + n] = ptr - GTIA_pm_scanline;
+			mask[4 + n] = (1 << j) - 1;
+			colls = p;
+			for (m = 0; m < 8; m++)
+				if (mask[m] && m != 4 + n && pm_overlap(off[m], mask[m], off[4 + n], mask[4 + n]))
+					colls |= 1 << m;
+			*ml_colls[n] |= colls;
+			if (ptr < lo)
+				lo = ptr;
+			do
+				*ptr++ |= p;
+			while (--j);
+			if (ptr > hi)
+				hi = ptr;
+		}
+	}
+
+	if (lo < hi) {
+		GTIA_pm_lo = lo;
+		GTIA_pm_hi = hi;
+	}
+	else
+		GTIA_pm_lo = GTIA_pm_hi = GTIA_pm_scanline;
+}
+
+#endif /* NEW_CYCLE_EXACT */
+
 #endif /* !defined(BASIC) && !defined(CURSES_BASIC) */
 
 /* GTIA registers ---------------------------------------------------------- */
@@ -112,6 +112,9 @@ extern UWORD GTIA_colour_translation_table[256];
 
 extern UBYTE GTIA_pm_scanline[Screen_WIDTH / 2 + 8];	/* there's a byte for every *pair* of pixels */
 extern int GTIA_pm_dirty;
+/* GTIA_pm_scanline is zero outside [GTIA_pm_lo, GTIA_pm_hi) */
+extern const UBYTE *GTIA_pm_lo;
+extern const UBYTE *GTIA_pm_hi;
 
 extern UBYTE GTIA_collisions_mask_missile_playfield;
 extern UBYTE GTIA_collisions_mask_player_playfield;
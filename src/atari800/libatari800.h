@@ -201,6 +201,22 @@ int libatari800_mount_disk_image(int diskno, const char *filename, int readonly)
 
 int libatari800_reboot_with_file(const char *filename);
 
+/* Returns 1 if OPTION is a media option taking an argument, 0 if it takes
+   none or is a file name, -1 if it configures the machine. */
+int libatari800_media_option(const char *option);
+
+/* Returns the number of arguments machine OPTION takes, so callers splitting
+   ARGV don't mistake a value such as the 4 in "-mosaic 4" for a file name. */
+int libatari800_machine_option_args(const char *option);
+
+/* Swaps media and cold starts without reinitialising the machine: the OS
+   ROMs, memory and screen stay as set up by libatari800_init. ARGV is laid
+   out as for libatari800_init but may only hold media options and file
+   names; returns FALSE before changing anything if it holds others or an
+   option's argument is missing or invalid. Files that fail to load are
+   skipped, as libatari800_init skips them. */
+int libatari800_swap_media(int argc, char **argv);
+
 UBYTE *libatari800_get_main_memory_ptr();
 
 UBYTE *libatari800_get_screen_ptr();
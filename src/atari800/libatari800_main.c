@@ -45,6 +45,8 @@
 //#include "videomode.h"
 #include "sio.h"
 #include "cartridge.h"
+#include "cassette.h"
+#include "binload.h"
 //#include "ui.h"
 #include "libatari800_main.h"
 #include "libatari800_init.h"
@@ -249,6 +251,133 @@ int libatari800_mount_disk_image(int diskno, const char *filename, int readonly)
 	return SIO_Mount(diskno, filename, readonly);
 }
 
+/* Options libatari800_swap_media accepts, and whether they take an argument */
+static const struct {
+	const char *name;
+	int has_arg;
+} media_options[] = {
+	{ "-cart", TRUE },
+	{ "-cart-type", TRUE },
+	{ "-tape", TRUE },
+	{ "-boottape", TRUE },
+	{ "-run", TRUE },
+	{ "-H1", TRUE },
+	{ "-H2", TRUE },
+	{ "-H3", TRUE },
+	{ "-H4", TRUE },
+	{ "-basic", FALSE },
+	{ "-nobasic", FALSE }
+};
+
+int libatari800_media_option(const char *option)
+{
+	int i;
+	if (option[0] != '-')
+		return 0;	/* file name */
+	for (i = 0; i < (int) (sizeof(media_options) / sizeof(media_options[0])); i++)
+		if (strcmp(option, media_options[i].name) == 0)
+			return media_options[i].has_arg;
+	return -1;
+}
+
+/* Options that configure the machine and take an argument */
+static const char *machine_value_options[] = {
+	"-config", "-mosaic", "-axlon", "-state", "-refresh", "-label-file", "-bpc",
+	"-artif", "-ntsc-artif", "-pal-artif",
+	"-cart2", "-cart2-type", "-Hpath",
+	"-mouse", "-mouseport", "-mousespeed", "-record", "-playback", "-cx85",
+	"-screenshots", "-dsprate", "-volume", "-snddelay",
+	"-osa_rom", "-osb_rom", "-xlxe_rom", "-5200_rom", "-basic_rom",
+	"-800-rev", "-xl-rev", "-5200-rev", "-basic-rev", "-xegame-rev"
+};
+
+int libatari800_machine_option_args(const char *option)
+{
+	int i;
+	for (i = 0; i < (int) (sizeof(machine_value_options) / sizeof(machine_value_options[0])); i++)
+		if (strcmp(option, machine_value_options[i]) == 0)
+			return 1;
+	return 0;
+}
+
+int libatari800_swap_media(int argc, char **argv)
+{
+	const char *run_direct = NULL;
+	int i, j;
+
+	/* everything the option parsers below could reject is checked here,
+	   so nothing is ejected for media that won't go in */
+	for (i = 1; i < argc; i++) {
+		int n = libatari800_media_option(argv[i]);
+		if (n < 0 || i + n >= argc)
+			return FALSE;
+		if (strcmp(argv[i], "-cart-type") == 0) {
+			int type;
+			if (!Util_sscansdec(argv[i + 1], &type) || type < 0 || type > CARTRIDGE_LAST_SUPPORTED)
+				return FALSE;
+		}
+		i += n;
+	}
+
+	CPU_cim_encountered = 0;
+	libatari800_error_code = 0;
+	Atari800_nframes = 0;
+
+	/* eject everything, as a fresh libatari800_init would */
+	CARTRIDGE_Remove();
+	CARTRIDGE_main.filename[0] = '\0';
+	CARTRIDGE_piggyback.filename[0] = '\0';
+	CASSETTE_Remove();
+	for (i = 1; i <= SIO_MAX_DRIVES; i++)
+		SIO_DisableDrive(i);	/* dismounts, and leaves the drive off like SIO_Initialise */
+
+	for (i = j = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-basic") == 0)
+			Atari800_disable_basic = FALSE;
+		else if (strcmp(argv[i], "-nobasic") == 0)
+			Atari800_disable_basic = TRUE;
+		else if (strcmp(argv[i], "-run") == 0)
+			run_direct = argv[++i];
+		else
+			argv[j++] = argv[i];
+	}
+	argc = j;
+
+	/* the option parsers insert the cartridge and tape and set the H: paths.
+	   They only fail on the missing or bad arguments refused above; a cart
+	   or tape that doesn't load is dropped, as libatari800_init does. */
+	CARTRIDGE_Initialise(&argc, argv);
+	CASSETTE_Initialise(&argc, argv);
+	Devices_Initialise(&argc, argv);
+
+	for (i = j = 1; i < argc && j <= SIO_MAX_DRIVES; i++) {
+		switch (AFILE_OpenFile(argv[i], FALSE, j, FALSE)) {
+		case AFILE_ERROR:
+			Log_print("Error opening \"%s\"", argv[i]);
+			break;
+		case AFILE_ATR:
+		case AFILE_ATX:
+		case AFILE_XFD:
+		case AFILE_ATR_GZ:
+		case AFILE_XFD_GZ:
+		case AFILE_DCM:
+		case AFILE_PRO:
+			j++;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (CARTRIDGE_main.type == CARTRIDGE_UNKNOWN)
+		CARTRIDGE_SetType(&CARTRIDGE_main, UI_SelectCartType(CARTRIDGE_main.size));
+
+	Atari800_Coldstart();
+	if (run_direct != NULL)
+		BINLOAD_Loader(run_direct);
+	return TRUE;
+}
+
 int libatari800_reboot_with_file(const char *filename)
 {
 	int file_type;
@@ -50,6 +50,52 @@ UBYTE* under_atarixl_os = 0;
 
 int MEMORY_ram_size = 64;
 
+#ifdef PAGE_GENERATIONS
+ULONG MEMORY_page_gen[256];
+ULONG MEMORY_write_gen = 1;
+ULONG MEMORY_all_gen = 1;
+
+void MEMORY_TouchRange(UWORD addr, int size)
+{
+	int page;
+	if (size <= 0)
+		return;
+	for (page = addr >> 8; page <= (addr + size - 1) >> 8; page++)
+		MEMORY_page_gen[page & 0xff] = MEMORY_write_gen;
+}
+
+void MEMORY_TouchAll(void)
+{
+	MEMORY_all_gen = MEMORY_write_gen;
+}
+
+ULONG MEMORY_Checkpoint(void)
+{
+	/* Generations are compared by signed difference, which only works while
+	   they are less than 2^31 apart. Restamp every page each half wrap so an
+	   untouched one can't age into reading back as newer. */
+	if ((++MEMORY_write_gen & 0x7fffffff) == 0) {
+		int page;
+		for (page = 0; page < 256; page++)
+			MEMORY_page_gen[page] = MEMORY_write_gen;
+		MEMORY_all_gen = MEMORY_write_gen;
+	}
+	return MEMORY_write_gen;
+}
+
+ULONG MEMORY_RangeGen(UWORD addr, int size)
+{
+	ULONG gen = MEMORY_all_gen;
+	int page;
+	if (size <= 0)
+		return gen;
+	for (page = addr >> 8; page <= (addr + size - 1) >> 8; page++)
+		if (MEMORY_GenNewer(MEMORY_page_gen[page & 0xff], gen))
+			gen = MEMORY_page_gen[page & 0xff];
+	return gen;
+}
+#endif /* PAGE_GENERATIONS */
+
 #ifndef PAGED_ATTRIB
 
 UBYTE MEMORY_attrib[65536];
@@ -213,6 +259,7 @@ void MEMORY_InitialiseMachine(void)
 	                    : Atari800_machine_type == Atari800_MACHINE_5200 ? 0x800
 	                    : 0x4000;
 	int const os_rom_start = 0x10000 - os_size;
+	MEMORY_TouchAll();
 	ANTIC_xe_ptr = NULL;
 	cart809F_enabled = FALSE;
 	MEMORY_cartA0BF_enabled = FALSE;
@@ -456,6 +503,8 @@ void MEMORY_StateRead(UBYTE SaveVerbose, UBYTE StateVersion)
 	int num_xe_banks;
 	UBYTE portb;
 
+	MEMORY_TouchAll();
+
 	/* Axlon/Mosaic for 400/800 */
 	if (Atari800_machine_type == Atari800_MACHINE_800 && StateVersion >= 5) {
 		StateSav_ReadINT(&MEMORY_axlon_num_banks, 1);
@@ -705,11 +754,30 @@ void MEMORY_CopyFromMem(UWORD from, UBYTE *to, int size)
 
 void MEMORY_CopyToMem(const UBYTE *from, UWORD to, int size)
 {
+#ifdef PAGED_ATTRIB
+	/* pages without a write handler are plain RAM */
+	while (size > 0) {
+		int n = 0x100 - (to & 0xff);
+		if (n > size)
+			n = size;
+		if (MEMORY_writemap[to >> 8] == NULL)
+			MEMORY_dCopyToMem(from, to, n);
+		else {
+			int i;
+			for (i = 0; i < n; i++)
+				MEMORY_PutByte((UWORD) (to + i), from[i]);
+		}
+		from += n;
+		to += n;
+		size -= n;
+	}
+#else
 	while (--size >= 0) {
 		MEMORY_PutByte(to, *from);
 		from++;
 		to++;
 	}
+#endif /* PAGED_ATTRIB */
 }
 
 
@@ -750,6 +818,8 @@ void MEMORY_HandlePORTB(UBYTE byte, UBYTE oldval)
 	int mapram_selected = FALSE;
 	int new_mapram_selected = FALSE;
 
+	MEMORY_TouchAll();		/* banking swaps memory contents around */
+
 	/* MapRAM is selected if RAM > 20 KB, Self Test is enabled while OS ROM is disabled,
 	   and both CPU & ANTIC have access to base RAM. */
 	if (mapram_memory != NULL && MEMORY_ram_size > 20) {
@@ -953,13 +1023,13 @@ static void MosaicPutByte(UWORD addr, UBYTE byte)
 	}
 	else if (newbank < mosaic_current_num_banks && mosaic_curbank >= mosaic_current_num_banks) {
 		/*rom->ram*/
-		memcpy(MEMORY_mem + 0xc000, mosaic_ram+newbank*0x1000,0x1000);
+		MEMORY_dCopyToMem(mosaic_ram+newbank*0x1000, 0xc000, 0x1000);
 		MEMORY_SetRAM(0xc000, 0xcfff);
 	}
 	else {
 		/*ram -> ram*/
 		memcpy(mosaic_ram + mosaic_curbank*0x1000, MEMORY_mem + 0xc000, 0x1000);
-		memcpy(MEMORY_mem + 0xc000, mosaic_ram + newbank*0x1000, 0x1000);
+		MEMORY_dCopyToMem(mosaic_ram + newbank*0x1000, 0xc000, 0x1000);
 		MEMORY_SetRAM(0xc000, 0xcfff);
 	}
 	mosaic_curbank = newbank;
@@ -988,7 +1058,7 @@ static void AxlonPutByte(UWORD addr, UBYTE byte)
 {
 	int newbank;
 	/*Write-through to RAM if it is the page 0x0f shadow*/
-	if ((addr&0xff00) == 0x0f00) MEMORY_mem[addr] = byte;
+	if ((addr&0xff00) == 0x0f00) MEMORY_dPutByte(addr, byte);
 	if ((addr&0xff) < 0xc0) return; /*0xffc0-0xffff and 0x0fc0-0x0fff only*/
 #ifdef DEBUG
 	Log_print("AxlonPutByte:%4X:%2X", addr, byte);
@@ -996,7 +1066,7 @@ static void AxlonPutByte(UWORD addr, UBYTE byte)
 	newbank = (byte&axlon_current_bankmask);
 	if (newbank == axlon_curbank) return;
 	memcpy(axlon_ram + axlon_curbank*0x4000, MEMORY_mem + 0x4000, 0x4000);
-	memcpy(MEMORY_mem + 0x4000, axlon_ram + newbank*0x4000, 0x4000);
+	MEMORY_dCopyToMem(axlon_ram + newbank*0x4000, 0x4000, 0x4000);
 	axlon_curbank = newbank;
 }
 
@@ -1011,6 +1081,7 @@ static UBYTE AxlonGetByte(UWORD addr, int no_side_effects)
 void MEMORY_Cart809fDisable(void)
 {
 	if (cart809F_enabled) {
+		MEMORY_TouchAll();
 		if (MEMORY_ram_size > 32) {
 			memcpy(MEMORY_mem + 0x8000, under_cart809F, 0x2000);
 			MEMORY_SetRAM(0x8000, 0x9fff);
@@ -1038,6 +1109,7 @@ void MEMORY_CartA0bfDisable(void)
 		/* No BASIC if not XL/XE or bit 1 of PORTB set */
 		/* or accessing extended 576K or 1088K memory */
 		UBYTE const *builtin = builtin_cart(PIA_PORTB | PIA_PORTB_mask);
+		MEMORY_TouchAll();
 		if (builtin == NULL) { /* switch RAM in */
 			if (MEMORY_ram_size > 40) {
 				memcpy(MEMORY_mem + 0xa000, under_cartA0BF, 0x2000);
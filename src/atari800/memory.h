@@ -6,18 +6,56 @@
 
 #include "atari.h"
 
-#define MEMORY_dGetByte(x)				(MEMORY_mem[x])
+//extern UBYTE MEMORY_mem[65536 + 2];
+extern UBYTE* MEMORY_mem;
+
+#ifdef PAGE_GENERATIONS
+/* Write generation of each 256 byte page. Every store stamps its page with
+   MEMORY_write_gen. A consumer takes MEMORY_Checkpoint() when it samples memory;
+   a page written after that has a generation >= the checkpoint, compared with
+   MEMORY_GenNewer so the counter may wrap. Bulk changes
+   (banking, carts, state loads) stamp MEMORY_all_gen instead of every page. */
+extern ULONG MEMORY_page_gen[256];
+extern ULONG MEMORY_write_gen;
+extern ULONG MEMORY_all_gen;
+
+#define MEMORY_TouchPage(addr)			(MEMORY_page_gen[((addr) >> 8) & 0xff] = MEMORY_write_gen)
+#define MEMORY_TouchWord(addr)			(MEMORY_TouchPage(addr), MEMORY_TouchPage((addr) + 1))
+void MEMORY_TouchRange(UWORD addr, int size);
+void MEMORY_TouchAll(void);
+ULONG MEMORY_Checkpoint(void);
+/* newest generation of any page in the range */
+ULONG MEMORY_RangeGen(UWORD addr, int size);
+/* TRUE if generation a is newer than b, across a wrap of MEMORY_write_gen */
+#define MEMORY_GenNewer(a, b)			((SLONG) ((a) - (b)) > 0)
+/* TRUE if any page in the range was written since the checkpoint */
+#define MEMORY_RangeDirty(addr, size, since)	((SLONG) (MEMORY_RangeGen(addr, size) - (since)) >= 0)
+
+static inline void MEMORY_dPutByteGen(int addr, UBYTE byte)
+{
+	MEMORY_TouchPage(addr);
+	MEMORY_mem[addr] = byte;
+}
+#define MEMORY_dPutByte(x, y)			MEMORY_dPutByteGen(x, y)
+#else
+#define MEMORY_TouchPage(addr)			((void) 0)
+#define MEMORY_TouchWord(addr)			((void) 0)
+#define MEMORY_TouchRange(addr, size)	((void) 0)
+#define MEMORY_TouchAll()				((void) 0)
 #define MEMORY_dPutByte(x, y)			(MEMORY_mem[x] = y)
+#endif /* PAGE_GENERATIONS */
+
+#define MEMORY_dGetByte(x)				(MEMORY_mem[x])
 
 #ifndef WORDS_BIGENDIAN
 #ifdef WORDS_UNALIGNED_OK
 #define MEMORY_dGetWord(x)				UNALIGNED_GET_WORD(MEMORY_mem+(x), memory_read_word_stat)
-#define MEMORY_dPutWord(x, y)			UNALIGNED_PUT_WORD(MEMORY_mem+(x), (y), memory_write_word_stat)
+#define MEMORY_dPutWord(x, y)			(MEMORY_TouchWord(x), UNALIGNED_PUT_WORD(MEMORY_mem+(x), (y), memory_write_word_stat))
 #define MEMORY_dGetWordAligned(x)		UNALIGNED_GET_WORD(MEMORY_mem+(x), memory_read_aligned_word_stat)
-#define MEMORY_dPutWordAligned(x, y)	UNALIGNED_PUT_WORD(MEMORY_mem+(x), (y), memory_write_aligned_word_stat)
+#define MEMORY_dPutWordAligned(x, y)	(MEMORY_TouchWord(x), UNALIGNED_PUT_WORD(MEMORY_mem+(x), (y), memory_write_aligned_word_stat))
 #else	/* WORDS_UNALIGNED_OK */
 #define MEMORY_dGetWord(x)				(MEMORY_mem[x] + (MEMORY_mem[(x) + 1] << 8))
-#define MEMORY_dPutWord(x, y)			(MEMORY_mem[x] = (UBYTE) (y), MEMORY_mem[(x) + 1] = (UBYTE) ((y) >> 8))
+#define MEMORY_dPutWord(x, y)			(MEMORY_TouchWord(x), MEMORY_mem[x] = (UBYTE) (y), MEMORY_mem[(x) + 1] = (UBYTE) ((y) >> 8))
 /* faster versions of MEMORY_jdGetWord and MEMORY_dPutWord for even addresses */
 /* TODO: guarantee that memory is UWORD-aligned and use UWORD access */
 #define MEMORY_dGetWordAligned(x)		MEMORY_dGetWord(x)
@@ -26,17 +64,14 @@
 #else	/* WORDS_BIGENDIAN */
 /* can't do any word optimizations for big endian machines */
 #define MEMORY_dGetWord(x)				(MEMORY_mem[x] + (MEMORY_mem[(x) + 1] << 8))
-#define MEMORY_dPutWord(x, y)			(MEMORY_mem[x] = (UBYTE) (y), MEMORY_mem[(x) + 1] = (UBYTE) ((y) >> 8))
+#define MEMORY_dPutWord(x, y)			(MEMORY_TouchWord(x), MEMORY_mem[x] = (UBYTE) (y), MEMORY_mem[(x) + 1] = (UBYTE) ((y) >> 8))
 #define MEMORY_dGetWordAligned(x)		MEMORY_dGetWord(x)
 #define MEMORY_dPutWordAligned(x, y)	MEMORY_dPutWord(x, y)
 #endif	/* WORDS_BIGENDIAN */
 
 #define MEMORY_dCopyFromMem(from, to, size)	memcpy(to, MEMORY_mem + (from), size)
-#define MEMORY_dCopyToMem(from, to, size)		memcpy(MEMORY_mem + (to), from, size)
-#define MEMORY_dFillMem(addr1, value, length)	memset(MEMORY_mem + (addr1), value, length)
-
-//extern UBYTE MEMORY_mem[65536 + 2];
-extern UBYTE* MEMORY_mem;
+#define MEMORY_dCopyToMem(from, to, size)		(MEMORY_TouchRange(to, size), memcpy(MEMORY_mem + (to), from, size))
+#define MEMORY_dFillMem(addr1, value, length)	(MEMORY_TouchRange(addr1, length), memset(MEMORY_mem + (addr1), value, length))
 
 /* RAM size in kilobytes.
    Valid values for Atari800_MACHINE_800 are: 16, 48, 52.
@@ -59,7 +94,7 @@ extern UBYTE MEMORY_attrib[65536];
 #define MEMORY_GetByte(addr)		(MEMORY_attrib[addr] == MEMORY_HARDWARE ? MEMORY_HwGetByte(addr, FALSE) : MEMORY_mem[addr])
 /* Reads a byte from ADDR, but without any side effects. */
 #define MEMORY_SafeGetByte(addr)		(MEMORY_attrib[addr] == MEMORY_HARDWARE ? MEMORY_HwGetByte(addr, TRUE) : MEMORY_mem[addr])
-#define MEMORY_PutByte(addr, byte)	 do { if (MEMORY_attrib[addr] == MEMORY_RAM) MEMORY_mem[addr] = byte; else if (MEMORY_attrib[addr] == MEMORY_HARDWARE) MEMORY_HwPutByte(addr, byte); } while (0)
+#define MEMORY_PutByte(addr, byte)	 do { if (MEMORY_attrib[addr] == MEMORY_RAM) MEMORY_dPutByte(addr, byte); else if (MEMORY_attrib[addr] == MEMORY_HARDWARE) MEMORY_HwPutByte(addr, byte); } while (0)
 #define MEMORY_SetRAM(addr1, addr2) memset(MEMORY_attrib + (addr1), MEMORY_RAM, (addr2) - (addr1) + 1)
 #define MEMORY_SetROM(addr1, addr2) memset(MEMORY_attrib + (addr1), MEMORY_ROM, (addr2) - (addr1) + 1)
 #define MEMORY_SetHARDWARE(addr1, addr2) memset(MEMORY_attrib + (addr1), MEMORY_HARDWARE, (addr2) - (addr1) + 1)
@@ -77,7 +112,7 @@ void MEMORY_ROM_PutByte(UWORD addr, UBYTE byte);
 #define MEMORY_GetByte(addr)		(MEMORY_readmap[(addr) >> 8] ? (*MEMORY_readmap[(addr) >> 8])(addr, FALSE) : MEMORY_mem[addr])
 /* Reads a byte from ADDR, but without any side effects. */
 #define MEMORY_SafeGetByte(addr)		(MEMORY_readmap[(addr) >> 8] ? (*MEMORY_readmap[(addr) >> 8])(addr, TRUE) : MEMORY_mem[addr])
-#define MEMORY_PutByte(addr,byte)	(MEMORY_writemap[(addr) >> 8] ? ((*MEMORY_writemap[(addr) >> 8])(addr, byte), 0) : (MEMORY_mem[addr] = byte))
+#define MEMORY_PutByte(addr,byte)	(MEMORY_writemap[(addr) >> 8] ? ((*MEMORY_writemap[(addr) >> 8])(addr, byte), 0) : (MEMORY_TouchPage(addr), MEMORY_mem[addr] = byte))
 #define MEMORY_SetRAM(addr1, addr2) do { \
 		int i; \
 		for (i = (addr1) >> 8; i <= (addr2) >> 8; i++) { \
@@ -125,7 +160,7 @@ void MEMORY_Cart809fDisable(void);
 void MEMORY_Cart809fEnable(void);
 void MEMORY_CartA0bfDisable(void);
 void MEMORY_CartA0bfEnable(void);
-#define MEMORY_CopyROM(addr1, addr2, src) memcpy(MEMORY_mem + (addr1), src, (addr2) - (addr1) + 1)
+#define MEMORY_CopyROM(addr1, addr2, src) (MEMORY_TouchRange(addr1, (addr2) - (addr1) + 1), memcpy(MEMORY_mem + (addr1), src, (addr2) - (addr1) + 1))
 void MEMORY_GetCharset(UBYTE *cs);
 
 /* Mosaic and Axlon 400/800 RAM extensions */
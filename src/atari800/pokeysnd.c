@@ -24,6 +24,7 @@
 
 #include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifdef ASAP /* external project, see http://asap.sf.net */
@@ -723,6 +724,13 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 }
 
 
+#if defined(POKEYSND_BLOCK) && !defined(STEREO_SOUND) && !defined(INTERPOLATE_SOUND) \
+ && !defined(SYNCHRONIZED_SOUND) && !defined(WORDS_BIGENDIAN) && !defined(__PLUS)
+#define BLOCK_SYNTH
+#endif
+
+#ifndef BLOCK_SYNTH
+
 /*****************************************************************************/
 /* Module:  pokeysnd_process()                                                  */
 /* Purpose: To fill the output buffer with the sound output based on the     */
@@ -1238,6 +1246,277 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 #endif  /* VOL_ONLY_SOUND */
 }
 
+#else /* BLOCK_SYNTH */
+
+/*****************************************************************************/
+/* Block synthesis: the event loop above visits every divider event of every */
+/* channel in time order.  AUDC and AUDCTL cannot change while a buffer is   */
+/* rendered, so a channel's output at a sample point only depends on its own */
+/* events (plus channel 3/4 events when a high pass filter is on).  Each     */
+/* channel is therefore advanced straight from one sample point to the next  */
+/* for a block of samples, and the channels are mixed afterwards.  Sample    */
+/* timing, polynomial positions and counters end up exactly as with the     */
+/* event loop, so the output is identical.                                   */
+/*****************************************************************************/
+
+#define BLOCK_SAMPLES 64
+
+static ULONG block_time[BLOCK_SAMPLES];	/* sample points, ticks since the buffer start */
+static UBYTE block_out[4 * POKEY_MAXPOKEYS][BLOCK_SAMPLES];	/* channel output at each sample */
+static ULONG block_last;		/* tick of the last divider event */
+
+/* poly4/9/17 output of a channel clocked at tick t */
+static UBYTE block_poly_bit(int chan, UBYTE audc, ULONG t)
+{
+	if (audc & POKEY_POLY4)
+		return bit4[(P4 + t) % POKEY_POLY4_SIZE];
+	if (POKEY_AUDCTL[chan >> 2] & POKEY_POLY9)
+		return POKEY_poly9_lookup[(P9 + t) % POKEY_POLY9_SIZE] & 1;
+	t = (P17 + t) % POKEY_POLY17_SIZE;
+	return (POKEY_poly17_lookup[t >> 3] >> (t & 7)) & 1;
+}
+
+/* output of a channel after a single divider event at tick t */
+static UBYTE block_event(int chan, UBYTE audc, ULONG t, UBYTE out)
+{
+	if (audc & POKEY_VOL_ONLY)
+		return out;
+	if (!(audc & POKEY_NOTPOLY5) && !bit5[(P5 + t) % POKEY_POLY5_SIZE])
+		return out;
+	if (audc & POKEY_PURETONE)
+		return !out;
+	return block_poly_bit(chan, audc, t);
+}
+
+/* output of a channel after m (> 0) divider events at t, t + d, t + 2d... */
+static UBYTE block_events(int chan, UBYTE audc, ULONG t, ULONG d, ULONG m, UBYTE out)
+{
+	ULONG p, step;
+
+	if (audc & POKEY_VOL_ONLY)
+		return out;
+	if (audc & POKEY_NOTPOLY5) {
+		if (audc & POKEY_PURETONE)
+			return out ^ (m & 1);
+		return block_poly_bit(chan, audc, t + (m - 1) * d);
+	}
+
+	step = d % POKEY_POLY5_SIZE;
+	if (audc & POKEY_PURETONE) {
+		/* one toggle for every event the poly5 lets through */
+		p = (P5 + t) % POKEY_POLY5_SIZE;
+		while (m--) {
+			out ^= bit5[p];
+			p += step;
+			if (p >= POKEY_POLY5_SIZE)
+				p -= POKEY_POLY5_SIZE;
+		}
+		return out;
+	}
+
+	/* the poly bit of the last event the poly5 lets through; the poly5
+	   position repeats every 31 events so there is no point looking further */
+	t += (m - 1) * d;
+	p = (P5 + t) % POKEY_POLY5_SIZE;
+	if (m > POKEY_POLY5_SIZE)
+		m = POKEY_POLY5_SIZE;
+	while (m--) {
+		if (bit5[p])
+			return block_poly_bit(chan, audc, t);
+		t -= d;
+		p = (p >= step) ? p - step : p + POKEY_POLY5_SIZE - step;
+	}
+	return out;
+}
+
+/* fill block_out for a channel that no other channel affects */
+static void block_channel(int chan, int n)
+{
+	UBYTE audc = POKEY_AUDC[chan];
+	UBYTE out = Outvol[chan];
+	ULONG next = Div_n_cnt[chan];
+	ULONG d = Div_n_max[chan];
+	UBYTE *dst = block_out[chan];
+	int i;
+
+	if (next > block_time[n - 1]) {
+		/* nothing happens on this channel during the block */
+		memset(dst, out, n);
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		if (next <= block_time[i]) {
+			ULONG m = (block_time[i] - next) / d + 1;
+			out = block_events(chan, audc, next, d, m, out);
+			next += m * d;
+			if (next - d > block_last)
+				block_last = next - d;
+		}
+		dst[i] = out;
+	}
+	Outvol[chan] = out;
+	Div_n_cnt[chan] = next;
+}
+
+/* fill block_out for channel 1 or 2 and the channel 3 or 4 high pass
+   filtering it.  The events are merged in the order the event loop would
+   take them: on a tie the higher channel goes first. */
+static void block_filter_pair(int lo, int n)
+{
+	int hi = lo + 2;
+	UBYTE audc_lo = POKEY_AUDC[lo], audc_hi = POKEY_AUDC[hi];
+	UBYTE out_lo = Outvol[lo], out_hi = Outvol[hi];
+	ULONG next_lo = Div_n_cnt[lo], next_hi = Div_n_cnt[hi];
+	int i;
+
+	for (i = 0; i < n; i++) {
+		ULONG t = block_time[i];
+		for (;;) {
+			ULONG event;
+			if (next_hi <= next_lo) {
+				if (next_hi > t)
+					break;
+				event = next_hi;
+				out_hi = block_event(hi, audc_hi, event, out_hi);
+				out_lo = 0;
+				next_hi += Div_n_max[hi];
+			}
+			else {
+				if (next_lo > t)
+					break;
+				event = next_lo;
+				out_lo = block_event(lo, audc_lo, event, out_lo);
+				next_lo += Div_n_max[lo];
+			}
+			if (event > block_last)
+				block_last = event;
+		}
+		block_out[lo][i] = out_lo;
+		block_out[hi][i] = out_hi;
+	}
+	Outvol[lo] = out_lo;
+	Outvol[hi] = out_hi;
+	Div_n_cnt[lo] = next_lo;
+	Div_n_cnt[hi] = next_hi;
+}
+
+static void pokeysnd_process_8(void *sndbuffer, int sndn)
+{
+	UBYTE *buffer = (UBYTE *) sndbuffer;
+	int nchan = Num_pokeys << 2;
+	ULONG samp = Samp_n_cnt[0];	/* 24.8 sample point */
+	int chan;
+	int i;
+	int n;
+
+	block_last = 0;
+	while (sndn > 0) {
+		n = (sndn < BLOCK_SAMPLES) ? sndn : BLOCK_SAMPLES;
+		for (i = 0; i < n; i++) {
+			block_time[i] = samp >> 8;
+			samp += Samp_n_max;
+		}
+
+		for (chan = 0; chan < nchan; chan++) {
+			UBYTE audctl = POKEY_AUDCTL[chan >> 2];
+			switch (chan & 0x03) {
+			case POKEY_CHAN1:
+				if (audctl & POKEY_CH1_FILTER) {
+					block_filter_pair(chan, n);
+					continue;
+				}
+				break;
+			case POKEY_CHAN2:
+				if (audctl & POKEY_CH2_FILTER) {
+					block_filter_pair(chan, n);
+					continue;
+				}
+				break;
+			case POKEY_CHAN3:
+				if (audctl & POKEY_CH1_FILTER)
+					continue;
+				break;
+			case POKEY_CHAN4:
+				if (audctl & POKEY_CH2_FILTER)
+					continue;
+				break;
+			}
+			block_channel(chan, n);
+		}
+
+		for (i = 0; i < n; i++) {
+#ifdef CLIP_SOUND
+			SWORD cur_val = POKEYSND_SAMP_MIN;
+#else
+			UBYTE cur_val = POKEYSND_SAMP_MIN;	/* wraps the same way as the event loop */
+#endif
+			int iout;
+
+			for (chan = 0; chan < nchan; chan++)
+				if (block_out[chan][i])
+					cur_val += pokeysnd_AUDV[chan];
+			iout = cur_val;
+
+#ifdef VOL_ONLY_SOUND
+			if (POKEYSND_sampbuf_rptr != POKEYSND_sampbuf_ptr) {
+				int l;
+				if (POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr] > 0)
+					POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr] -= 1280;
+				while ((l = POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]) <= 0) {
+					POKEYSND_sampout = POKEYSND_sampbuf_val[POKEYSND_sampbuf_rptr];
+					POKEYSND_sampbuf_rptr++;
+					if (POKEYSND_sampbuf_rptr >= POKEYSND_SAMPBUF_MAX)
+						POKEYSND_sampbuf_rptr = 0;
+					if (POKEYSND_sampbuf_rptr != POKEYSND_sampbuf_ptr)
+						POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr] += l;
+					else
+						break;
+				}
+			}
+			iout += POKEYSND_sampout;
+#endif  /* VOL_ONLY_SOUND */
+
+#ifdef CLIP_SOUND
+			if (iout > POKEYSND_SAMP_MAX)
+				*buffer++ = (UBYTE) POKEYSND_SAMP_MAX;
+			else if (iout < POKEYSND_SAMP_MIN)
+				*buffer++ = (UBYTE) POKEYSND_SAMP_MIN;
+			else
+				*buffer++ = (UBYTE) iout;
+#else /* CLIP_SOUND */
+			{
+				/* same dc blocking high pass as the event loop */
+				static int _lp = 0;
+				int s;
+				iout >>= 1;
+				_lp = (((_lp+iout) << 8) - _lp) >> 8;
+				s = iout - (_lp >> 8) + 128;
+				if (s < 0) s = 0;
+				if (s > 255) s = 255;
+				*buffer++ = s;
+			}
+#endif /* CLIP_SOUND */
+		}
+		sndn -= n;
+	}
+
+	/* rebase everything on the last divider event, as the event loop does */
+	for (chan = 0; chan < nchan; chan++)
+		Div_n_cnt[chan] -= block_last;
+	Samp_n_cnt[0] = samp - (block_last << 8);
+	P4 = (P4 + block_last) % POKEY_POLY4_SIZE;
+	P5 = (P5 + block_last) % POKEY_POLY5_SIZE;
+	P9 = (P9 + block_last) % POKEY_POLY9_SIZE;
+	P17 = (P17 + block_last) % POKEY_POLY17_SIZE;
+
+#ifdef VOL_ONLY_SOUND
+	if (POKEYSND_sampbuf_rptr == POKEYSND_sampbuf_ptr)
+		POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK;
+#endif  /* VOL_ONLY_SOUND */
+}
+
+#endif /* BLOCK_SYNTH */
+
 #ifdef SERIO_SOUND
 static void Update_serio_sound_rf(int out, UBYTE data)
 {
@@ -355,6 +355,8 @@ static void SmallFont_DrawChar(UBYTE *screen, int ch, UBYTE color1, UBYTE color2
 		}
 	};
 	int y;
+	/* ANTIC redraws these rows next frame, which is what erases the char */
+	ANTIC_InvalidateRows((int) ((screen - (UBYTE *) Screen_atari) / Screen_WIDTH), SMALLFONT_HEIGHT);
 	for (y = 0; y < SMALLFONT_HEIGHT; y++) {
 		int src;
 		int mask;
@@ -45,6 +45,7 @@
 #include "pokeysnd.h"
 #include "sio.h"
 #include "util.h"
+#include "../perf_counters.h"
 #ifndef BASIC
 #include "statesav.h"
 #endif
@@ -95,16 +96,26 @@ typedef struct tagpro_additional_info_t {
 #define VAPI_CYCLES_MISSING_SECTOR	(2*VAPI_CYCLES_PER_ROT + 14453)
 #define VAPI_CYCLES_BAD_SECTOR_NUM	1521
 
-/* stores dup sector information for VAPI images */
+/* stores dup sector information for VAPI images: every copy of a sector
+   recorded on its track, phantoms included, kept together per sector */
+#define VAPI_NO_WEAK				0xffff
+
+typedef struct tagvapi_sec_copy_t {
+	unsigned int offset;
+	unsigned int rot_pos;
+	unsigned short weak;	/* first weak byte or VAPI_NO_WEAK */
+	unsigned short sector;	/* only used while loading */
+	unsigned char status;
+} vapi_sec_copy_t;
+
 typedef struct tagvapi_sec_info_t {
 	int sec_count;
-	unsigned int sec_offset[MAX_VAPI_PHANTOM_SEC];
-	unsigned char sec_status[MAX_VAPI_PHANTOM_SEC];
-	unsigned int sec_rot_pos[MAX_VAPI_PHANTOM_SEC];
+	vapi_sec_copy_t *copy;
 } vapi_sec_info_t;
 
 typedef struct tagvapi_additional_info_t {
 	vapi_sec_info_t *sectors;
+	vapi_sec_copy_t *copies;
 	int sec_stat_buff[4];
 	int vapi_delay_time;
 } vapi_additional_info_t;
@@ -144,6 +155,16 @@ typedef struct tagvapi_sector_header_t {
 	unsigned char  startdata[4];
 } vapi_sector_header_t;
 
+/* Chunks following the sector list of a track */
+#define VAPI_CHUNK_WEAK 0x10
+
+typedef struct tagvapi_chunk_header_t {
+	unsigned char  size[4];
+	unsigned char  type;
+	unsigned char  num;		/* index in the sector list */
+	unsigned char  data[2];	/* weak: offset of the first weak byte */
+} vapi_chunk_header_t;
+
 #define VAPI_32(x) (x[0] + (x[1] << 8) + (x[2] << 16) + (x[3] << 24))
 #define VAPI_16(x) (x[0] + (x[1] << 8))
 
@@ -200,6 +221,95 @@ void SIO_Exit(void)
 		SIO_Dismount(i);
 }
 
+#ifdef SIO_SECTOR_CACHE
+/* Loaders mostly read sector after sector, and every fseek/fread on SPIFFS
+   or SD is slow. Sectors are therefore read in runs of up to a line and
+   kept in a small LRU cache. Writes go through to the image and update the
+   cached copy. Only the fixed size sectors of ATR and XFD images past the
+   boot sectors are cached; they are contiguous in the file. */
+#define SECTOR_CACHE_LINE 1024
+
+typedef struct {
+	int unit;
+	int first;		/* first sector in the line */
+	int count;		/* 0 if the line is free */
+	ULONG used;		/* for LRU replacement */
+	UBYTE *data;
+} sector_cache_line_t;
+
+static sector_cache_line_t sector_cache[SIO_SECTOR_CACHE];
+static ULONG sector_cache_used = 0;
+
+static int SectorCacheable(int unit, int sector)
+{
+	return sector >= 4 && sectorsize[unit] <= SECTOR_CACHE_LINE
+		&& (image_type[unit] == IMAGE_TYPE_ATR || image_type[unit] == IMAGE_TYPE_XFD);
+}
+
+static void SectorCacheFlush(int unit)
+{
+	int i;
+	for (i = 0; i < SIO_SECTOR_CACHE; i++)
+		if (sector_cache[i].unit == unit)
+			sector_cache[i].count = 0;
+}
+
+static UBYTE *SectorCacheFind(int unit, int sector)
+{
+	int i;
+	for (i = 0; i < SIO_SECTOR_CACHE; i++) {
+		sector_cache_line_t *line = &sector_cache[i];
+		if (line->count != 0 && line->unit == unit
+			&& sector >= line->first && sector < line->first + line->count) {
+			line->used = ++sector_cache_used;
+			return line->data + (sector - line->first) * sectorsize[unit];
+		}
+	}
+	return NULL;
+}
+
+static UBYTE *SectorCacheFill(int unit, int sector)
+{
+	sector_cache_line_t *line = &sector_cache[0];
+	int size = sectorsize[unit];
+	int count = SECTOR_CACHE_LINE / size;
+	ULONG offset;
+	int i;
+
+	for (i = 1; i < SIO_SECTOR_CACHE && line->count != 0; i++)
+		if (sector_cache[i].count == 0 || sector_cache[i].used < line->used)
+			line = &sector_cache[i];
+	if (line->data == NULL) {
+		/* no cache if memory is short, the image is read directly instead */
+		line->data = (UBYTE *) malloc(SECTOR_CACHE_LINE);
+		if (line->data == NULL)
+			return NULL;
+	}
+
+	if (count > sectorcount[unit] - sector + 1)
+		count = sectorcount[unit] - sector + 1;
+	SIO_SizeOfSector((UBYTE) unit, sector, NULL, &offset);
+	PERF_BEGIN(PERF_IO);
+	fseek(disk[unit], offset, SEEK_SET);
+	/* a short last sector is left to the uncached path */
+	count = (int) fread(line->data, size, count, disk[unit]);
+	PERF_END();
+
+	line->unit = unit;
+	line->first = sector;
+	line->count = count;
+	line->used = ++sector_cache_used;
+	return count != 0 ? line->data : NULL;
+}
+#endif /* SIO_SECTOR_CACHE */
+
+static void VapiFree(vapi_additional_info_t *info)
+{
+	free(info->sectors);
+	free(info->copies);
+	free(info);
+}
+
 int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 {
 	FILE *f = NULL;
@@ -334,7 +444,7 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		vapi_additional_info_t *info;
 		vapi_file_header_t fileheader;
 		vapi_track_header_t trackheader;
-		int trackoffset, totalsectors;
+		int trackoffset, totalsectors, totalcopies;
 
 		/* .atx is read only for now */
 #ifndef VAPI_WRITE_ENABLE
@@ -379,6 +489,8 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 				}
 			next = VAPI_32(trackheader.next);
 			tracktype = VAPI_16(trackheader.type);
+			if (next == 0)
+				break;
 			if (tracktype == 0) {
 				totalsectors += VAPI_16(trackheader.sectorcnt);
 				}
@@ -391,6 +503,9 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
  					    sizeof(vapi_sec_info_t));
 		memset(info->sectors, 0, sectorcount[diskno - 1] * 
  					 sizeof(vapi_sec_info_t));
+		/* copies in file order for now, grouped by sector below */
+		info->copies = (vapi_sec_copy_t *)Util_malloc((totalsectors + 1) * sizeof(vapi_sec_copy_t));
+		totalcopies = 0;
 
 		/* Now read all the sector data */
 		trackoffset = VAPI_32(fileheader.startdata);
@@ -398,14 +513,15 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 			int sectorcnt, seclistdata,next;
 			vapi_sector_list_header_t sectorlist;
 			vapi_sector_header_t sectorheader;
-			vapi_sec_info_t *sector;
+			vapi_chunk_header_t chunk;
+			vapi_sec_copy_t *copy;
 			UWORD tracktype;
+			int trackcopies, chunkoffset;
 			int j;
 
 			fseek(f,trackoffset,SEEK_SET);
 			if (fread(&trackheader,1,sizeof(trackheader),f) != sizeof(trackheader)) {
-				free(info->sectors);
-				free(info);
+				VapiFree(info);
 				Util_fclose(f, sio_tmpbuf[diskno - 1]);
 				Log_print("VAPI: Bad Track Header while reading sectors");
 				return(FALSE);
@@ -418,18 +534,18 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 			Log_print("Track %d: next %x type %d seccnt %d secdata %x",trackheader.tracknum,
 				trackoffset + next,VAPI_16(trackheader.type),sectorcnt,seclistdata);
 #endif
+			if (next <= 0)
+				break;
 			if (tracktype == 0) {
 				if (seclistdata > file_length) {
-					free(info->sectors);
-					free(info);
+					VapiFree(info);
 					Util_fclose(f, sio_tmpbuf[diskno - 1]);
 					Log_print("VAPI: Bad Sector List Offset");
 					return(FALSE);
 					}
 				fseek(f,seclistdata,SEEK_SET);
 				if (fread(&sectorlist,1,sizeof(sectorlist),f) != sizeof(sectorlist)) {
-					free(info->sectors);
-					free(info);
+					VapiFree(info);
 					Util_fclose(f, sio_tmpbuf[diskno - 1]);
 					Log_print("VAPI: Bad Sector List");
 					return(FALSE);
@@ -437,44 +553,65 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 #ifdef DEBUG_VAPI
 				Log_print("Size sec list %x type %d",VAPI_32(sectorlist.sizelist),sectorlist.type);
 #endif
+				trackcopies = totalcopies;
 				for (j=0;j<sectorcnt;j++) {
 					double percent_rot;
+					vapi_sec_info_t *sector;
 
 					if (fread(&sectorheader,1,sizeof(sectorheader),f) != sizeof(sectorheader)) {
-						free(info->sectors);
-						free(info);
+						VapiFree(info);
 						Util_fclose(f, sio_tmpbuf[diskno - 1]);
 						Log_print("VAPI: Bad Sector Header");
 						return(FALSE);
 						}
-					if (sectorheader.sectornum > 18)  {
+					if (sectorheader.sectornum == 0 || sectorheader.sectornum > 18 || trackheader.tracknum >= 40
+						|| totalcopies >= totalsectors)  {
+						VapiFree(info);
 						Util_fclose(f, sio_tmpbuf[diskno - 1]);
 						Log_print("VAPI: Bad Sector Index: Track %d Sec Num %d Index %d",
 								trackheader.tracknum,j,sectorheader.sectornum);
 						return(FALSE);
 						}
 					sector = &info->sectors[trackheader.tracknum * 18 + sectorheader.sectornum - 1];
+					copy = &info->copies[totalcopies++];
 
 					percent_rot = ((double) VAPI_16(sectorheader.sectorpos))/VAPI_BYTES_PER_TRACK;
-					sector->sec_rot_pos[sector->sec_count] = (unsigned int) (percent_rot * VAPI_CYCLES_PER_ROT);
-					sector->sec_offset[sector->sec_count] = VAPI_32(sectorheader.startdata) + trackoffset;
-					sector->sec_status[sector->sec_count] = ~sectorheader.sectorstatus;
+					copy->rot_pos = (unsigned int) (percent_rot * VAPI_CYCLES_PER_ROT);
+					copy->offset = VAPI_32(sectorheader.startdata) + trackoffset;
+					copy->status = ~sectorheader.sectorstatus;
+					copy->weak = VAPI_NO_WEAK;
+					copy->sector = trackheader.tracknum * 18 + sectorheader.sectornum - 1;
 					sector->sec_count++;
 					if (sector->sec_count > MAX_VAPI_PHANTOM_SEC) {
-						free(info->sectors);
-						free(info);
+						VapiFree(info);
 						Util_fclose(f, sio_tmpbuf[diskno - 1]);
 						Log_print("VAPI: Too many Phantom Sectors");
 						return(FALSE);
 						}
 #ifdef DEBUG_VAPI
 					Log_print("Sector %d status %x position %f %d %d data %x",sectorheader.sectornum,
-						sector->sec_status[sector->sec_count-1],percent_rot,
-						sector->sec_rot_pos[sector->sec_count-1],
+						copy->status,percent_rot,
+						copy->rot_pos,
 						VAPI_16(sectorheader.sectorpos),
-						sector->sec_offset[sector->sec_count-1]);				
+						copy->offset);				
 #endif				
 				}
+
+				/* Weak sectors read back differently every time from the
+				   given offset on; they are marked by chunks after the list */
+				chunkoffset = seclistdata + VAPI_32(sectorlist.sizelist);
+				while (chunkoffset + (int) sizeof(chunk) <= trackoffset + next) {
+					int chunksize;
+					fseek(f,chunkoffset,SEEK_SET);
+					if (fread(&chunk,1,sizeof(chunk),f) != sizeof(chunk))
+						break;
+					chunksize = VAPI_32(chunk.size);
+					if (chunksize <= 0)
+						break;
+					if (chunk.type == VAPI_CHUNK_WEAK && trackcopies + chunk.num < totalcopies)
+						info->copies[trackcopies + chunk.num].weak = VAPI_16(chunk.data);
+					chunkoffset += chunksize;
+				}
 #ifdef DEBUG_VAPI
 				Log_flushlog();
 #endif
@@ -483,6 +620,25 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 			}
 			trackoffset += next;
 		}			
+
+		/* Group the copies by sector, keeping their order on the track,
+		   so a read finds all copies of a sector directly */
+		{
+			vapi_sec_copy_t *copies = info->copies;
+			int i, pos = 0;
+
+			info->copies = (vapi_sec_copy_t *)Util_malloc((totalcopies + 1) * sizeof(vapi_sec_copy_t));
+			for (i = 0; i < sectorcount[diskno - 1]; i++) {
+				info->sectors[i].copy = info->copies + pos;
+				pos += info->sectors[i].sec_count;
+				info->sectors[i].sec_count = 0;
+			}
+			for (i = 0; i < totalcopies; i++) {
+				vapi_sec_info_t *sector = &info->sectors[copies[i].sector];
+				sector->copy[sector->sec_count++] = copies[i];
+			}
+			free(copies);
+		}
 	}
 	else {
 		int file_length = Util_flen(f);
@@ -554,6 +710,9 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 void SIO_Dismount(int diskno)
 {
 	if (disk[diskno - 1] != NULL) {
+#ifdef SIO_SECTOR_CACHE
+		SectorCacheFlush(diskno - 1);
+#endif
 		Util_fclose(disk[diskno - 1], sio_tmpbuf[diskno - 1]);
 		disk[diskno - 1] = NULL;
 		SIO_drive_status[diskno - 1] = SIO_NO_DISK;
@@ -562,7 +721,9 @@ void SIO_Dismount(int diskno)
 			free(((pro_additional_info_t *)additional_info[diskno-1])->count);
 		}
 		else if (image_type[diskno - 1] == IMAGE_TYPE_VAPI) {
-			free(((vapi_additional_info_t *)additional_info[diskno-1])->sectors);
+			vapi_additional_info_t *info = (vapi_additional_info_t *)additional_info[diskno-1];
+			free(info->sectors);
+			free(info->copies);
 		}
 		free(additional_info[diskno - 1]);
 		additional_info[diskno - 1] = 0;
@@ -609,7 +770,7 @@ void SIO_SizeOfSector(UBYTE unit, int sector, int *sz, ULONG *ofs)
 			if (secinfo->sec_count == 0  )
 				offset = 0;
 			else
-				offset = secinfo->sec_offset[0];
+				offset = secinfo->copy[0].offset;
 		}
 	}
 	else if (sector < 4) {
@@ -642,6 +803,14 @@ static int SeekSector(int unit, int sector)
 	return size;
 }
 
+/* Bytes of a weak VAPI sector read back at random from the first weak one */
+static void VapiWeakBits(unsigned short weak, UBYTE *buffer, int size)
+{
+	int i;
+	for (i = weak; i < size; i++)
+		buffer[i] = rand() & 0xFF;
+}
+
 /* Unit counts from zero up */
 int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 {
@@ -659,6 +828,19 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 	SIO_last_op = SIO_LAST_READ;
 	SIO_last_op_time = 1;
 	SIO_last_drive = unit + 1;
+#ifdef SIO_SECTOR_CACHE
+	if (SectorCacheable(unit, sector)) {
+		UBYTE *cached = SectorCacheFind(unit, sector);
+		if (cached == NULL)
+			cached = SectorCacheFill(unit, sector);
+		if (cached != NULL) {
+			SIO_last_sector = sector;
+			memcpy(buffer, cached, sectorsize[unit]);
+			io_success[unit] = 0;
+			return 'C';
+		}
+	}
+#endif
 	/* FIXME: what sector size did the user expect? */
 	size = SeekSector(unit, sector);
 	if (image_type[unit] == IMAGE_TYPE_PRO) {
@@ -759,18 +941,18 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		bestdelay = 10 * VAPI_CYCLES_PER_ROT;
 /*		beststatus = 0;*/
 		for (j=0;j<secinfo->sec_count;j++) {
-			if (secinfo->sec_rot_pos[j]  < currpos)
-				delay = (VAPI_CYCLES_PER_ROT - currpos) + secinfo->sec_rot_pos[j];
+			if (secinfo->copy[j].rot_pos  < currpos)
+				delay = (VAPI_CYCLES_PER_ROT - currpos) + secinfo->copy[j].rot_pos;
 			else
-				delay = secinfo->sec_rot_pos[j] - currpos; 
+				delay = secinfo->copy[j].rot_pos - currpos; 
 #ifdef DEBUG_VAPI
-			Log_print("%d %d %d %d %d %x",j,secinfo->sec_rot_pos[j],
+			Log_print("%d %d %d %d %d %x",j,secinfo->copy[j].rot_pos,
 					  ((unsigned int) ANTIC_CPU_CLOCK) - ((((unsigned int) ANTIC_CPU_CLOCK)/VAPI_CYCLES_PER_ROT)*VAPI_CYCLES_PER_ROT),
-					  currpos,delay,secinfo->sec_status[j]);
+					  currpos,delay,secinfo->copy[j].status);
 #endif
 			if (delay < bestdelay) {
 				bestdelay = delay;
-/*				beststatus = secinfo->sec_status[j];*/
+/*				beststatus = secinfo->copy[j].status;*/
 				secindex = j;
 			}
 		}
@@ -786,23 +968,24 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		if (secinfo->sec_count > 1)
 			Log_print("duplicate sector:%d dupnum:%d delay:%d",sector, secindex,info->vapi_delay_time);
 #endif
-		fseek(disk[unit],secinfo->sec_offset[secindex],SEEK_SET);
-		info->sec_stat_buff[0] = 0x8 | ((secinfo->sec_status[secindex] == 0xFF) ? 0 : 0x04);
-		info->sec_stat_buff[1] = secinfo->sec_status[secindex];
+		fseek(disk[unit],secinfo->copy[secindex].offset,SEEK_SET);
+		info->sec_stat_buff[0] = 0x8 | ((secinfo->copy[secindex].status == 0xFF) ? 0 : 0x04);
+		info->sec_stat_buff[1] = secinfo->copy[secindex].status;
 		info->sec_stat_buff[2] = 0xe0;
 		info->sec_stat_buff[3] = 0;
-		if (secinfo->sec_status[secindex] != 0xFF) {
+		if (secinfo->copy[secindex].status != 0xFF) {
 			if (fread(buffer, 1, size, disk[unit]) < size) {
 				Log_print("error reading sector:%d", sector);
 			}
+			VapiWeakBits(secinfo->copy[secindex].weak, buffer, size);
 			io_success[unit] = sector;
 			info->vapi_delay_time += VAPI_CYCLES_PER_ROT + 10000;
 #ifdef DEBUG_VAPI
-			Log_print("bad sector:%d 0x%0X delay:%d", sector, secinfo->sec_status[secindex],info->vapi_delay_time );
+			Log_print("bad sector:%d 0x%0X delay:%d", sector, secinfo->copy[secindex].status,info->vapi_delay_time );
 #endif
 			{
 			int i;
-				if (secinfo->sec_status[secindex] == 0xB7) {
+				if (secinfo->copy[secindex].status == 0xB7) {
 					for (i=0;i<128;i++) {
 						Log_print("0x%02x",buffer[i]);
 						if (buffer[i] == 0x33)
@@ -815,6 +998,12 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 #ifdef DEBUG_VAPI
 		Log_flushlog();
 #endif		
+		if (fread(buffer, 1, size, disk[unit]) < size) {
+			Log_print("incomplete sector num:%d", sector);
+		}
+		VapiWeakBits(secinfo->copy[secindex].weak, buffer, size);
+		io_success[unit] = 0;
+		return 'C';
 	}
 	if (fread(buffer, 1, size, disk[unit]) < size) {
 		Log_print("incomplete sector num:%d", sector);
@@ -849,13 +1038,13 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 			return 'E';
 		}
 		
-		if (secinfo->sec_status[0] != 0xFF) {
+		if (secinfo->copy[0].status != 0xFF) {
 			/* No writes to bad sectors */
 			return 'E';
 		}
 		
 		size = SeekSector(unit, sector);
-		fseek(disk[unit],secinfo->sec_offset[0],SEEK_SET);
+		fseek(disk[unit],secinfo->copy[0].offset,SEEK_SET);
 		fwrite(buffer, 1, size, disk[unit]);
 		io_success[unit] = 0;
 		return 'C';
@@ -879,6 +1068,13 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 #endif
 	size = SeekSector(unit, sector);
 	fwrite(buffer, 1, size, disk[unit]);
+#ifdef SIO_SECTOR_CACHE
+	if (SectorCacheable(unit, sector)) {
+		UBYTE *cached = SectorCacheFind(unit, sector);
+		if (cached != NULL)
+			memcpy(cached, buffer, size);
+	}
+#endif
 	io_success[unit] = 0;
 	return 'C';
 }
@@ -155,6 +155,15 @@ int Util_direxists(const char *filename);
    May change the current position. */
 int Util_flen(FILE *fp);
 
+/* Gives the stream a HOST_FILE_BUFFER byte buffer, so that byte by byte
+   access only reaches the host file system once per block.
+   Must be called before the first read or write. */
+#ifdef HOST_FILE_BUFFER
+#define Util_fbuffer(fp)  setvbuf(fp, NULL, _IOFBF, HOST_FILE_BUFFER)
+#else
+#define Util_fbuffer(fp)  ((void) 0)
+#endif
+
 /* Deletes a file, returns 0 on success, -1 on failure. */
 #ifdef HAVE_WINDOWS_H
 int Util_unlink(const char *filename);
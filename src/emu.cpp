@@ -16,6 +16,8 @@
 */
 
 #include "emu.h"
+#include "trace.h"
+#include "perf_counters.h"
 using namespace std;
 
 // Map files into memory for carts bigger than physical RAM
@@ -122,11 +124,11 @@ public:
     {
         if (!file)
             return 0;
-        printf("CrapFS::mmap mapping %s offset:%08X len:%d\n",file->name,file->offset,file->len);
+        TRACE_INFO(TRACE_CRAPFS_MMAP,file->offset,file->len);
         void* data = 0;
         if (esp_partition_mmap(_part, file->offset, file->len, SPI_FLASH_MMAP_DATA, (const void**)&data, &_file_handle) == 0)
         {
-            printf("CrapFS::mmap mapped to %08X\n",data);
+            TRACE_INFO(TRACE_CRAPFS_MAPPED,file->offset,data);
             return (uint8_t*)data;
         }
         return 0;
@@ -156,7 +158,7 @@ public:
             if (n > BUF_SIZE)
                 n = BUF_SIZE;
             fread(buf,1,n,f);
-            printf("CrapFS::copy writing %d of %d\n",i,len);
+            TRACE_DEBUG(TRACE_CRAPFS_COPY,i,len);
             err = esp_partition_write(_part, i + offset, buf, n);
             if (err)
                 break;
@@ -177,7 +179,7 @@ public:
                 _dir[i].offset = start;
                 _dir[i].len = len;  //
                 strcpy(_dir[i].name,path.c_str());
-                printf("CrapFS::created %s %08X %d\n",_dir[i].name,start,len);
+                TRACE_INFO(TRACE_CRAPFS_CREATED,start,len);
                 esp_err_t err = esp_partition_erase_range(_part,0, DIR_BLOCK_SIZE);     // erase dir
                 if (err == 0)
                     err = esp_partition_write(_part, 0, _buf, DIR_BLOCK_SIZE);    // update dir
@@ -348,6 +350,7 @@ int Emu::head(const std::string& path, uint8_t* data, int len)
 
 int Emu::load(const std::string& path, uint8_t** data, int* len)
 {
+    PERF_SCOPE(PERF_IO);
     *data = 0;
     *len = 0;
     FILE *f = fopen(path.c_str(), "rb");
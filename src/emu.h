@@ -124,6 +124,7 @@ public:
 
     virtual int update() = 0;
     virtual uint8_t** video_buffer() = 0;
+    virtual void video_overdrawn() {};  // gui drew over video_buffer(), redraw all of it next update
     virtual int audio_buffer(int16_t* b, int max_len) = 0;
 
     virtual const uint32_t* ntsc_palette() { return NULL; };
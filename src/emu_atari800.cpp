@@ -18,12 +18,16 @@
 #include "emu.h"
 #include "media.h"
 #include "math.h"
+#include "analog_glitch.h"
+#include "perf_counters.h"
+#include "trace.h"
 
 extern "C" {
 #include "atari800/libatari800.h"
 #include "atari800/sound.h"
 #include "atari800/akey.h"
 #include "atari800/memory.h"
+#include "atari800/antic.h"
 }
 
 
@@ -635,7 +639,7 @@ extern ULONG *Screen_atari;
 #define Screen_HEIGHT 240
 
 const char* _atari_help[] = {
-    "1 or 2 inserts .atr into drive #",
+    "1 or 2 inserts .atr/.atx into drive #",
     "0 removes .atr from drive",
     "Shift + Enter enables Basic",
     "",
@@ -665,9 +669,9 @@ const char* _atari_help[] = {
     0
 };
 
-// does not support atx. sorry
 const char* _atari_ext[] = {
     "atr",
+    "atx",
     "rom",
     "cas",
     "bin",
@@ -695,7 +699,7 @@ public:
     static int le32(const void* d)
     {
         const uint8_t* b = (const uint8_t*)d;
-        return b[0] | (b[1] << 8) | (b[2] << 8) | (b[3] << 8);
+        return b[0] | (b[1] << 8) | (b[2] << 16) | (b[3] << 24);
     }
 
     File(const string& name) : _len(0) {
@@ -716,6 +720,7 @@ public:
     {
         if (!_fd)
             return -1;
+        PERF_SCOPE(PERF_IO);
         fseek(_fd,offset,SEEK_SET);
         return (int)fread(dst,1,len,_fd);
     }
@@ -768,14 +773,20 @@ public:
             Track track;
             track.offset = trackoffset;
             track.size = le32(t);
+            if (track.size < (int)sizeof(t))
+                return -1;                      // would loop forever, or run backwards
             track.type = le16(t+4);
             track.tracknum = t[8];
             track.sectorcount = le16(t+10);
             track.headersize = le32(t+20);
             track.sectorlistsize = le32(t+32) - 8;
-            for (int i = 0; i < 16; i++)
+            for (int i = 0; i < 18; i++)
                 track.toff[i] = 0;
             uint8_t sl[256];
+            if (track.sectorlistsize < 0)
+                track.sectorlistsize = 0;       // header shorter than its own 8 bytes
+            else if ((size_t)track.sectorlistsize > sizeof(sl))
+                track.sectorlistsize = sizeof(sl);
             read(sl,trackoffset+32+8,track.sectorlistsize);
             for (int i = 0; i < track.sectorlistsize; i += 8) {
                 /*
@@ -786,10 +797,12 @@ public:
                 printf("%d:%d %02X %d %d\n",track.tracknum,num,stat,pos,data);
                  */
                 int dat = le32(sl+i+4);
-                if (dat && sl[i])
+                if (dat && sl[i] && sl[i] <= 18)
                     track.toff[sl[i]-1] = dat;
             }
             _tracks.push_back(track);
+            if ((size_t)track.size >= _len - trackoffset)
+                break;                          // last track, and no int overflow
             trackoffset += track.size;
         }
         _size = 720*_secsize;
@@ -942,6 +955,7 @@ Sound_setup_t Sound_desired = {
 
 class EmuAtari800 : public Emu {
     uint8_t** _lines;
+    string _machine;    // machine options of the last full init
 public:
     EmuAtari800(int ntsc) : Emu("atari800",384,240,ntsc,(16 | (1 << 8)),4,EMU_ATARI)
     {
@@ -1175,6 +1189,7 @@ public:
         int i = Screen_WIDTH*Screen_HEIGHT/4;
         while (i--)
             Screen_atari[i] = 0;
+        ANTIC_InvalidateLines();
     }
 
     int parse_cfg(const string& str, vector<string>& s, vector<char*>& argv)
@@ -1264,6 +1279,26 @@ public:
         return "-xl \"" + path + "\"" + " -H1 \"" + host + "\"";
     }
 
+    // split the options into those that set up the machine and the media ones
+    string split_options(const vector<char*>& argv, vector<char*>& media)
+    {
+        string machine;
+        media.push_back(argv[0]);
+        for (size_t i = 1; i < argv.size(); i++) {
+            int n = libatari800_media_option(argv[i]);
+            if (n < 0) {
+                machine += string(" ") + argv[i];
+                if (libatari800_machine_option_args(argv[i]) && i + 1 < argv.size())
+                    machine += string(" ") + argv[++i];     // its value, not a file
+                continue;
+            }
+            media.push_back(argv[i]);
+            if (n && i + 1 < argv.size())
+                media.push_back(argv[++i]);
+        }
+        return machine;
+    }
+
     //  default media is basic/dos
     virtual int make_default_media(const string& path)
     {
@@ -1295,7 +1330,7 @@ public:
             init_screen();
 
         // just insert a disk
-        if (((flags & 1) == 0) && (get_ext(path) == "atr")) {
+        if (((flags & 1) == 0) && (get_ext(path) == "atr" || get_ext(path) == "atx")) {
             printf("inserting %s into drive %d\n",path.c_str(),disk_index+1);
             return libatari800_mount_disk_image(disk_index+1,path.c_str(),false);
         }
@@ -1311,13 +1346,29 @@ public:
         string cfg = get_cfg(path);
         cfg = patch_cfg(cfg,flags);
         int argc = parse_cfg(cfg,s,argv);
-        libatari800_init(argc,&argv[0]);
+
+        // same machine as last time: keep it and its roms, just swap the media
+        vector<char*> media;
+        string machine = split_options(argv,media);
+        if (!_machine.empty() && machine == _machine &&
+            libatari800_swap_media((int)media.size(),&media[0]))
+            return 0;
+
+        _machine = libatari800_init(argc,&argv[0]) ? machine : "";
         return 0;
     }
 
     virtual int update()
     {
-        return libatari800_next_frame(NULL);
+        ANTIC_SetGlitch(analog_glitch_mask());   // swaps in glitched antic fetches while a slot is active
+        int r = libatari800_next_frame(NULL);
+        TRACE_DEBUG(TRACE_ANTIC_LINES,ANTIC_line_hits,ANTIC_line_misses);
+        return r;
+    }
+
+    virtual void video_overdrawn()
+    {
+        ANTIC_InvalidateLines();                  // antic skips lines it thinks are unchanged
     }
 
     virtual uint8_t** video_buffer()
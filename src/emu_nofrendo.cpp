@@ -17,10 +17,12 @@
 
 #include "emu.h"
 #include "media.h"
+#include "title_arena.h"
 
 extern "C" {
 #include "nofrendo/osd.h"
 #include "nofrendo/event.h"
+#include "nofrendo/nesinput.h"
 };
 #include "math.h"
 
@@ -183,6 +185,12 @@ const char* _nes_help[] = {
     "  + & -      - Reset",
     "  A,1        - Button A",
     "  B,2        - Button B",
+    "",
+    "Up to 4 wiimotes play through a Four Score.",
+    "F6 cycles controller 2 between pad, zapper,",
+    "arkanoid paddle and power pad. Zapper/paddle",
+    "aim with the d-pad of wiimote 2 (or 1), A/B",
+    "fire.",
     0
 };
 
@@ -205,9 +213,45 @@ void osd_setsound(void (*playfunc)(void *buffer, int length))
     nes_sound_cb = playfunc;
 }
 
+// per-title arena: rominfo, 8k sram, 8k chr-ram and its tile cache, mapper state
+#define NES_ARENA_SIZE (32*1024)
+
+// wiimotes feed these when the game strobes $4016, not once a frame
+static nesinput_t _wii_input[4] = {
+    { INP_JOYPAD0, 0 },
+    { INP_JOYPAD1, 0 },
+    { INP_JOYPAD2, 0 },
+    { INP_JOYPAD3, 0 },
+};
+static nesinput_t _aux_input = { INP_ZAPPER, 0 };  // zapper, paddle or power pad on port 1
+
+static void nes_poll();
+
+// order of the event_joypad1_*_ bits below
+static const int _nes_pad_bits[8] = {
+    INP_PAD_UP, INP_PAD_DOWN, INP_PAD_LEFT, INP_PAD_RIGHT,
+    INP_PAD_START, INP_PAD_SELECT, INP_PAD_A, INP_PAD_B
+};
+
+// power pad side A: d-pad and buttons on the 8 inner squares
+static const int _nes_ppad_bits[8] = {
+    INP_PPAD_2, INP_PPAD_10, INP_PPAD_5, INP_PPAD_8,
+    INP_PPAD_11, INP_PPAD_3, INP_PPAD_7, INP_PPAD_6
+};
+
+static const int _nes_port1[] = {
+    INP_DEV_JOYPAD, INP_DEV_ZAPPER, INP_DEV_ARKANOID, INP_DEV_POWERPAD
+};
+static const char* _nes_port1_names[] = {
+    "controller 2: joypad", "controller 2: zapper", "controller 2: arkanoid", "controller 2: power pad"
+};
+
 std::string to_string(int i);
 class EmuNofrendo : public Emu {
     uint8_t** _lines;
+    int _port1;         // index into _nes_port1
+    int _aim_x;         // zapper crosshair / paddle position
+    int _aim_y;
 public:
     EmuNofrendo(int ntsc) : Emu("nofrendo",256,240,ntsc,(16 | (1 << 8)),4,EMU_NES)    // audio is 16bit, 3 or 6 cc width
     {
@@ -215,6 +259,13 @@ public:
         _ext = _nes_ext;
         _help = _nes_help;
         _audio_frequency = audio_frequency;
+        _port1 = 0;
+        _aim_x = 128;
+        _aim_y = 120;
+        arena_init(NES_ARENA_SIZE,0);
+        for (int i = 0; i < 4; i++)
+            input_register(_wii_input + i);
+        input_register(&_aux_input);
     }
 
     virtual void gen_palettes()
@@ -358,6 +409,95 @@ public:
         0,                      //GENERIC_MENU    0x0001
     };
 
+    static int nes_bits(uint32_t p, const int* bits)
+    {
+        int r = 0;
+        for (int i = 0; i < 8; i++)
+            if (p & (1 << i))
+                r |= bits[i];
+        return r;
+    }
+
+    // wiimote 2 aims the zapper / paddle, or wiimote 1 on its own
+    int aim_index()
+    {
+        return (wii_states[1].flags & wiimote) ? 1 : 0;
+    }
+
+    // called from the $4016/$4017 handlers, at most once a scanline
+    void poll()
+    {
+        uint32_t p[4];
+        for (int i = 0; i < 4; i++) {
+            p[i] = wii_map(i,_common_nes,_classic_nes);
+            _wii_input[i].data = nes_bits(p[i],_nes_pad_bits);
+        }
+
+        uint32_t a = p[aim_index()];
+        bool fire = a & (event_joypad1_a_ | event_joypad1_b_);
+        switch (_nes_port1[_port1]) {
+            case INP_DEV_ZAPPER:
+                _aux_input.type = INP_ZAPPER;
+                _aux_input.data = INP_POS(_aim_x,_aim_y) | (fire ? INP_ZAPPER_TRIG : 0);
+                break;
+            case INP_DEV_ARKANOID:
+                _aux_input.type = INP_ARKANOID;
+                _aux_input.data = INP_POS(0x54 + _aim_x*(0xF4 - 0x54)/255,0) | (fire ? INP_ARKANOID_FIRE : 0);
+                break;
+            case INP_DEV_POWERPAD:
+                _aux_input.type = INP_POWERPAD;
+                _aux_input.data = nes_bits(p[aim_index()],_nes_ppad_bits);
+                break;
+            default:
+                _aux_input.data = 0;
+        }
+    }
+
+    // once a frame: plug in the Four Score for 3 or more wiimotes, move the crosshair
+    void update_ports()
+    {
+        int dev = _nes_port1[_port1];
+        if (dev == INP_DEV_JOYPAD) {
+            int n = 0;
+            for (int i = 0; i < 4; i++)
+                n += (wii_states[i].flags & wiimote) != 0;
+            if (n > 2)
+                dev = INP_DEV_FOURSCORE;
+        }
+        if (input_getport(1) != dev)
+            input_setport(1,dev);
+
+        if (dev == INP_DEV_ZAPPER || dev == INP_DEV_ARKANOID) {
+            uint32_t a = wii_map(aim_index(),_common_nes,_classic_nes);
+            int step = dev == INP_DEV_ZAPPER ? 3 : 4;
+            if (a & event_joypad1_left_)  _aim_x = max(_aim_x - step,0);
+            if (a & event_joypad1_right_) _aim_x = min(_aim_x + step,255);
+            if (dev == INP_DEV_ZAPPER) {
+                if (a & event_joypad1_up_)    _aim_y = max(_aim_y - step,8);
+                if (a & event_joypad1_down_)  _aim_y = min(_aim_y + step,231);
+            }
+        }
+    }
+
+    // white crosshair, gone again by the time the beam reaches those lines
+    void draw_crosshair()
+    {
+        if (!_lines || input_getport(1) != INP_DEV_ZAPPER)
+            return;
+        for (int i = 2; i <= 5; i++) {
+            if (_aim_x - i >= 0)    _lines[_aim_y][_aim_x - i] = 0x30;
+            if (_aim_x + i <= 255)  _lines[_aim_y][_aim_x + i] = 0x30;
+            _lines[_aim_y - i][_aim_x] = 0x30;
+            _lines[_aim_y + i][_aim_x] = 0x30;
+        }
+    }
+
+    void next_port1()
+    {
+        _port1 = (_port1 + 1) % (sizeof(_nes_port1)/sizeof(_nes_port1[0]));
+        gui_msg(_nes_port1_names[_port1]);
+    }
+
     // raw HID data. handle WII/IR mappings
     virtual void hid(const uint8_t* d, int len)
     {
@@ -377,6 +517,8 @@ public:
             // reset on select + start held at the same time
             if ((p & event_joypad1_select_) && (p & event_joypad1_start_))
                 pad(1,event_soft_reset);
+            if (!ir)
+                continue;   // wiimotes are pulled by nes_poll
 
             const int* m = i ? _nes_2 : _nes_1;
             for (int e = 0; m[e]; e++)
@@ -404,6 +546,7 @@ public:
 
             case 61: pad(pressed,event_joypad1_start); break; // F4
             case 62: pad(pressed,((KEY_MOD_LSHIFT|KEY_MOD_RSHIFT) & mods) ? event_hard_reset : event_soft_reset); break; // F5
+            case 63: if (pressed) next_port1(); break; // F6
 
             case 40: pad(pressed,event_joypad1_start); break; // return
             case 43: pad(pressed,event_joypad1_select); break; // tab
@@ -438,14 +581,19 @@ public:
         }
 
         nes_emulate_init(path.c_str(),width,height);
+        input_setpoll(nes_poll);
+        arena_trace();
         _lines = nes_emulate_frame(true);   // first frame!
         return 0;
     }
 
     virtual int update()
     {
-        if (_nofrendo_rom)
+        if (_nofrendo_rom) {
+            update_ports();
             _lines = nes_emulate_frame(true);
+            draw_crosshair();
+        }
         return 0;
     }
 
@@ -481,9 +629,15 @@ public:
     }
 };
 
+static EmuNofrendo* _nofrendo = 0;
+static void nes_poll()
+{
+    _nofrendo->poll();
+}
+
 Emu* NewNofrendo(int ntsc)
 {
-    return new EmuNofrendo(ntsc);
+    return _nofrendo = new EmuNofrendo(ntsc);
 }
 
 
@@ -17,6 +17,8 @@
 
 #include "emu.h"
 #include "media.h"
+#include "analog_glitch.h"
+#include "title_arena.h"
 
 extern "C" {
 #include "smsplus/shared.h"
@@ -306,6 +308,9 @@ const char* _sms_help[] = {
     0
 };
 
+// per-title arena: the two sound buffers
+#define SMS_ARENA_SIZE (2*1024)
+
 // https://www.smspower.org/Homebrew/Index
 std::string to_string(int i);
 class EmuSMSPlus : public Emu {
@@ -317,6 +322,7 @@ public:
         cart.rom = 0;
         _ext = _sms_ext;
         _help = _sms_help;
+        arena_init(SMS_ARENA_SIZE,0);
     }
 
     virtual void gen_palettes()
@@ -370,6 +376,14 @@ public:
             memset(sms_videodata,0,256*240);
     }
 
+    // export consoles had no FM unit and games probing port F2 there never used it,
+    // so only images tagged as Japanese in the usual way, "(J)" or "(Japan)", get one
+    static bool japanese(const std::string& path)
+    {
+        string name = path.substr(path.find_last_of("/") + 1);
+        return name.find("(J)") != string::npos || name.find("(Japan") != string::npos;
+    }
+
     virtual int insert(const std::string& path, int flags, int disk_index)
     {
         if (!_lines)
@@ -387,9 +401,13 @@ public:
         cart.pages = ((len + 0x3FFF)/0x4000);
         cart.rom = _smsplus_rom;
         cart.type = get_ext(path) == "sms" ? TYPE_SMS : TYPE_GG;
+        sms.use_fm = cart.type == TYPE_SMS && japanese(path);    // only the Mark III / Japanese SMS had the FM unit
 
+        arena_begin();     // drops the last cart's sound buffers
         emu_system_init(audio_frequency);
         sms_init();
+        arena_end();
+        arena_trace();
         return 0;
     }
 
@@ -518,6 +536,7 @@ public:
             
     virtual int update()
     {
+        render_glitch(analog_glitch_mask());   // swaps in glitched vdp fetches while a slot is active
         if (_smsplus_rom)
             sms_frame(0);
         return 0;
@@ -10,14 +10,16 @@
 /* Include analog glitch system for potentiometer control */
 #include "../analog_glitch.h"
 
-/* Apply simulated hardware faults to a PPU address.
-   Now uses analog potentiometer control instead of fixed glitch. */
-static inline uint16_t ppu_glitch_addr(uint16_t addr)
+/* Address lines to force low on PPU reads (0 = no glitch).
+   Forcing lines low is a pure remap of each 1K page, so the PPU applies
+   it to shadow copies of its pages when the mask changes rather than
+   masking every fetch. */
+static inline uint16_t ppu_glitch_mask(void)
 {
 #if PPU_GLITCH_ENABLED
-    return analog_ppu_glitch_addr(addr);
+    return analog_glitch_mask() & 0x03FF;
 #else
-    return addr; /* glitch disabled - return address unchanged */
+    return 0; /* glitch disabled - pages are never remapped */
 #endif
 }
 
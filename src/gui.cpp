@@ -17,6 +17,8 @@
 
 #include "emu.h"
 #include "analog_glitch.h"
+#include "trace.h"
+#include "perf_counters.h"
 
 using namespace std;
 
@@ -743,7 +745,7 @@ public:
     // raw keycode
     bool key(int keycode, int pressed, int mods)
     {
-        printf("key:%02X %02X %02X\n",keycode,pressed,mods);
+        TRACE_DEBUG(TRACE_KEY,keycode,(pressed << 8) | mods);
         if (pressed && _visible)
             _click = 1;
 
@@ -904,6 +906,14 @@ public:
         int i;
         for (i = 0; i < (int)_info.size(); i++)
             draw_item(i,_info[i].c_str(),false);
+
+        // cycle accounting from the last perf window
+        char buf[64];
+        if (i + PERF_COUNT + 2 < _overlay->OVERLAY_HEIGHT - 2 && perf_format(1,buf,sizeof(buf))) {
+            draw_item(i++," ",false);
+            for (int j = 0; perf_format(j,buf,sizeof(buf)); j++)
+                draw_item(i++,buf,false);
+        }
         clear(i);
     }
 
@@ -944,6 +954,7 @@ public:
     void update_video()
     {
         if (_visible) {
+            PERF_SCOPE(PERF_GUI);
             menu();
             scrollbar();
             switch (_tab) {
@@ -952,17 +963,21 @@ public:
                 case 2: draw_help(); break;
             }
             _overlay->update();
+            _emu->video_overdrawn();
         } else {
+            PERF_SCOPE(PERF_CPU);
             _emu->update();
         }
 
         // message goes over both
         if (_msg.size()) {
+            PERF_SCOPE(PERF_GUI);
             if (--_msg_ticks == 0) {
                 _overlay->erase_msg();
                 _msg.clear();
             } else
                 _overlay->draw_msg(_msg);
+            _emu->video_overdrawn();
         }
     }
 
@@ -974,6 +989,7 @@ public:
 
     void update_audio()
     {
+        PERF_SCOPE(PERF_AUDIO);
         int16_t abuffer[313*2];
         int format = _emu->audio_format >> 8;
         int sample_count = _emu->frame_sample_count();
@@ -1007,6 +1023,7 @@ void gui_update()
     _gui.update_audio();
     _gui.update_video();
 
+    PERF_SCOPE(PERF_INPUT);
     uint8_t buf[64];
     int n = hid_get(buf,sizeof(buf));    // called from emulation loop
     if (n > 0)
@@ -1063,7 +1080,9 @@ static void pad_key(int mask, int state, int key)
 
 static void wii()
 {
-    int pad = wii_states[0].common();
+    wii_state state;
+    wii_snapshot(0,&state);
+    int pad = state.common();
     pad_key(wii_right,pad,82);  // up
     pad_key(wii_left,pad,81);   // down
     pad_key(wii_down,pad,79);   // right
@@ -24,7 +24,7 @@
 #include <string>
 #include <map>
 #include <vector>
-#include <mutex>
+#include <atomic>
 using namespace std;
 
 #include "hci_transport.h"
@@ -327,45 +327,86 @@ const char* batostr(const bdaddr_t& a)
     return buf;
 }
 
+// single producer, single consumer packet ring.
+// packets live contiguously in a fixed slab allocated once, each behind a 4 byte length header.
+// writers reserve space in place and commit, readers peek a view into the slab and pop it.
 class PacketQ
 {
-    uint32_t _read;
-    uint32_t _write;
-    enum {QSIZE = 32};
-    vector<uint8_t> _data[QSIZE];
-    mutex _mutex;
+    enum {WRAP = 0xFFFFFFFF};
+    uint8_t* _slab;
+    uint32_t _size;             // power of 2
+    atomic<uint32_t> _read;     // free running byte offsets
+    atomic<uint32_t> _write;
+    uint32_t _reserved;         // offset of header for the current reservation
+
+    static uint32_t entry(int len) { return (4 + len + 3) & ~3; }
+    uint32_t& header(uint32_t offset) { return *(uint32_t*)(_slab + (offset & (_size-1))); }
 public:
-    PacketQ() : _read(0),_write(0) {};
+    PacketQ(uint32_t size = 2048) : _size(size),_read(0),_write(0),_reserved(0)
+    {
+        assert((size & (size-1)) == 0);
+        _slab = new uint8_t[size];
+    };
+    ~PacketQ() { delete [] _slab; }
 
     bool empty()
     {
-        return _read == _write;
+        return _read.load(memory_order_acquire) == _write.load(memory_order_acquire);
     }
-    bool read(vector<uint8_t>& d)
+
+    // producer: find room for len bytes, NULL if full
+    uint8_t* reserve(int len)
     {
-        lock_guard<mutex> lock(_mutex);
-        assert(_read <= _write);
-        if (_read == _write)
-            return false;
-        d = _data[_read++ & (QSIZE-1)];
-        return true;
+        uint32_t w = _write.load(memory_order_relaxed);
+        uint32_t free = _size - (w - _read.load(memory_order_acquire));
+        uint32_t e = entry(len);
+        uint32_t tail = _size - (w & (_size-1));
+        if (e > tail) {                 // won't fit before end of slab, skip to start
+            if (tail + e > free)
+                return NULL;
+            header(w) = WRAP;
+            w += tail;
+        } else if (e > free)
+            return NULL;
+        _reserved = w;
+        return (uint8_t*)(&header(w) + 1);
     }
 
-    bool write(const vector<uint8_t>& d)
+    // producer: publish len bytes (<= reserved) of a reservation
+    void commit(int len)
     {
-        lock_guard<mutex> lock(_mutex);
-        assert(_read <= _write && (_write - _read <= QSIZE));
-        if (_write - _read == QSIZE)
+        header(_reserved) = len;
+        _write.store(_reserved + entry(len),memory_order_release);
+    }
+
+    bool write(const uint8_t* data, int len)
+    {
+        uint8_t* d = reserve(len);
+        if (!d)
             return false;
-        _data[_write++ & (QSIZE-1)] = d;
+        memcpy(d,data,len);
+        commit(len);
         return true;
     }
 
-    bool write(const uint8_t* data, int len)
+    // consumer: view of the oldest packet, valid until pop
+    const uint8_t* peek(int& len)
+    {
+        uint32_t r = _read.load(memory_order_relaxed);
+        if (r == _write.load(memory_order_acquire))
+            return NULL;
+        if (header(r) == WRAP) {
+            r += _size - (r & (_size-1));
+            _read.store(r,memory_order_release);
+        }
+        len = header(r);
+        return (const uint8_t*)(&header(r) + 1);
+    }
+
+    void pop()
     {
-        vector<uint8_t> buf(len);
-        memcpy(&buf[0],data,len);
-        return write(buf);
+        uint32_t r = _read.load(memory_order_relaxed);
+        _read.store(r + entry(header(r)),memory_order_release);
     }
 };
 
@@ -430,7 +471,8 @@ public:
 };
 
 // forward
-int hci_write(vector<uint8_t>& buf);
+uint8_t* hci_reserve(int len);
+void hci_commit(int len);
 
 enum {
     SLAVE = 1,
@@ -448,15 +490,17 @@ public:
     int _handle;
     int _flags;
 
-    // packet reassembly
+    // packet reassembly, in place in the socket q or _packet for signaling
     vector<uint8_t> _packet;
+    uint8_t* _packet_dst;
+    int _packet_len;
     int _packet_pos;
     int _packet_cid;
 
     uint8_t _txid;
     map<int,L2CAPSocket*> _sockets;
 
-    BTDevice() : _packet_pos(0),_txid(1),_flags(SLAVE)
+    BTDevice() : _packet_dst(0),_packet_len(0),_packet_pos(0),_txid(1),_flags(SLAVE)
     {
     }
 
@@ -534,27 +578,38 @@ public:
         const uint8_t* data = ((const uint8_t*)p) + 5;
         int len = p->length;
         if (pt == 2) {  // start of a packet
-            _packet.resize(p->l2capLength); // length of payload
+            _packet_len = p->l2capLength;   // length of payload
             _packet_cid = p->cid;
+            _packet_pos = 0;
             data += 4;
             len -= 4;                       // skip header
+            if (_packet_cid == 1) {
+                _packet.resize(_packet_len);
+                _packet_dst = &_packet[0];
+            } else {
+                auto s = get_socket(_packet_cid);
+                if (!s)
+                    return false;           // did not have a socket for this data.
+                _packet_dst = s->_q.reserve(_packet_len);   // NULL if q is full, drop
+            }
         }
-        memcpy(&_packet[_packet_pos],data,len);
+        len = min(len,_packet_len - _packet_pos);
+        if (_packet_dst && len > 0)
+            memcpy(_packet_dst + _packet_pos,data,len);
         _packet_pos += len;
 
-        // if packet is assembled, queue it.
-        if (_packet_pos == (int)_packet.size()) {
-            if (_packet_cid == 1)
-                control((const l2cap_cmd*)&_packet[0]);
-            else {
-                auto s = get_socket(_packet_cid);
-                if (s) {
-                    s->_q.write(&_packet[0],_packet_pos);
-                } else {
-                    _packet_pos = 0;
-                    return false;   // did not have a socket for this data.
+        // if packet is assembled, hand it on.
+        if (_packet_pos == _packet_len) {
+            if (_packet_dst) {
+                if (_packet_cid == 1)
+                    control((const l2cap_cmd*)&_packet[0]);
+                else {
+                    auto s = get_socket(_packet_cid);
+                    if (s)
+                        s->_q.commit(_packet_len);
                 }
             }
+            _packet_dst = 0;
             _packet_pos = 0;
         }
         return true;
@@ -671,8 +726,9 @@ public:
     int send(const void* data = 0, int len = 0, int cid = 1)
     {
         int n = sizeof(l2cap_data) + len;
-        vector<uint8_t> buf(n);
-        l2cap_data* d = (l2cap_data*)&buf[0];
+        l2cap_data* d = (l2cap_data*)hci_reserve(n);    // build in place in outbound q
+        if (!d)
+            return -1;
         d->type = 0x02;                 // acl
         d->handle = _handle | 0x2000;
         d->length = len + 4;            // includes l2cap header
@@ -680,7 +736,8 @@ public:
         d->cid = cid;
         if (data)
             memcpy(d->data,data,len);   // l2cap payload
-        return hci_write(buf);          // send to outbound q.
+        hci_commit(n);                  // send to outbound q.
+        return 0;
     }
 
     int l2cap(uint8_t cmd, uint8_t id, u16* params, int count)
@@ -786,6 +843,7 @@ class HCI {
     int _cid; // connection id
     PacketQ _rx;
     PacketQ _tx;
+    atomic<bool> _ready;
 
 public:
     hci_callback _callback;
@@ -814,11 +872,13 @@ public:
         auto* s = get_socket(scid);
         if (!s)
             return -1;
-        vector<uint8_t> d;
-        if (!s->_q.read(d))
+        int n;
+        const uint8_t* d = s->_q.peek(n);
+        if (!d)
             return 0;
-        len = min(len,(int)d.size());
-        memcpy(dst,&d[0],len);
+        len = min(len,n);
+        memcpy(dst,d,len);
+        s->_q.pop();
         return len;
     }
 
@@ -849,7 +909,7 @@ public:
         return create_connection(*d);
     }
 
-    HCI(const char* localname) : _localname(localname),_state(-1),_cid(0x40)
+    HCI(const char* localname) : _localname(localname),_state(-1),_cid(0x40),_rx(8192),_tx(4096),_ready(false)
     {
         _hci = hci_open();
         if (!_hci)
@@ -890,31 +950,45 @@ public:
 
     int update()
     {
+        // reset once controller is ready, queued from this thread so _tx keeps a single producer
+        if (_state == -1 && _ready) {
+            cmd(HCI_RESET);
+            _state = 0;
+        }
+
         // send any pending
-        vector<uint8_t> buf;
-        while (hci_send_available(_hci) && _tx.read(buf))
+        int len;
+        const uint8_t* buf;
+        while (hci_send_available(_hci) && (buf = _tx.peek(len)))
         {
-            TRACE(1,&buf[0],(int)buf.size());
-            hci_send(_hci,&buf[0],(int)buf.size());
+            TRACE(1,buf,len);
+            hci_send(_hci,buf,len);
+            _tx.pop();
         }
 
-        // handle any inbound.
+        // handle any inbound, parsed in place in the rx q.
         // hcl/acl ordering challenge. TODO.
-        while (_rx.read(buf)) {
-            TRACE(0,&buf[0],(int)buf.size());
+        while ((buf = _rx.peek(len))) {
+            TRACE(0,buf,len);
             switch (buf[0]) {
-                case 0x2: acl(&buf[0],(int)buf.size()); break;
-                case 0x4: hci(buf[1],&buf[3],buf[2]); break;
+                case 0x2: acl(buf,len); break;
+                case 0x4: hci(buf[1],buf+3,buf[2]); break;
                 default:
                     PRINTF("bad hci packet\n");
             }
+            _rx.pop();
         }
         return 0;
     }
 
-    int write(vector<uint8_t>& buf)
+    uint8_t* reserve(int len)
     {
-        return _tx.write(buf) ? 0 : -1; // send to outbound q.
+        return _tx.reserve(len);        // space in outbound q.
+    }
+
+    void commit(int len)
+    {
+        _tx.commit(len);
     }
 
 private:
@@ -936,23 +1010,23 @@ private:
 
     void ready_to_send()
     {
-        if (_state == -1) {
-            cmd(HCI_RESET);
-            _state = 0;
-        }
+        _ready = true;
     }
 
     // hci command
     int cmd(uint16_t c, const void* data = 0, int len = 0)
     {
-        vector<uint8_t> buf(len+4);
+        uint8_t* buf = _tx.reserve(len+4);  // build in place in outbound q.
+        if (!buf)
+            return -1;
         if (data)
             memcpy(&buf[4],data,len);
         buf[0] = 0x01;         // hci Command
         buf[1] = (uint8_t)c;
         buf[2] = (uint8_t)(c >> 8);
         buf[3] = len;
-        return write(buf); // send to outbound q.
+        _tx.commit(len+4);
+        return 0;
     }
 
     // look for devices
@@ -1461,7 +1535,12 @@ int hci_connect(const bdaddr_t* addr)
     return _hci->connect(addr);
 }
 
-int hci_write(vector<uint8_t>& buf)
+uint8_t* hci_reserve(int len)
+{
+    return _hci->reserve(len); // space in outbound q.
+}
+
+void hci_commit(int len)
 {
-    return _hci->write(buf); // send to outbound q.
+    _hci->commit(len);
 }
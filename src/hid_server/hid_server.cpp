@@ -22,6 +22,7 @@
 #include <unistd.h>
 #include <vector>
 #include <string>
+#include <atomic>
 using namespace std;
 
 #include "hci_server.h"
@@ -497,6 +498,32 @@ enum {
 };
 wii_state wii_states[4] = {0};
 
+// reports land on the hid core while the emulator core reads them.
+// a slot's sequence is odd while a report is being copied in.
+static std::atomic<uint32_t> _wii_seq[4];
+
+static void wii_set_report(int index, const uint8_t* data, int len)
+{
+    uint32_t seq = _wii_seq[index].load(std::memory_order_relaxed);
+    _wii_seq[index].store(seq + 1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(wii_states[index].report,data,min((int)sizeof(wii_states[index].report),len));
+    _wii_seq[index].store(seq + 2,std::memory_order_release);
+}
+
+void wii_snapshot(int index, wii_state* dst)
+{
+    for (;;) {
+        uint32_t seq = _wii_seq[index].load(std::memory_order_acquire);
+        if (seq & 1)
+            continue;       // copy in progress on the other core, it's short
+        *dst = wii_states[index];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_wii_seq[index].load(std::memory_order_relaxed) == seq)
+            return;
+    }
+}
+
 // https://wiibrew.org/wiki/Wiimote
 // https://github.com/dvdhrm/xwiimote/blob/master/doc/PROTOCOL
 // https://web.archive.org/web/20080630032911/http://wiki.wiimoteproject.com/Reports
@@ -676,7 +703,7 @@ public:
 
             case 0x32:  // core + ext
             case 0x37:  // big report
-                memcpy(state->report,data,min((int)sizeof(state->report),len));
+                wii_set_report(slot,data,len);
                 //dump_report(data,len);
                 break;
 
@@ -1017,18 +1044,20 @@ int hid_get(uint8_t* dst, int dst_len)
 // map wii controller keys
 uint32_t wii_map(int index, const uint32_t* common, const uint32_t* classic)
 {
-    uint32_t f = wii_states[index].flags;
+    wii_state state;
+    wii_snapshot(index,&state);
+    uint32_t f = state.flags;
     if (!(f & wiimote))
         return 0;
 
     uint32_t r = 0;
-    int pad = wii_states[index].common();
+    int pad = state.common();
     for (int i = 0; i < 16; i++) {
         if (pad & (0x8000 >> i))
             r |= common[i];
     }
     if (classic && (f & classic_controller)) {
-        pad = wii_states[index].classic();
+        pad = state.classic();
         for (int i = 0; i < 16; i++) {
             if (pad & (0x8000 >> i))
                 r |= classic[i];
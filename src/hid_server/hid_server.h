@@ -137,6 +137,7 @@ typedef struct {
 
 // report all of the wii states
 extern wii_state wii_states[4];
+void wii_snapshot(int index, wii_state* dst);   // consistent copy, for readers on the other core
 uint32_t wii_map(int index, const uint32_t* common, const uint32_t* classic);
 
 // minimal hid interface
@@ -29,15 +29,6 @@
 
 static int32 fds_incsize = 0;
 
-/* mix sound channels together */
-static int32 fds_process(void)
-{
-   int32 output;
-   output = 0;
-
-   return output;
-}
-
 /* write to registers */
 static void fds_write(uint32 address, uint8 value)
 {
@@ -66,9 +57,10 @@ apuext_t fds_ext =
    NULL, /* no init */
    NULL, /* no shutdown */
    fds_reset,
-   fds_process,
+   NULL, /* no sound generation yet */
    NULL, /* no reads */
-   fds_memwrite
+   fds_memwrite,
+   NULL
 };
 
 /*
@@ -170,6 +170,20 @@ struct mapper40Data
    unsigned char irqCounterEnabled;
 };
 
+struct mapper42Data
+{
+   unsigned char irqCounterLowByte;
+   unsigned char irqCounterHighByte;
+   unsigned char irqCounterEnabled;
+};
+
+struct mapper50Data
+{
+   unsigned char irqCounterLowByte;
+   unsigned char irqCounterHighByte;
+   unsigned char irqCounterEnabled;
+};
+
 struct mapper69Data
 {
    unsigned char irqCounterLowByte;
@@ -177,6 +191,13 @@ struct mapper69Data
    unsigned char irqCounterEnabled;
 };
 
+struct mapper73Data
+{
+   unsigned char irqCounterLowByte;
+   unsigned char irqCounterHighByte;
+   unsigned char irqCounterEnabled;
+};
+
 struct mapper90Data
 {
    unsigned char irqCounter;
@@ -290,7 +311,10 @@ typedef struct _SnssMapperBlock
       struct mapper21Data mapper21;
       struct mapper24Data mapper24;
       struct mapper40Data mapper40;
+      struct mapper42Data mapper42;
+      struct mapper50Data mapper50;
       struct mapper69Data mapper69;
+      struct mapper73Data mapper73;
       struct mapper90Data mapper90;
       struct mapper224Data mapper224;
       struct mapper225Data mapper225;
@@ -4,6 +4,7 @@
 #include "libsnss.h"
 #include "nes_rom.h"
 #include "nes_ppu.h"
+#include "nes_sched.h"
 #include <string.h>
 #include <stdio.h>
 #include "nes6502.h"  
@@ -45,7 +46,6 @@ static uint16 vrombase;         /* 0x0000 or 0x1000               */
 static uint8  prg_bank6;        /* last R6 value                  */
 static uint8  r7_prg_bank;      /* last R7 value (0xA000 bank)    */
 static bool   fourscreen;
-static bool   wram_en, wram_wp;
 static uint8  wram_bank; 
 static uint8 chr_reg[6];
 
@@ -61,6 +61,7 @@ static struct {
     int frame_count;
     int a12_edges_natural;      /* A12 edges from real PPU accesses */
     int a12_edges_synthetic;    /* A12 edges generated synthetically */
+    int a12_edges_predicted;    /* A12 edges scheduled from the PPU state */
     int irq_count;              /* Total IRQs triggered */
     int irq_enable_changes;     /* Number of times IRQ was enabled/disabled */
     int irq_currently_enabled;  /* Current IRQ enable state */
@@ -104,7 +105,8 @@ INLINE void map4_clock_irq(void)
 #if MAP4_PPU_EDGE_IRQ
 /* ─────────────── PPU bus hook ───────────────────────────────────────
    Call exactly once for every PPU memory access.  Only PRG-CHR reads
-   (addr & 0x2000 == 0) matter for MMC3 IRQ timing.                    */
+   (addr & 0x2000 == 0) matter for MMC3 IRQ timing.  Only installed
+   while map4_hblank() cannot work out the edge from the PPU state.    */
 void map4_ppu_tick(uint16 addr)
 {
     uint8 curr_a12 = (addr & 0x1000) ? 1 : 0;   /* current A12 level */
@@ -201,12 +203,10 @@ static void map4_write(uint32 a, uint8 v)
         break;
 
     /* $A001 – WRAM enable/protect --------------------------------------- */
+    /* iNES mapper 4 also covers MMC6 (StarTropics), whose $A001 bits mean
+       something else, and there's no submapper to tell them apart. Leave
+       $6000-$7FFF enabled and writable, which is what MMC3 games expect too. */
     case 0xA001:
-        wram_en = !!(v & 0x80);
-        wram_wp = !!(v & 0x40);
-        nes_set_wram_enable(wram_en);
-        nes_set_wram_write_protect(wram_wp);
-        mmc_bankwram(8, 0x6000, v & 3);
         break;
 
     /* $C000 – IRQ latch -------------------------------------------------- */
@@ -264,7 +264,11 @@ static void map4_write(uint32 a, uint8 v)
     
 }
 
-/* ─────────────── HBlank fallback (edge IRQ off) ───────────────────── */
+/* ─────────────── HBlank: schedule the counter clock ───────────────── */
+/* The PPU tells us on which dot of the line A12 rises, and the clock is
+   run as a CPU event at that point of the line.  Only when that depends
+   on the fetch timing is the bus hook installed to follow every pattern
+   fetch, with a synthetic edge for lines that did not produce one.      */
 static void map4_hblank(int vblank)
 {
 #if !MAP4_PPU_EDGE_IRQ
@@ -272,50 +276,45 @@ static void map4_hblank(int vblank)
         map4_clock_irq();
 #else
     nes_t *nes = nes_getcontextptr();
-    if (!nes) return;
-    
-    /* Generate synthetic A12 edges for scanlines that didn't generate them */
-    if (!vblank && nes->scanline >= 0 && nes->scanline < 240) {
-        /* If this visible scanline hasn't generated an A12 edge, generate a synthetic one */
-        if (!scanline_a12_generated[nes->scanline]) {
-            map4_clock_irq();
-            scanline_a12_generated[nes->scanline] = true;
+    int scanline = nes->scanline;
+    int dot;
+
+    /* sprites and the next line are fetched on lines 0-239 and 261 */
+    if (ppu_enabled() && (scanline < 240 || scanline == 261)) {
+        dot = ppu_a12_rise(scanline);
+        if (PPU_A12_IRREGULAR == dot) {
+            ppu_set_mapper_hook(map4_ppu_tick);
+            if (scanline < 240 && !scanline_a12_generated[scanline]) {
+                map4_clock_irq();
+                scanline_a12_generated[scanline] = true;
 #if TRACE_MMC3_STATS
-            stats.a12_edges_synthetic++;
+                stats.a12_edges_synthetic++;
 #endif
-        }
-    }
-    
-    /* At end of frame (scanline 261), ensure we have 240 A12 edges minimum */
-    if (vblank && nes->scanline == 261) {
-        /* Count actual edges generated for visible scanlines */
-        int edge_count = 0;
-        for (int i = 0; i < 240; i++) {
-            if (scanline_a12_generated[i]) {
-                edge_count++;
             }
-        }
-        
-        /* Generate synthetic edges for any missing scanlines to reach 240 minimum */
-        for (int i = 0; i < 240 && edge_count < 240; i++) {
-            if (!scanline_a12_generated[i]) {
-                map4_clock_irq();
-                edge_count++;
+        } else {
+            ppu_set_mapper_hook(NULL);
+            /* the hook may already have clocked this line */
+            if (dot >= 0 && !scanline_a12_generated[scanline]) {
+                sched_in(SCHED_MAPPER, dot / 3, map4_clock_irq);
 #if TRACE_MMC3_STATS
-                stats.a12_edges_synthetic++;
+                stats.a12_edges_predicted++;
 #endif
             }
         }
-        
+    }
+
+    if (scanline == 261) {
 #if TRACE_MMC3_STATS
         /* Log per-frame statistics */
         stats.frame_count++;
-        int total_a12_edges = stats.a12_edges_natural + stats.a12_edges_synthetic;
-        STATS_LOG("Frame %d: A12_edges=%d (nat=%d,syn=%d) IRQs=%d IRQ_changes=%d IRQ_enabled=%s\n",
+        int total_a12_edges = stats.a12_edges_natural + stats.a12_edges_synthetic
+                            + stats.a12_edges_predicted;
+        STATS_LOG("Frame %d: A12_edges=%d (nat=%d,syn=%d,pred=%d) IRQs=%d IRQ_changes=%d IRQ_enabled=%s\n",
                   stats.frame_count,
                   total_a12_edges,
                   stats.a12_edges_natural,
                   stats.a12_edges_synthetic,
+                  stats.a12_edges_predicted,
                   stats.irq_count,
                   stats.irq_enable_changes,
                   stats.irq_currently_enabled ? "YES" : "NO");
@@ -323,6 +322,7 @@ static void map4_hblank(int vblank)
         /* Reset per-frame counters */
         stats.a12_edges_natural = 0;
         stats.a12_edges_synthetic = 0;
+        stats.a12_edges_predicted = 0;
         stats.irq_count = 0;
         stats.irq_enable_changes = 0;
 #endif
@@ -341,8 +341,8 @@ static void map4_getstate(SnssMapperBlock *s)
     s->extraData.mapper4.irqCounterEnabled = irq.enabled;
     s->extraData.mapper4.last8000Write     = reg8000;
     s->extraData.mapper4.fill1[0]          = irq.reload_flag;
-    s->extraData.mapper4.fill1[1]          = wram_en;
-    s->extraData.mapper4.fill1[2]          = wram_wp;
+    s->extraData.mapper4.fill1[1]          = true;     /* WRAM enabled */
+    s->extraData.mapper4.fill1[2]          = false;    /* ...and writable */
     s->extraData.mapper4.fill1[3]          = prg_bank6;
     s->extraData.mapper4.fill1[4]          = r7_prg_bank;
     /* Save CHR registers in remaining fill space */
@@ -356,16 +356,16 @@ static void map4_setstate(SnssMapperBlock *s)
     irq.enabled      = s->extraData.mapper4.irqCounterEnabled;
     reg8000          = s->extraData.mapper4.last8000Write;
     irq.reload_flag  = s->extraData.mapper4.fill1[0];
-    wram_en          = s->extraData.mapper4.fill1[1];
-    wram_wp          = s->extraData.mapper4.fill1[2];
     prg_bank6        = s->extraData.mapper4.fill1[3];
     r7_prg_bank      = s->extraData.mapper4.fill1[4];
     /* Restore CHR registers from remaining fill space */
     memcpy(chr_reg, &s->extraData.mapper4.fill1[5], 6);
 
-    nes_set_wram_enable(wram_en);
-    nes_set_wram_write_protect(wram_wp);
-    
+    /* states saved while $A001 was honoured may hold a disabled window */
+    nes_set_wram_enable(true);
+    nes_set_wram_write_protect(false);
+    mmc_bankwram(8, 0x6000, 0);
+
     /* Restore banking configuration */
     vrombase = (reg8000 & 0x80) ? 0x1000 : 0x0000;
     
@@ -407,7 +407,6 @@ static void map4_init(void)
 #endif
     reg8000    = 0;  vrombase = 0;  prg_bank6 = 0;  r7_prg_bank = 0;
     fourscreen = !!(cart->flags & ROM_FLAG_FOURSCREEN);
-    wram_en    = false; wram_wp = false;
 
     /* PRG layout */
     mmc_bankrom(8, 0xC000, FIXED_PENULT(cart));
@@ -418,9 +417,6 @@ static void map4_init(void)
     /* CHR layout */
     mmc_bankvrom(8, 0x0000, 0);
 
-#if MAP4_PPU_EDGE_IRQ
-    ppu_set_mapper_hook(map4_ppu_tick);
-#endif
 }
 
 /* ─────────────── memory-write table & public iface ────────────────── */
@@ -27,6 +27,7 @@
 #include "nes_mmc.h"
 #include "nes_ppu.h"
 #include "nes.h"
+#include "nes_sched.h"
 
 static struct
 {
@@ -36,12 +37,36 @@ static struct
 
 /* mapper 16: Bandai */
 
+/* the counter runs down once per CPU cycle, so only the IRQ at
+** zero is scheduled while it is enabled
+*/
+static void map16_irq(void)
+{
+   irq.counter = 0;
+   nes_irq();
+}
+
+static void map16_sync(void)
+{
+   if (irq.enabled)
+      irq.counter = sched_left(SCHED_MAPPER);
+}
+
+static void map16_schedule(void)
+{
+   if (irq.enabled && irq.counter)
+      sched_in(SCHED_MAPPER, irq.counter, map16_irq);
+   else
+      sched_cancel(SCHED_MAPPER);
+}
+
 static void map16_init(void)
 {
    mmc_bankrom(16, 0x8000, 0);
    mmc_bankrom(16, 0xC000, MMC_LASTBANK);
    irq.counter = 0;
    irq.enabled = false;
+   sched_cancel(SCHED_MAPPER);
 }
 
 static void map16_write(uint32 address, uint8 value)
@@ -82,15 +107,22 @@ static void map16_write(uint32 address, uint8 value)
          break;
    
       case 0xA:
+         map16_sync();
+         nes_irq_ack();
          irq.enabled = (value & 1) ? true : false;
+         map16_schedule();
          break;
  
       case 0xB:
+         map16_sync();
          irq.counter = (irq.counter & 0xFF00) | value;
+         map16_schedule();
          break;
    
       case 0xC:
+         map16_sync();
          irq.counter = (value << 8) | (irq.counter & 0xFF);
+         map16_schedule();
          break;
    
       case 0xD:
@@ -100,22 +132,9 @@ static void map16_write(uint32 address, uint8 value)
    }
 }
 
-static void map16_hblank(int vblank)
-{
-   UNUSED(vblank);
-
-   if (irq.enabled)
-   {
-      if (irq.counter)
-      {
-         if (0 == --irq.counter)
-            nes_irq();
-      }
-   }
-}
-
 static void map16_getstate(SnssMapperBlock *state)
 {
+   map16_sync();
    state->extraData.mapper16.irqCounterLowByte = irq.counter & 0xFF;
    state->extraData.mapper16.irqCounterHighByte = irq.counter >> 8;
    state->extraData.mapper16.irqCounterEnabled = irq.enabled;
@@ -126,6 +145,7 @@ static void map16_setstate(SnssMapperBlock *state)
    irq.counter = (state->extraData.mapper16.irqCounterHighByte << 8)
                        | state->extraData.mapper16.irqCounterLowByte;
    irq.enabled = state->extraData.mapper16.irqCounterEnabled;
+   map16_schedule();
 }
 
 static map_memwrite map16_memwrite[] =
@@ -142,7 +162,7 @@ mapintf_t map16_intf =
    "Bandai", /* mapper name */
    map16_init, /* init routine */
    NULL, /* vblank callback */
-   map16_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    map16_getstate, /* get state (snss) */
    map16_setstate, /* set state (snss) */
    NULL, /* memory read structure */
@@ -28,33 +28,11 @@
 #include "nes.h"
 #include "log.h"
 #include "vrcvisnd.h"
-
-static struct
-{
-   int counter, enabled;
-   int latch, wait_state;
-} irq;
+#include "vrcirq.h"
 
 static void map24_init(void)
 {
-   irq.counter = irq.enabled = 0;
-   irq.latch = irq.wait_state = 0;
-}
-
-static void map24_hblank(int vblank) 
-{
-   UNUSED(vblank);
-
-   if (irq.enabled)
-   {
-      if (256 == ++irq.counter)
-      {
-         irq.counter = irq.latch;
-         nes_irq();
-         //irq.enabled = false;
-         irq.enabled = irq.wait_state;
-      }
-   }
+   vrcirq_reset();
 }
 
 static void map24_write(uint32 address, uint8 value)
@@ -131,18 +109,15 @@ static void map24_write(uint32 address, uint8 value)
       break;
    
    case 0xF000:
-      irq.latch = value;
+      vrcirq_latch(value);
       break;
    
    case 0xF001:
-      irq.enabled = (value >> 1) & 0x01;
-      irq.wait_state = value & 0x01;
-      if (irq.enabled)
-         irq.counter = irq.latch;
+      vrcirq_control(value);
       break;
    
    case 0xF002:
-      irq.enabled = irq.wait_state;
+      vrcirq_ack();
       break;
    
    default:
@@ -155,14 +130,14 @@ static void map24_write(uint32 address, uint8 value)
 
 static void map24_getstate(SnssMapperBlock *state)
 {
-   state->extraData.mapper24.irqCounter = irq.counter;
-   state->extraData.mapper24.irqCounterEnabled = irq.enabled;
+   vrcirq_getstate(&state->extraData.mapper24.irqCounter,
+                   &state->extraData.mapper24.irqCounterEnabled);
 }
 
 static void map24_setstate(SnssMapperBlock *state)
 {
-   irq.counter = state->extraData.mapper24.irqCounter;
-   irq.enabled = state->extraData.mapper24.irqCounterEnabled;
+   vrcirq_setstate(state->extraData.mapper24.irqCounter,
+                   state->extraData.mapper24.irqCounterEnabled);
 }
 
 static map_memwrite map24_memwrite[] =
@@ -177,7 +152,7 @@ mapintf_t map24_intf =
    "Konami VRC6", /* mapper name */
    map24_init, /* init routine */
    NULL, /* vblank callback */
-   map24_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    map24_getstate, /* get state (snss) */
    map24_setstate, /* set state (snss) */
    NULL, /* memory read structure */
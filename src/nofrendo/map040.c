@@ -28,14 +28,23 @@
 #include "nes.h"
 #include "libsnss.h"
 #include "log.h"
+#include "nes_sched.h"
 
-#define  MAP40_IRQ_PERIOD  (4096 / 113.666666)
+/* the IRQ comes 4096 CPU cycles after it is enabled */
+#define  MAP40_IRQ_CYCLES  4096
 
 static struct
 {
-   int enabled, counter;
+   int enabled, counter;   /* counter in CPU cycles */
 } irq;
 
+static void map40_irq(void)
+{
+   irq.counter = 0;
+   nes_irq();
+   irq.enabled = false;
+}
+
 /* mapper 40: SMB 2j (hack) */
 static void map40_init(void)
 {
@@ -45,22 +54,8 @@ static void map40_init(void)
    mmc_bankrom(8, 0xE000, 7);
 
    irq.enabled = false;
-   irq.counter = (int) MAP40_IRQ_PERIOD;
-}
-
-static void map40_hblank(int vblank)
-{
-   UNUSED(vblank);
-
-   if (irq.enabled && irq.counter)
-   {
-      irq.counter--;
-      if (0 == irq.counter)
-      {
-         nes_irq();
-         irq.enabled = false;
-      }
-   }
+   irq.counter = MAP40_IRQ_CYCLES;
+   sched_cancel(SCHED_MAPPER);
 }
 
 static void map40_write(uint32 address, uint8 value)
@@ -70,11 +65,15 @@ static void map40_write(uint32 address, uint8 value)
    switch (range)
    {
    case 0: /* 0x8000-0x9FFF */
+      nes_irq_ack();
       irq.enabled = false;
-      irq.counter = (int) MAP40_IRQ_PERIOD;
+      irq.counter = MAP40_IRQ_CYCLES;
+      sched_cancel(SCHED_MAPPER);
       break;
 
    case 1: /* 0xA000-0xBFFF */
+      if (!irq.enabled && irq.counter)
+         sched_in(SCHED_MAPPER, irq.counter, map40_irq);
       irq.enabled = true;
       break;
 
@@ -87,16 +86,23 @@ static void map40_write(uint32 address, uint8 value)
    }
 }
 
+/* the snapshot keeps the counter in scanlines */
 static void map40_getstate(SnssMapperBlock *state)
 {
-   state->extraData.mapper40.irqCounter = irq.counter;
+   if (irq.enabled)
+      irq.counter = sched_left(SCHED_MAPPER);
+   state->extraData.mapper40.irqCounter = (irq.counter * 3 + 340) / 341;
    state->extraData.mapper40.irqCounterEnabled = irq.enabled;
 }
 
 static void map40_setstate(SnssMapperBlock *state)
 {
-   irq.counter = state->extraData.mapper40.irqCounter;
+   irq.counter = state->extraData.mapper40.irqCounter * 341 / 3;
    irq.enabled = state->extraData.mapper40.irqCounterEnabled;
+   if (irq.enabled && irq.counter)
+      sched_in(SCHED_MAPPER, irq.counter, map40_irq);
+   else
+      sched_cancel(SCHED_MAPPER);
 }
 
 static map_memwrite map40_memwrite[] =
@@ -111,7 +117,7 @@ mapintf_t map40_intf =
    "SMB 2j (pirate)", /* mapper name */
    map40_init, /* init routine */
    NULL, /* vblank callback */
-   map40_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    map40_getstate, /* get state (snss) */
    map40_setstate, /* set state (snss) */
    NULL, /* memory read structure */
@@ -31,11 +31,14 @@
 #include "nes.h"
 #include "libsnss.h"
 #include "log.h"
+#include "nes_sched.h"
+
+/* IRQ is triggered after 24576 M2 cycles */
+#define MAP42_IRQ_CYCLES 0x6000
 
 static struct
 {
   bool enabled;
-  uint32 counter;
 } irq;
 
 /********************************/
@@ -45,7 +48,7 @@ static void map42_irq_reset (void)
 {
   /* Turn off IRQs */
   irq.enabled = false;
-  irq.counter = 0x0000;
+  sched_cancel (SCHED_MAPPER);
 
   /* Done */
   return;
@@ -69,32 +72,19 @@ static void map42_init (void)
   return;
 }
 
-/****************************************/
-/* Mapper #42 callback for IRQ handling */
-/****************************************/
-static void map42_hblank (int vblank)
+/*********************************************/
+/* Mapper #42 scheduled event: counter strike */
+/*********************************************/
+static void map42_irq (void)
 {
-   /* Counter is M2 based so it doesn't matter whether */
-   /* the PPU is in its VBlank period or not           */
-   UNUSED(vblank);
-
-   /* Increment the counter if it is enabled and check for strike */
-   if (irq.enabled)
-   {
-     /* Is there a constant for cycles per scanline? */
-     /* If so, someone ought to substitute it here   */
-     irq.counter = irq.counter + 114;
-
-     /* IRQ is triggered after 24576 M2 cycles */
-     if (irq.counter >= 0x6000)
-     {
-       /* Trigger the IRQ */
-       nes_irq ();
-
-       /* Reset the counter */
-       map42_irq_reset ();
-     }
-   }
+  /* Trigger the IRQ */
+  nes_irq ();
+
+  /* Reset the counter */
+  irq.enabled = false;
+
+  /* Done */
+  return;
 }
 
 /******************************************/
@@ -114,8 +104,18 @@ static void map42_write (uint32 address, uint8 value)
                break;
 
     /* Register 2: IRQ */
-    case 0x02: if (value & 0x02) irq.enabled = true;
-               else              map42_irq_reset ();
+    case 0x02: if (value & 0x02)
+               {
+                 /* Counter is M2 based, so start counting now */
+                 if (!irq.enabled)
+                   sched_in (SCHED_MAPPER, MAP42_IRQ_CYCLES, map42_irq);
+                 irq.enabled = true;
+               }
+               else
+               {
+                 nes_irq_ack ();
+                 map42_irq_reset ();
+               }
                break;
 
     /* Register 3: unused */
@@ -129,10 +129,17 @@ static void map42_write (uint32 address, uint8 value)
 /****************************************************/
 /* Shove extra mapper information into a SNSS block */
 /****************************************************/
-static void map42_setstate (SnssMapperBlock *state)
+static void map42_getstate (SnssMapperBlock *state)
 {
-  /* TODO: Store SNSS information */
-  UNUSED (state);
+  uint32 counter = 0x0000;
+
+  /* The counter is the M2 cycles gone since it was enabled */
+  if (irq.enabled)
+    counter = MAP42_IRQ_CYCLES - sched_left (SCHED_MAPPER);
+
+  state->extraData.mapper42.irqCounterLowByte = counter & 0xFF;
+  state->extraData.mapper42.irqCounterHighByte = counter >> 8;
+  state->extraData.mapper42.irqCounterEnabled = irq.enabled;
 
   /* Done */
   return;
@@ -141,10 +148,16 @@ static void map42_setstate (SnssMapperBlock *state)
 /*****************************************************/
 /* Pull extra mapper information out of a SNSS block */
 /*****************************************************/
-static void map42_getstate (SnssMapperBlock *state)
+static void map42_setstate (SnssMapperBlock *state)
 {
-  /* TODO: Retrieve SNSS information */
-  UNUSED (state);
+  uint32 counter = state->extraData.mapper42.irqCounterLowByte
+                 | (state->extraData.mapper42.irqCounterHighByte << 8);
+
+  irq.enabled = state->extraData.mapper42.irqCounterEnabled ? true : false;
+  if (irq.enabled && counter < MAP42_IRQ_CYCLES)
+    sched_in (SCHED_MAPPER, MAP42_IRQ_CYCLES - counter, map42_irq);
+  else
+    map42_irq_reset ();
 
   /* Done */
   return;
@@ -162,7 +175,7 @@ mapintf_t map42_intf =
    "Baby Mario (bootleg)",           /* Mapper name */
    map42_init,                       /* Initialization routine */
    NULL,                             /* VBlank callback */
-   map42_hblank,                     /* HBlank callback */
+   NULL,                             /* HBlank callback */
    map42_getstate,                   /* Get state (SNSS) */
    map42_setstate,                   /* Set state (SNSS) */
    NULL,                             /* Memory read structure */
@@ -31,11 +31,14 @@
 #include "nes.h"
 #include "libsnss.h"
 #include "log.h"
+#include "nes_sched.h"
+
+/* IRQ line is hooked to Q12 of the M2 counter */
+#define MAP50_IRQ_CYCLES 0x1000
 
 static struct
 {
   bool enabled;
-  uint32 counter;
 } irq;
 
 /********************************/
@@ -45,7 +48,7 @@ static void map50_irq_reset (void)
 {
   /* Turn off IRQs */
   irq.enabled = false;
-  irq.counter = 0x0000;
+  sched_cancel (SCHED_MAPPER);
 
   /* Done */
   return;
@@ -69,32 +72,19 @@ static void map50_init (void)
   return;
 }
 
-/****************************************/
-/* Mapper #50 callback for IRQ handling */
-/****************************************/
-static void map50_hblank (int vblank)
+/*********************************************/
+/* Mapper #50 scheduled event: counter strike */
+/*********************************************/
+static void map50_irq (void)
 {
-   /* Counter is M2 based so it doesn't matter whether */
-   /* the PPU is in its VBlank period or not           */
-   UNUSED(vblank);
-
-   /* Increment the counter if it is enabled and check for strike */
-   if (irq.enabled)
-   {
-     /* Is there a constant for cycles per scanline? */
-     /* If so, someone ought to substitute it here   */
-     irq.counter = irq.counter + 114;
-
-     /* IRQ line is hooked to Q12 of the counter */
-     if (irq.counter & 0x1000)
-     {
-       /* Trigger the IRQ */
-       nes_irq ();
-
-       /* Reset the counter */
-       map50_irq_reset ();
-     }
-   }
+  /* Trigger the IRQ */
+  nes_irq ();
+
+  /* Reset the counter */
+  irq.enabled = false;
+
+  /* Done */
+  return;
 }
 
 /******************************************/
@@ -112,8 +102,18 @@ static void map50_write (uint32 address, uint8 value)
   if (address & 0x100)
   {
     /* IRQ settings */
-    if (value & 0x01) irq.enabled = true;
-    else              map50_irq_reset ();
+    if (value & 0x01)
+    {
+      /* Counter is M2 based, so start counting now */
+      if (!irq.enabled)
+        sched_in (SCHED_MAPPER, MAP50_IRQ_CYCLES, map50_irq);
+      irq.enabled = true;
+    }
+    else
+    {
+      nes_irq_ack ();
+      map50_irq_reset ();
+    }
   }
   else
   {
@@ -133,10 +133,17 @@ static void map50_write (uint32 address, uint8 value)
 /****************************************************/
 /* Shove extra mapper information into a SNSS block */
 /****************************************************/
-static void map50_setstate (SnssMapperBlock *state)
+static void map50_getstate (SnssMapperBlock *state)
 {
-  /* TODO: Store SNSS information */
-  UNUSED (state);
+  uint32 counter = 0x0000;
+
+  /* The counter is the M2 cycles gone since it was enabled */
+  if (irq.enabled)
+    counter = MAP50_IRQ_CYCLES - sched_left (SCHED_MAPPER);
+
+  state->extraData.mapper50.irqCounterLowByte = counter & 0xFF;
+  state->extraData.mapper50.irqCounterHighByte = counter >> 8;
+  state->extraData.mapper50.irqCounterEnabled = irq.enabled;
 
   /* Done */
   return;
@@ -145,10 +152,16 @@ static void map50_setstate (SnssMapperBlock *state)
 /*****************************************************/
 /* Pull extra mapper information out of a SNSS block */
 /*****************************************************/
-static void map50_getstate (SnssMapperBlock *state)
+static void map50_setstate (SnssMapperBlock *state)
 {
-  /* TODO: Retrieve SNSS information */
-  UNUSED (state);
+  uint32 counter = state->extraData.mapper50.irqCounterLowByte
+                 | (state->extraData.mapper50.irqCounterHighByte << 8);
+
+  irq.enabled = state->extraData.mapper50.irqCounterEnabled ? true : false;
+  if (irq.enabled && counter < MAP50_IRQ_CYCLES)
+    sched_in (SCHED_MAPPER, MAP50_IRQ_CYCLES - counter, map50_irq);
+  else
+    map50_irq_reset ();
 
   /* Done */
   return;
@@ -166,7 +179,7 @@ mapintf_t map50_intf =
    "SMB2j (3rd discovered variant)", /* Mapper name */
    map50_init,                       /* Initialization routine */
    NULL,                             /* VBlank callback */
-   map50_hblank,                     /* HBlank callback */
+   NULL,                             /* HBlank callback */
    map50_getstate,                   /* Get state (SNSS) */
    map50_setstate,                   /* Set state (SNSS) */
    NULL,                             /* Memory read structure */
@@ -30,6 +30,7 @@
 #include "nes.h"
 #include "libsnss.h"
 #include "log.h"
+#include "nes_sched.h"
 
 static struct
 {
@@ -45,40 +46,52 @@ static void map73_init (void)
   /* Turn off IRQs */
   irq.enabled = false;
   irq.counter = 0x0000;
+  sched_cancel (SCHED_MAPPER);
 
   /* Done */
   return;
 }
 
-/****************************************/
-/* Mapper #73 callback for IRQ handling */
-/****************************************/
-static void map73_hblank (int vblank)
+/*********************************************/
+/* Mapper #73 scheduled event: counter strike */
+/*********************************************/
+static void map73_irq (void)
 {
-   /* Counter is M2 based so it doesn't matter whether */
-   /* the PPU is in its VBlank period or not           */
-   UNUSED (vblank);
-
-   /* Increment the counter if it is enabled and check for strike */
-   if (irq.enabled)
-   {
-     /* Is there a constant for cycles per scanline? */
-     /* If so, someone ought to substitute it here   */
-     irq.counter = irq.counter + 114;
-
-     /* Counter triggered on overflow into Q16 */
-     if (irq.counter & 0x10000)
-     {
-       /* Clip to sixteen-bit word */
-       irq.counter &= 0xFFFF;
-
-       /* Trigger the IRQ */
-       nes_irq ();
-
-       /* Shut off IRQ counter */
-       irq.enabled = false;
-     }
-   }
+  /* Counter triggered on overflow into Q16 */
+  irq.counter = 0x0000;
+
+  /* Trigger the IRQ */
+  nes_irq ();
+
+  /* Shut off IRQ counter */
+  irq.enabled = false;
+
+  /* Done */
+  return;
+}
+
+/*******************************************************/
+/* Mapper #73 counter update: it counts M2 cycles, so  */
+/* only its overflow is scheduled while it is enabled  */
+/*******************************************************/
+static void map73_sync (void)
+{
+  if (irq.enabled)
+    irq.counter = 0x10000 - sched_left (SCHED_MAPPER);
+
+  /* Done */
+  return;
+}
+
+static void map73_schedule (void)
+{
+  if (irq.enabled)
+    sched_in (SCHED_MAPPER, 0x10000 - (irq.counter & 0xFFFF), map73_irq);
+  else
+    sched_cancel (SCHED_MAPPER);
+
+  /* Done */
+  return;
 }
 
 /******************************************/
@@ -86,6 +99,8 @@ static void map73_hblank (int vblank)
 /******************************************/
 static void map73_write (uint32 address, uint8 value)
 {
+  map73_sync ();
+
   switch (address & 0xF000)
   {
     case 0x8000: irq.counter &= 0xFFF0;
@@ -102,11 +117,14 @@ static void map73_write (uint32 address, uint8 value)
                  break;
     case 0xC000: if (value & 0x02) irq.enabled = true;
                  else              irq.enabled = false;
+                 nes_irq_ack ();
                  break;
     case 0xF000: mmc_bankrom (16, 0x8000, value);
     default:     break;
   }
 
+  map73_schedule ();
+
   /* Done */
   return;
 }
@@ -114,10 +132,13 @@ static void map73_write (uint32 address, uint8 value)
 /****************************************************/
 /* Shove extra mapper information into a SNSS block */
 /****************************************************/
-static void map73_setstate (SnssMapperBlock *state)
+static void map73_getstate (SnssMapperBlock *state)
 {
-  /* TODO: Store SNSS information */
-  UNUSED (state);
+  map73_sync ();
+
+  state->extraData.mapper73.irqCounterLowByte = irq.counter & 0xFF;
+  state->extraData.mapper73.irqCounterHighByte = (irq.counter >> 8) & 0xFF;
+  state->extraData.mapper73.irqCounterEnabled = irq.enabled;
 
   /* Done */
   return;
@@ -126,10 +147,13 @@ static void map73_setstate (SnssMapperBlock *state)
 /*****************************************************/
 /* Pull extra mapper information out of a SNSS block */
 /*****************************************************/
-static void map73_getstate (SnssMapperBlock *state)
+static void map73_setstate (SnssMapperBlock *state)
 {
-  /* TODO: Retrieve SNSS information */
-  UNUSED (state);
+  irq.counter = state->extraData.mapper73.irqCounterLowByte
+              | (state->extraData.mapper73.irqCounterHighByte << 8);
+  irq.enabled = state->extraData.mapper73.irqCounterEnabled ? true : false;
+
+  map73_schedule ();
 
   /* Done */
   return;
@@ -147,7 +171,7 @@ mapintf_t map73_intf =
    "Konami VRC3",                    /* Mapper name */
    map73_init,                       /* Initialization routine */
    NULL,                             /* VBlank callback */
-   map73_hblank,                     /* HBlank callback */
+   NULL,                             /* HBlank callback */
    map73_getstate,                   /* Get state (SNSS) */
    map73_setstate,                   /* Set state (SNSS) */
    NULL,                             /* Memory read structure */
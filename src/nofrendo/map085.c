@@ -27,13 +27,8 @@
 #include "nes_mmc.h"
 #include "nes.h"
 #include "log.h"
-
-static struct
-{
-   int counter, latch;
-   int wait_state;
-   bool enabled;
-} irq;
+#include "vrcirq.h"
+#include "vrc7_snd.h"
 
 /* mapper 85: Konami VRC7 */
 static void map85_write(uint32 address, uint8 value)
@@ -51,7 +46,7 @@ static void map85_write(uint32 address, uint8 value)
       break;
 
    case 0x09:
-      /* 0x10 & 0x30 should be trapped by sound emulation */
+      /* $9010 and $9030 are trapped by the sound emulation */
       mmc_bankrom(8, 0xC000, value);
       break;
 
@@ -86,7 +81,7 @@ static void map85_write(uint32 address, uint8 value)
    case 0x0E:
       if (0x10 == reg)
       {
-         irq.latch = value;
+         vrcirq_latch(value);
       }
       else
       {
@@ -113,16 +108,9 @@ static void map85_write(uint32 address, uint8 value)
 
    case 0x0F:
       if (0x10 == reg)
-      {
-         irq.enabled = irq.wait_state;
-      }
+         vrcirq_ack();
       else
-      {
-         irq.wait_state = value & 0x01;
-         irq.enabled = (value & 0x02) ? true : false;
-         if (true == irq.enabled)
-            irq.counter = irq.latch;
-      }
+         vrcirq_control(value);
       break;
 
    default:
@@ -133,23 +121,6 @@ static void map85_write(uint32 address, uint8 value)
    }
 }
 
-static void map85_hblank(int vblank)
-{
-   UNUSED(vblank);
-
-   if (irq.enabled)
-   {
-      if (++irq.counter > 0xFF)
-      {
-         irq.counter = irq.latch;
-         nes_irq();
-
-         //return;
-      }
-      //irq.counter++;
-   }
-}
-
 static map_memwrite map85_memwrite[] =
 {
    { 0x8000, 0xFFFF, map85_write },
@@ -163,9 +134,7 @@ static void map85_init(void)
    
    mmc_bankvrom(8, 0x0000, 0);
 
-   irq.counter = irq.latch = 0;
-   irq.wait_state = 0;
-   irq.enabled = false;
+   vrcirq_reset();
 }
 
 mapintf_t map85_intf = 
@@ -174,12 +143,12 @@ mapintf_t map85_intf =
    "Konami VRC7", /* mapper name */
    map85_init, /* init routine */
    NULL, /* vblank callback */
-   map85_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    NULL, /* get state (snss) */
    NULL, /* set state (snss) */
    NULL, /* memory read structure */
    map85_memwrite, /* memory write structure */
-   NULL
+   &vrc7_ext /* external sound device */
 };
 
 /*
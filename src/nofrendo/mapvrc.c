@@ -27,6 +27,7 @@
 #include "nes_mmc.h"
 #include "nes.h"
 #include "log.h"
+#include "vrcirq.h"
 
 #define VRC_VBANK(bank, value, high) \
 { \
@@ -37,20 +38,13 @@
    mmc_bankvrom(1, (bank) << 10, (highnybbles[(bank)] << 4)+lownybbles[(bank)]); \
 }
 
-static struct
-{
-   int counter, enabled;
-   int latch, wait_state;
-} irq;
-
 static int select_c000 = 0;
 static uint8 lownybbles[8];
 static uint8 highnybbles[8];
 
 static void vrc_init(void)
 {
-   irq.counter = irq.enabled = 0;
-   irq.latch = irq.wait_state = 0;
+   vrcirq_reset();
 }
 
 static void map21_write(uint32 address, uint8 value)
@@ -128,25 +122,21 @@ static void map21_write(uint32 address, uint8 value)
    case 0xE0C0: VRC_VBANK(7,value,1); break;
 
    case 0xF000:
-      irq.latch &= 0xF0;
-      irq.latch |= (value & 0x0F);
+      vrcirq_latch_lo(value);
       break;
    case 0xF002:
    case 0xF040:
-      irq.latch &= 0x0F;
-      irq.latch |= ((value & 0x0F) << 4);
+      vrcirq_latch_hi(value);
       break;
    case 0xF004:
    case 0xF001:
    case 0xF080:
-      irq.enabled = (value >> 1) & 0x01;
-      irq.wait_state = value & 0x01;
-      irq.counter = irq.latch;
+      vrcirq_control(value);
       break;
    case 0xF006:
    case 0xF003:
    case 0xF0C0:
-      irq.enabled = irq.wait_state;
+      vrcirq_ack();
       break;
 
    default:
@@ -274,23 +264,19 @@ static void map23_write(uint32 address, uint8 value)
    case 0xE00C: VRC_VBANK(7,value,1); break;
 
    case 0xF000: 
-      irq.latch &= 0xF0;
-      irq.latch |= (value & 0x0F);
+      vrcirq_latch_lo(value);
       break;
 
    case 0xF004: 
-      irq.latch &= 0x0F;
-      irq.latch |= ((value & 0x0F) << 4);
+      vrcirq_latch_hi(value);
       break;
 
    case 0xF008:
-      irq.enabled = (value >> 1) & 0x01;
-      irq.wait_state = value & 0x01;
-      irq.counter = irq.latch;
+      vrcirq_control(value);
       break;
 
    case 0xF00C:
-      irq.enabled = irq.wait_state;
+      vrcirq_ack();
       break;
 
    default:
@@ -301,22 +287,6 @@ static void map23_write(uint32 address, uint8 value)
    }
 }
 
-static void vrc_hblank(int vblank) 
-{
-   UNUSED(vblank);
-
-   if (irq.enabled)
-   {
-      if (256 == ++irq.counter)
-      {
-         irq.counter = irq.latch;
-         nes_irq();
-         //irq.enabled = false;
-         irq.enabled = irq.wait_state;
-      }
-   }
-}
-
 
 
 static map_memwrite map21_memwrite[] =
@@ -339,14 +309,14 @@ static map_memwrite map23_memwrite[] =
 
 static void map21_getstate(SnssMapperBlock *state)
 {
-   state->extraData.mapper21.irqCounter = irq.counter;
-   state->extraData.mapper21.irqCounterEnabled = irq.enabled;
+   vrcirq_getstate(&state->extraData.mapper21.irqCounter,
+                   &state->extraData.mapper21.irqCounterEnabled);
 }
 
 static void map21_setstate(SnssMapperBlock *state)
 {
-   irq.counter = state->extraData.mapper21.irqCounter;
-   irq.enabled = state->extraData.mapper21.irqCounterEnabled;
+   vrcirq_setstate(state->extraData.mapper21.irqCounter,
+                   state->extraData.mapper21.irqCounterEnabled);
 }
 
 mapintf_t map21_intf =
@@ -355,7 +325,7 @@ mapintf_t map21_intf =
    "Konami VRC4 A", /* mapper name */
    vrc_init, /* init routine */
    NULL, /* vblank callback */
-   vrc_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    map21_getstate, /* get state (snss) */
    map21_setstate, /* set state (snss) */
    NULL, /* memory read structure */
@@ -383,7 +353,7 @@ mapintf_t map23_intf =
    "Konami VRC2 B", /* mapper name */
    vrc_init, /* init routine */
    NULL, /* vblank callback */
-   vrc_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    NULL, /* get state (snss) */
    NULL, /* set state (snss) */
    NULL, /* memory read structure */
@@ -395,9 +365,9 @@ mapintf_t map25_intf =
 {
    25, /* mapper number */
    "Konami VRC4 B", /* mapper name */
-   NULL, /* init routine */
+   vrc_init, /* init routine */
    NULL, /* vblank callback */
-   vrc_hblank, /* hblank callback */
+   NULL, /* hblank callback */
    NULL, /* get state (snss) */
    NULL, /* set state (snss) */
    NULL, /* memory read structure */
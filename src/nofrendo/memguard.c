@@ -36,6 +36,7 @@
 #include "string.h"
 #include "stdlib.h"
 #include "log.h"
+#include "../title_arena.h"
 
 
 /* Maximum number of allocated blocks at any one time */
@@ -328,13 +329,13 @@ char *_my_strdup(const char *string, char *file, int line)
 
 #else /* !NOFRENDO_DEBUG */
 
-/* allocates memory and clears it */
+/* allocates memory, from the title arena while a cart is loading */
 void *_my_malloc(int size)
 {
    void *temp;
    char fail[256];
-    printf("MALLOC %d\n",size);
-   temp = malloc(size);
+
+   temp = arena_alloc(size, ARENA_INTERNAL);
 
    if (NULL == temp)
    {
@@ -345,18 +346,13 @@ void *_my_malloc(int size)
    return temp;
 }
 
-/* free a pointer allocated with my_malloc */
+/* free a pointer allocated with my_malloc, arena blocks go with the title */
 void _my_free(void **data)
 {
-   char fail[256];
-
    if (NULL == data || NULL == *data)
-   {
-      sprintf(fail, "free: attempted to free NULL pointer.\n");
-      ASSERT_MSG(fail);
-   }
+      return;
 
-   free(*data);
+   arena_free(*data);
    *data = NULL; /* NULL our source */
 }
 
@@ -26,6 +26,10 @@
 #ifndef  _MEMGUARD_H_
 #define  _MEMGUARD_H_
 
+/* pull these in before the macros below can mangle their prototypes */
+#include <stdlib.h>
+#include <string.h>
+
 #ifdef strdup
 #undef strdup
 #endif
@@ -42,10 +46,13 @@ extern char *_my_strdup(const char *string, char *file, int line);
 
 #else /* !NORFRENDO_DEBUG */
 
-/* Non-debugging versions of calls */
-//#define  malloc(s)   _my_malloc((s))
-//#define  free(d)     _my_free((void **) &(d))
-//#define  strdup(s)   _my_strdup((s))
+/* Non-debugging versions of calls, backed by the per-title arena.
+** C++ glue that includes our headers keeps the real allocator. */
+#ifndef __cplusplus
+#define  malloc(s)   _my_malloc((s))
+#define  free(d)     _my_free((void **) &(d))
+#define  strdup(s)   _my_strdup((s))
+#endif /* !__cplusplus */
 
 extern void *_my_malloc(int size);
 extern void _my_free(void **data);
@@ -103,10 +103,15 @@ static struct
 } mmc5;
 
 
-#define  MMC5_RECTANGLE_OUTPUT   chan->output_vol
-static int32 mmc5_rectangle(mmc5rectangle_t *chan)
+static void mmc5_rectangle(mmc5rectangle_t *chan, int32 *buffer, int num_samples)
 {
    int32 output;
+   int32 output_vol = chan->output_vol;
+   int32 env_phase = chan->env_phase;
+   uint8 env_vol = chan->env_vol;
+   int vbl_length = chan->vbl_length;
+   float accum = chan->accum;
+   uint8 adder = chan->adder;
 
 #ifdef APU_OVERSAMPLE
    int num_times;
@@ -119,73 +124,87 @@ static int32 mmc5_rectangle(mmc5rectangle_t *chan)
    ** reg3: 0-2=high freq, 7-4=vbl length counter
    */
 
-   APU_VOLUME_DECAY(chan->output_vol);
-
-   if (false == chan->enabled || 0 == chan->vbl_length)
-      return MMC5_RECTANGLE_OUTPUT;
-
-   /* vbl length counter */
-   if (false == chan->holdnote)
-      chan->vbl_length--;
-
-   /* envelope decay at a rate of (env_delay + 1) / 240 secs */
-   chan->env_phase -= 4; /* 240/60 */
-   while (chan->env_phase < 0)
+   for (; num_samples && chan->enabled && vbl_length; num_samples--)
    {
-      chan->env_phase += chan->env_delay;
+      APU_VOLUME_DECAY(output_vol);
 
-      if (chan->holdnote)
-         chan->env_vol = (chan->env_vol + 1) & 0x0F;
-      else if (chan->env_vol < 0x0F)
-         chan->env_vol++;
-   }
+      /* vbl length counter */
+      if (false == chan->holdnote)
+         vbl_length--;
 
-   if (chan->freq < 4)
-      return MMC5_RECTANGLE_OUTPUT;
+      /* envelope decay at a rate of (env_delay + 1) / 240 secs */
+      env_phase -= 4; /* 240/60 */
+      while (env_phase < 0)
+      {
+         env_phase += chan->env_delay;
 
-   chan->accum -= mmc5.incsize; /* # of cycles per sample */
-   if (chan->accum >= 0)
-      return MMC5_RECTANGLE_OUTPUT;
+         if (chan->holdnote)
+            env_vol = (env_vol + 1) & 0x0F;
+         else if (env_vol < 0x0F)
+            env_vol++;
+      }
 
+      if (chan->freq >= 4)
+      {
+         accum -= mmc5.incsize; /* # of cycles per sample */
+         if (accum < 0)
+         {
 #ifdef APU_OVERSAMPLE
-   num_times = total = 0;
+            num_times = total = 0;
 
-   if (chan->fixed_envelope)
-      output = chan->volume << 8; /* fixed volume */
-   else
-      output = (chan->env_vol ^ 0x0F) << 8;
+            if (chan->fixed_envelope)
+               output = chan->volume << 8; /* fixed volume */
+            else
+               output = (env_vol ^ 0x0F) << 8;
 #endif
 
-   while (chan->accum < 0)
-   {
-      chan->accum += chan->freq;
-      chan->adder = (chan->adder + 1) & 0x0F;
+            while (accum < 0)
+            {
+               accum += chan->freq;
+               adder = (adder + 1) & 0x0F;
 
 #ifdef APU_OVERSAMPLE
-      if (chan->adder < chan->duty_flip)
-         total += output;
-      else
-         total -= output;
+               if (adder < chan->duty_flip)
+                  total += output;
+               else
+                  total -= output;
 
-      num_times++;
+               num_times++;
 #endif
-   }
+            }
 
 #ifdef APU_OVERSAMPLE
-   chan->output_vol = total / num_times;
+            output_vol = total / num_times;
 #else
-   if (chan->fixed_envelope)
-      output = chan->volume << 8; /* fixed volume */
-   else
-      output = (chan->env_vol ^ 0x0F) << 8;
-
-   if (0 == chan->adder)
-      chan->output_vol = output;
-   else if (chan->adder == chan->duty_flip)
-      chan->output_vol = -output;
+            if (chan->fixed_envelope)
+               output = chan->volume << 8; /* fixed volume */
+            else
+               output = (env_vol ^ 0x0F) << 8;
+
+            if (0 == adder)
+               output_vol = output;
+            else if (adder == chan->duty_flip)
+               output_vol = -output;
 #endif
+         }
+      }
+
+      *buffer++ += output_vol;
+   }
+
+   /* silent (or stopped mid-block): just let the output decay */
+   while (num_samples--)
+   {
+      APU_VOLUME_DECAY(output_vol);
+      *buffer++ += output_vol;
+   }
 
-   return MMC5_RECTANGLE_OUTPUT;
+   chan->output_vol = output_vol;
+   chan->env_phase = env_phase;
+   chan->env_vol = env_vol;
+   chan->vbl_length = vbl_length;
+   chan->accum = accum;
+   chan->adder = adder;
 }
 
 static uint8 mmc5_read(uint32 address)
@@ -207,17 +226,18 @@ static uint8 mmc5_read(uint32 address)
    }
 }
 
-/* mix vrcvi sound channels together */
-static int32 mmc5_process(void)
+/* mix mmc5 sound channels into a block of samples */
+static void mmc5_process(int32 *buffer, int num_samples)
 {
-   int32 accum;
+   int i;
 
-   accum = mmc5_rectangle(&mmc5.rect[0]);
-   accum += mmc5_rectangle(&mmc5.rect[1]);
+   mmc5_rectangle(&mmc5.rect[0], buffer, num_samples);
+   mmc5_rectangle(&mmc5.rect[1], buffer, num_samples);
    if (mmc5.dac.enabled)
-      accum += mmc5.dac.output;
-
-   return accum;
+   {
+      for (i = 0; i < num_samples; i++)
+         buffer[i] += mmc5.dac.output;
+   }
 }
 
 /* write to registers */
@@ -374,9 +394,10 @@ apuext_t mmc5_ext =
    mmc5_init,
    NULL, /* no shutdown */
    mmc5_reset,
-   mmc5_process,
+   NULL, /* block output only */
    mmc5_memread,
-   mmc5_memwrite
+   mmc5_memwrite,
+   mmc5_process
 };
 
 /*
@@ -25,81 +25,61 @@
 
 #include "noftypes.h"
 #include "nes_mmc.h"
+#include "mmclist.h"
+
+/* implemented mappers and what they need from the rest of the machine.
+** caps must agree with the interface: MMC_CAP_HBLANK with a hblank
+** routine, MMC_CAP_SOUND with a sound_ext, and the PPU hooks with what
+** the mapper's init/writes install.
+*/
+#define  MAPPER_LIST(M) \
+   M(0,   0) \
+   M(1,   0) \
+   M(2,   0) \
+   M(3,   0) \
+   M(4,   MMC_CAP_HBLANK | MMC_CAP_A12 | MMC_CAP_WRAM) \
+   M(5,   MMC_CAP_HBLANK | MMC_CAP_SOUND) \
+   M(7,   0) \
+   M(8,   0) \
+   M(9,   MMC_CAP_LATCH) \
+   M(11,  0) \
+   M(15,  0) \
+   M(16,  0) \
+   M(18,  0) \
+   M(19,  0) \
+   M(21,  0) \
+   M(22,  0) \
+   M(23,  0) \
+   M(24,  MMC_CAP_SOUND) \
+   M(25,  0) \
+   M(32,  0) \
+   M(33,  0) \
+   M(34,  0) \
+   M(40,  0) \
+   M(42,  0) \
+   M(50,  0) \
+   M(64,  MMC_CAP_HBLANK) \
+   M(65,  0) \
+   M(66,  0) \
+   M(70,  0) \
+   M(73,  0) \
+   M(75,  0) \
+   M(78,  0) \
+   M(79,  0) \
+   M(85,  MMC_CAP_SOUND) \
+   M(94,  0) \
+   M(99,  MMC_CAP_VROMSWITCH) \
+   M(231, 0)
 
 /* mapper interfaces */
-extern mapintf_t map0_intf;
-extern mapintf_t map1_intf;
-extern mapintf_t map2_intf;
-extern mapintf_t map3_intf;
-extern mapintf_t map4_intf;
-extern mapintf_t map5_intf;
-extern mapintf_t map7_intf;
-extern mapintf_t map8_intf;
-extern mapintf_t map9_intf;
-extern mapintf_t map11_intf;
-extern mapintf_t map15_intf;
-extern mapintf_t map16_intf;
-extern mapintf_t map18_intf;
-extern mapintf_t map19_intf;
-extern mapintf_t map21_intf;
-extern mapintf_t map22_intf;
-extern mapintf_t map23_intf;
-extern mapintf_t map24_intf;
-extern mapintf_t map25_intf;
-extern mapintf_t map32_intf;
-extern mapintf_t map33_intf;
-extern mapintf_t map34_intf;
-extern mapintf_t map40_intf;
-extern mapintf_t map64_intf;
-extern mapintf_t map65_intf;
-extern mapintf_t map66_intf;
-extern mapintf_t map70_intf;
-extern mapintf_t map75_intf;
-extern mapintf_t map78_intf;
-extern mapintf_t map79_intf;
-extern mapintf_t map85_intf;
-extern mapintf_t map94_intf;
-extern mapintf_t map99_intf;
-extern mapintf_t map231_intf;
+#define  MAPPER_EXTERN(num, caps)   extern mapintf_t map##num##_intf;
+MAPPER_LIST(MAPPER_EXTERN)
 
-/* implemented mapper interfaces */
-const mapintf_t *mappers[] =
+/* implemented mapper interfaces, by number */
+#define  MAPPER_ENTRY(num, caps)    [num] = { &map##num##_intf, (caps) },
+const mapentry_t mmc_registry[MMC_MAX_MAPPERS] =
 {
-   &map0_intf,
-   &map1_intf,
-   &map2_intf,
-   &map3_intf,
-   &map4_intf,
-   &map5_intf,
-   &map7_intf,
-   &map8_intf,
-   &map9_intf,
-   &map11_intf,
-   &map15_intf,
-   &map16_intf,
-   &map18_intf,
-   &map19_intf,
-   &map21_intf,
-   &map22_intf,
-   &map23_intf,
-   &map24_intf,
-   &map25_intf,
-   &map32_intf,
-   &map33_intf,
-   &map34_intf,
-   &map40_intf,
-   &map64_intf,
-   &map65_intf,
-   &map66_intf,
-   &map70_intf,
-   &map75_intf,
-   &map78_intf,
-   &map79_intf,
-   &map85_intf,
-   &map94_intf,
-   &map99_intf,
-   &map231_intf,
-   NULL
+   MAPPER_LIST(MAPPER_ENTRY)
 };
 
 /*
@@ -28,7 +28,16 @@
 
 #include "nes_mmc.h"
 
-extern mapintf_t *mappers[];
+#define  MMC_MAX_MAPPERS   256
+
+/* registry entry, indexed by iNES mapper number */
+typedef struct mapentry_s
+{
+   mapintf_t *intf;     /* NULL if the mapper isn't implemented */
+   int caps;            /* MMC_CAP_xxx */
+} mapentry_t;
+
+extern const mapentry_t mmc_registry[MMC_MAX_MAPPERS];
 
 #endif /* !_MMCLIST_H_ */
 
@@ -36,8 +36,11 @@
 #include "nes_ppu.h"
 #include "nes_rom.h"
 #include "nes_mmc.h"
+#include "nes_sched.h"
+#include "wram.h"
 #include "vid_drv.h"
 #include "nofrendo.h"
+#include "../perf_counters.h"
 
 
 
@@ -260,24 +263,20 @@ static uint8 nes_clearfiq(void)
    return 0;
 }
 
-void nes_setfiq(uint8 value)
+static void nes_fiq(void)
 {
-   nes.fiq_state = value;
-   nes.fiq_cycles = (int) NES_FIQ_PERIOD;
+   sched_at(SCHED_FIQ, sched_when(SCHED_FIQ) + (int) NES_FIQ_PERIOD, nes_fiq);
+   if (0 == (nes.fiq_state & 0xC0))
+   {
+      nes.fiq_occurred = true;
+      nes6502_irq();
+   }
 }
 
-static void nes_checkfiq(int cycles)
+void nes_setfiq(uint8 value)
 {
-   nes.fiq_cycles -= cycles;
-   if (nes.fiq_cycles <= 0)
-   {
-      nes.fiq_cycles += (int) NES_FIQ_PERIOD;
-      if (0 == (nes.fiq_state & 0xC0))
-      {
-         nes.fiq_occurred = true;
-         nes6502_irq();
-      }
-   }
+   nes.fiq_state = value;
+   sched_in(SCHED_FIQ, (int) NES_FIQ_PERIOD, nes_fiq);
 }
 
 void nes_nmi(void)
@@ -285,7 +284,18 @@ void nes_nmi(void)
    nes6502_nmi();
 }
 
-void nes_renderframe(bool draw_flag)
+static void nes_vblank(void)
+{
+   mapintf_t *mapintf = nes.mmc->intf;
+
+   ppu_checknmi();
+
+   if (mapintf->vblank)
+      mapintf->vblank();
+}
+
+/* hblank is constant for each caller, so the per-line mapper test folds away */
+INLINE void nes_runlines(bool draw_flag, bool hblank)
 {
    int elapsed_cycles;
    mapintf_t *mapintf = nes.mmc->intf;
@@ -294,29 +304,23 @@ void nes_renderframe(bool draw_flag)
    while (262 != nes.scanline)
    {
 //      ppu_scanline(nes.vidbuf, nes.scanline, draw_flag);
+      PERF_BEGIN(PERF_RENDER);
 		ppu_scanline(vid_getbuffer(), nes.scanline, draw_flag);
+      PERF_END();
 
       if (241 == nes.scanline)
       {
          /* 7-9 cycle delay between when VINT flag goes up and NMI is taken */
-         elapsed_cycles = nes6502_execute(7);
-         nes.scanline_cycles -= elapsed_cycles;
-         nes_checkfiq(elapsed_cycles);
-
-         ppu_checknmi();
-
-         if (mapintf->vblank)
-            mapintf->vblank();
+         sched_in(SCHED_NMI, 7, nes_vblank);
          in_vblank = 1;
       } 
 
-      if (mapintf->hblank)
+      if (hblank)
          mapintf->hblank(in_vblank);
 
       nes.scanline_cycles += (float) NES_SCANLINE_CYCLES;
-      elapsed_cycles = nes6502_execute((int) nes.scanline_cycles);
+      elapsed_cycles = sched_run((int) nes.scanline_cycles);
       nes.scanline_cycles -= (float) elapsed_cycles;
-      nes_checkfiq(elapsed_cycles);
 
       ppu_endscanline(nes.scanline);
       nes.scanline++;
@@ -326,6 +330,14 @@ void nes_renderframe(bool draw_flag)
    nes.scanline = 0;
 }
 
+void nes_renderframe(bool draw_flag)
+{
+   if (nes.mmc->caps & MMC_CAP_HBLANK)
+      nes_runlines(draw_flag, true);
+   else
+      nes_runlines(draw_flag, false);
+}
+
 static void system_video(bool draw)
 {
    /* TODO: hack */
@@ -360,7 +372,6 @@ void nes_emulate(void)
    last_ticks = nofrendo_ticks;
    frames_to_render = 0;
    nes.scanline_cycles = 0;
-   nes.fiq_cycles = (int) NES_FIQ_PERIOD;
 
    while (false == nes.poweroff)
    {
@@ -412,9 +423,16 @@ void nes_reset(int reset_type)
    {
       memset(nes.cpu->mem_page[0], 0, NES_RAMSIZE);
       if (nes.rominfo->vram)
+      {
          mem_trash(nes.rominfo->vram, 0x2000 * nes.rominfo->vram_banks);
+         ppu_chrdirty();
+      }
    }
 
+   /* mappers schedule their own events when they are reset */
+   sched_reset();
+   sched_in(SCHED_FIQ, (int) NES_FIQ_PERIOD, nes_fiq);
+
    apu_reset();
    ppu_reset(reset_type);
    mmc_reset();
@@ -429,8 +447,7 @@ void nes_destroy(nes_t **machine)
 {
    if (*machine)
    {
-      rom_free(&(*machine)->rominfo);
-      mmc_destroy(&(*machine)->mmc);
+      nes_ejectcart(*machine);
       ppu_destroy(&(*machine)->ppu);
       apu_destroy(&(*machine)->apu);
 //      bmp_destroy(&(*machine)->vidbuf);
@@ -481,21 +498,45 @@ int nes_insertcart(const char *filename, nes_t *machine)
    /* if there's VRAM, let the PPU know */
    if (NULL != machine->rominfo->vram)
       machine->ppu->vram_present = true;
+   ppu_setchrram(machine->rominfo->vram, 0x2000 * machine->rominfo->vram_banks);
    
-   apu_setext(machine->apu, machine->mmc->intf->sound_ext);
+   /* pick the PPU and APU paths this cart needs */
+   ppu_setmappercaps(machine->mmc->caps);
+   apu_setext(machine->apu, (machine->mmc->caps & MMC_CAP_SOUND) ? machine->mmc->intf->sound_ext : NULL);
    
    build_address_handlers(machine);
 
+   /* switchable / protectable WRAM gates $6000-$7FFF writes */
+   if (machine->mmc->caps & MMC_CAP_WRAM)
+      wram_init(machine);
+
    nes_setcontext(machine);
 
    nes_reset(HARD_RESET);
    return 0;
 
 _fail:
-   nes_destroy(&machine);
+   nes_ejectcart(machine);
    return -1;
 }
 
+/* pull the cart, flushing battery RAM and dropping everything it brought */
+void nes_ejectcart(nes_t *machine)
+{
+   if (machine->apu)
+      apu_setext(machine->apu, NULL);
+   ppu_setchrram(NULL, 0);
+   mmc_destroy(&machine->mmc);
+
+   if (machine->rominfo)
+      rom_free(&machine->rominfo);
+
+   if (machine->ppu)
+      machine->ppu->vram_present = false;
+   if (machine->cpu)
+      machine->cpu->mem_page[6] = machine->cpu->mem_page[7] = NULL;
+}
+
 
 /* Initialize NES CPU, hardware, etc. */
 nes_t *nes_create(void)
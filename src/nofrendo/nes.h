@@ -77,7 +77,6 @@ typedef struct nes_s
 
    bool fiq_occurred;
    uint8 fiq_state;
-   int fiq_cycles;
 
    int scanline;
 
@@ -104,10 +103,12 @@ extern void nes_setcontext(nes_t *machine);
 extern nes_t *nes_create(void);
 extern void nes_destroy(nes_t **machine);
 extern int nes_insertcart(const char *filename, nes_t *machine);
+extern void nes_ejectcart(nes_t *machine);
 
 extern void nes_setfiq(uint8 state);
 extern void nes_nmi(void);
 extern void nes_irq(void);
+extern void nes_irq_ack(void);
 extern void nes_emulate(void);
 
 extern void nes_reset(int reset_type);
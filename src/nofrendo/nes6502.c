@@ -74,7 +74,7 @@ uint8 ext_irq_line = 0;
 #define ABSOLUTE(address, value) \
 { \
    ABSOLUTE_ADDR(address); \
-   value = mem_readbyte(address); \
+   value = mem_readbyte(address, PC); \
 }
 
 #define ABSOLUTE_BYTE(value) \
@@ -92,7 +92,7 @@ uint8 ext_irq_line = 0;
 #define ABS_IND_X(address, value) \
 { \
    ABS_IND_X_ADDR(address); \
-   value = mem_readbyte(address); \
+   value = mem_readbyte(address, PC); \
 }
 
 #define ABS_IND_X_BYTE(value) \
@@ -105,7 +105,7 @@ uint8 ext_irq_line = 0;
 { \
    ABS_IND_X_ADDR(temp); \
    PAGE_CROSS_CHECK(temp, X); \
-   value = mem_readbyte(temp); \
+   value = mem_readbyte(temp, PC); \
 }
 
 /* Absolute indexed Y */
@@ -118,7 +118,7 @@ uint8 ext_irq_line = 0;
 #define ABS_IND_Y(address, value) \
 { \
    ABS_IND_Y_ADDR(address); \
-   value = mem_readbyte(address); \
+   value = mem_readbyte(address, PC); \
 }
 
 #define ABS_IND_Y_BYTE(value) \
@@ -131,7 +131,7 @@ uint8 ext_irq_line = 0;
 { \
    ABS_IND_Y_ADDR(temp); \
    PAGE_CROSS_CHECK(temp, Y); \
-   value = mem_readbyte(temp); \
+   value = mem_readbyte(temp, PC); \
 }
 
 /* Zero-page */
@@ -194,7 +194,7 @@ uint8 ext_irq_line = 0;
 #define INDIR_X(address, value) \
 { \
    INDIR_X_ADDR(address); \
-   value = mem_readbyte(address); \
+   value = mem_readbyte(address, PC); \
 } 
 
 #define INDIR_X_BYTE(value) \
@@ -212,7 +212,7 @@ uint8 ext_irq_line = 0;
 #define INDIR_Y(address, value) \
 { \
    INDIR_Y_ADDR(address); \
-   value = mem_readbyte(address); \
+   value = mem_readbyte(address, PC); \
 } 
 
 #define INDIR_Y_BYTE(value) \
@@ -225,7 +225,7 @@ uint8 ext_irq_line = 0;
 { \
    INDIR_Y_ADDR(temp); \
    PAGE_CROSS_CHECK(temp, Y); \
-   value = mem_readbyte(temp); \
+   value = mem_readbyte(temp, PC); \
 }
 
 
@@ -1135,6 +1135,7 @@ uint8 ext_irq_line = 0;
 /* internal CPU context */
 static nes6502_context cpu;
 static int remaining_cycles = 0; /* so we can release timeslice */
+static uint32 io_pc = 0; /* PC of the last read that went to a handler */
 /* memory region pointers */
 static uint8 *ram = NULL, *stack = NULL;
 static uint8 null_page[NES6502_BANKSIZE];
@@ -1201,8 +1202,8 @@ INLINE void bank_writebyte(register uint32 address, register uint8 value)
    cpu.mem_page[address >> NES6502_BANKSHIFT][address & NES6502_BANKMASK] = value;
 }
 
-/* read a byte of 6502 memory */
-static uint8 mem_readbyte(uint32 address)
+/* read a byte of 6502 memory, pc is just past the reading instruction */
+static uint8 mem_readbyte(uint32 address, uint32 pc)
 {
    nes6502_memread *mr;
 
@@ -1220,6 +1221,7 @@ static uint8 mem_readbyte(uint32 address)
    /* check memory range handlers */
    else
    {
+      io_pc = pc;
       for (mr = cpu.read_handler; mr->min_range != 0xFFFFFFFF; mr++)
       {
          if (address >= mr->min_range && address <= mr->max_range)
@@ -1302,6 +1304,14 @@ uint8 nes6502_getbyte(uint32 address)
    return bank_readbyte(address);
 }
 
+/* which instruction made the read a handler is answering: the PC just
+** past its operand, so it only tells instructions apart
+*/
+uint32 nes6502_getiopc(void)
+{
+   return io_pc;
+}
+
 /* get number of elapsed cycles */
 uint32 nes6502_getcycles(bool reset_flag)
 {
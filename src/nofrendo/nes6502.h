@@ -111,6 +111,7 @@ extern void nes6502_nmi(void);
 extern void nes6502_irq(void);
 extern uint8 nes6502_getbyte(uint32 address);
 extern uint32 nes6502_getcycles(bool reset_flag);
+extern uint32 nes6502_getiopc(void);
 extern void nes6502_burn(int cycles);
 extern void nes6502_release(void);
 
@@ -872,9 +872,13 @@ uint8 apu_read(uint32 address)
       out = -0x8000; \
 }
 
+/* samples mixed per pass; expansion chips render a whole pass at once */
+#define  APU_BLOCK_SAMPLES    64
+
 void apu_process(void *buffer, int num_samples)
 {
    static int32 prev_sample = 0;
+   int32 mix[APU_BLOCK_SAMPLES];
 
    int16 *buf16;
    uint8 *buf8;
@@ -887,47 +891,70 @@ void apu_process(void *buffer, int num_samples)
       buf16 = (int16 *) buffer;
       buf8 = (uint8 *) buffer;
 
-      while (num_samples--)
+      while (num_samples > 0)
       {
-         int32 next_sample, accum = 0;
-
-         if (apu.mix_enable & 0x01)
-            accum += apu_rectangle_0();
-         if (apu.mix_enable & 0x02)
-            accum += apu_rectangle_1();
-         if (apu.mix_enable & 0x04)
-            accum += apu_triangle();
-         if (apu.mix_enable & 0x08)
-            accum += apu_noise();
-         if (apu.mix_enable & 0x10)
-            accum += apu_dmc();
-         if (apu.ext && (apu.mix_enable & 0x20))
-            accum += apu.ext->process();
-
-         /* do any filtering */
-         if (APU_FILTER_NONE != apu.filter_type)
+         apuext_t *ext = NULL;
+         int i, block = num_samples;
+
+         if (block > APU_BLOCK_SAMPLES)
+            block = APU_BLOCK_SAMPLES;
+         num_samples -= block;
+
+         if (apu.mix_enable & 0x20)
+            ext = apu.ext;
+
+         for (i = 0; i < block; i++)
+         {
+            int32 accum = 0;
+
+            if (apu.mix_enable & 0x01)
+               accum += apu_rectangle_0();
+            if (apu.mix_enable & 0x02)
+               accum += apu_rectangle_1();
+            if (apu.mix_enable & 0x04)
+               accum += apu_triangle();
+            if (apu.mix_enable & 0x08)
+               accum += apu_noise();
+            if (apu.mix_enable & 0x10)
+               accum += apu_dmc();
+            if (ext && NULL == ext->process_block && NULL != ext->process)
+               accum += ext->process();
+
+            mix[i] = accum;
+         }
+
+         if (ext && NULL != ext->process_block)
+            ext->process_block(mix, block);
+
+         for (i = 0; i < block; i++)
          {
-            next_sample = accum;
+            int32 next_sample, accum = mix[i];
 
-            if (APU_FILTER_LOWPASS == apu.filter_type)
+            /* do any filtering */
+            if (APU_FILTER_NONE != apu.filter_type)
             {
-               accum += prev_sample;
-               accum >>= 1;
-            }
-            else
-               accum = (accum + accum + accum + prev_sample) >> 2;
+               next_sample = accum;
 
-            prev_sample = next_sample;
-         }
+               if (APU_FILTER_LOWPASS == apu.filter_type)
+               {
+                  accum += prev_sample;
+                  accum >>= 1;
+               }
+               else
+                  accum = (accum + accum + accum + prev_sample) >> 2;
 
-         /* do clipping */
-         CLIP_OUTPUT16(accum);
+               prev_sample = next_sample;
+            }
 
-         /* signed 16-bit output, unsigned 8-bit */
-         if (16 == apu.sample_bits)
-            *buf16++ = (int16) accum;
-         else
-            *buf8++ = (accum >> 8) ^ 0x80;
+            /* do clipping */
+            CLIP_OUTPUT16(accum);
+
+            /* signed 16-bit output, unsigned 8-bit */
+            if (16 == apu.sample_bits)
+               *buf16++ = (int16) accum;
+            else
+               *buf8++ = (accum >> 8) ^ 0x80;
+         }
       }
    }
 }
@@ -1042,6 +1069,10 @@ void apu_setext(apu_t *src_apu, apuext_t *ext)
 {
    ASSERT(src_apu);
 
+   /* let go of whatever the last cart had plugged in */
+   if (src_apu->ext && NULL != src_apu->ext->shutdown)
+      src_apu->ext->shutdown();
+
    src_apu->ext = ext;
 
    /* initialize it */
@@ -195,6 +195,8 @@ typedef struct apuext_s
    int32 (*process)(void);
    apu_memread *mem_read;
    apu_memwrite *mem_write;
+   /* adds num_samples of output to buffer; used in place of process */
+   void  (*process_block)(int32 *buffer, int num_samples);
 } apuext_t;
 
 
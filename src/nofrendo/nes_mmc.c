@@ -162,16 +162,10 @@ void mmc_bankrom(int size, uint32 address, int bank)
 /* Check to see if this mapper is supported */
 bool mmc_peek(int map_num)
 {
-   mapintf_t **map_ptr = mappers;
+   if (map_num < 0 || map_num >= MMC_MAX_MAPPERS)
+      return false;
 
-   while (NULL != *map_ptr)
-   {
-      if ((*map_ptr)->number == map_num)
-         return true;
-      map_ptr++;
-   }
-
-   return false;
+   return NULL != mmc_registry[map_num].intf;
 }
 
 static void mmc_setpages(void)
@@ -230,13 +224,12 @@ void mmc_destroy(mmc_t **nes_mmc)
 mmc_t *mmc_create(rominfo_t *rominfo)
 {
    mmc_t *temp;
-   mapintf_t **map_ptr;
-  
-   for (map_ptr = mappers; (*map_ptr)->number != rominfo->mapper_number; map_ptr++)
-   {
-      if (NULL == *map_ptr)
-         return NULL; /* Should *never* happen */
-   }
+   const mapentry_t *entry;
+
+   if (false == mmc_peek(rominfo->mapper_number))
+      return NULL; /* Should *never* happen */
+
+   entry = &mmc_registry[rominfo->mapper_number];
 
    temp = malloc(sizeof(mmc_t));
    if (NULL == temp)
@@ -244,12 +237,13 @@ mmc_t *mmc_create(rominfo_t *rominfo)
 
    memset(temp, 0, sizeof(mmc_t));
 
-   temp->intf = *map_ptr;
+   temp->intf = entry->intf;
    temp->cart = rominfo;
+   temp->caps = entry->caps;
 
    mmc_setcontext(temp);
 
-   nofrendo_log_printf("created memory mapper: %s\n", (*map_ptr)->name);
+   nofrendo_log_printf("created memory mapper: %s\n", entry->intf->name);
 
    return temp;
 }
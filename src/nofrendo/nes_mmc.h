@@ -31,6 +31,16 @@
 
 #define  MMC_LASTBANK      -1
 
+/* mapper capabilities, declared in mmclist.c so the frame loop, PPU
+** and APU can pick their code paths once when the cart is loaded
+*/
+#define  MMC_CAP_HBLANK       0x01  /* hblank routine every scanline */
+#define  MMC_CAP_LATCH        0x02  /* $FD/$FE tile latch on pattern fetches (MMC2) */
+#define  MMC_CAP_VROMSWITCH   0x04  /* $4016 writes switch VROM (VS. system) */
+#define  MMC_CAP_A12          0x08  /* watches PPU address line A12 */
+#define  MMC_CAP_SOUND        0x10  /* expansion audio */
+#define  MMC_CAP_WRAM         0x20  /* enables / protects $6000-$7FFF RAM */
+
 typedef struct
 {
    uint32 min_range, max_range;
@@ -64,6 +74,7 @@ typedef struct mmc_s
 {
    mapintf_t *intf;
    rominfo_t *cart;  /* link it back to the cart */
+   int caps;         /* MMC_CAP_xxx */
 } mmc_t;
 
 extern rominfo_t *mmc_getinfo(void);
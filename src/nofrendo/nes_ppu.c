@@ -28,10 +28,12 @@
 #include "noftypes.h"
 #include "nes_ppu.h"
 #include "nes.h"
+#include "../trace.h"
 #include "gui.h"
 #include "nes6502.h"
 #include "log.h"
 #include "nes_mmc.h"
+#include "nes_sched.h"
 
 #include "bitmap.h"
 #include "vid_drv.h"
@@ -46,7 +48,8 @@
 /* ------------------------------------------------------------------ */
 /*  Hooked PPU memory access                                          */
 /*  PPU_MEM_PTR(x)  -> pointer to the byte                            */
-/*  PPU_MEM(x)      -> l-value reference to that byte (read/write)    */
+/*  PPU_MEM(x)      -> l-value reference to that byte (read only,     */
+/*                     writes go through ppu_mem_store)               */
 /* ------------------------------------------------------------------ */
 #undef  PPU_MEM
 /* Accumulate PPU dots and burn 1 CPU cycle every 3 dots (~2 PPU clocks each) */
@@ -80,6 +83,208 @@ INLINE uint8 *ppu_mem_ptr(uint16 x);
 /* the NES PPU */
 static ppu_t ppu;
 
+/* ------------------------------------------------------------------ */
+/*  Address line glitch                                               */
+/*  Forcing PPU address lines low only remaps bytes within each 1K    */
+/*  page, so when the mask changes we build a shadow copy of every    */
+/*  page with the mask already applied and point reads at it. Writes  */
+/*  go to real memory and are mirrored into the shadow copies.        */
+/* ------------------------------------------------------------------ */
+static uint8 **fetch_page = ppu.page;   /* ppu.page, or glitch_page */
+static uint8 *glitch_page[16];
+static uint8 *glitch_mem = NULL;        /* 16 x 1K shadow pages */
+static uint16 glitch_mask = 0;
+
+static void glitch_build(int first, int last)
+{
+   int n, i;
+
+   for (n = first; n < last; n++)
+   {
+      uint8 *src, *dst;
+
+      if (NULL == ppu.page[n])
+      {
+         glitch_page[n] = NULL;
+         continue;
+      }
+
+      src = ppu.page[n] + (n << 10);
+      dst = glitch_mem + (n << 10);
+      for (i = 0; i < 0x400; i++)
+         dst[i] = src[i & ~glitch_mask];
+      glitch_page[n] = dst - (n << 10);
+   }
+}
+
+/* a byte of real memory changed, update every shadow page that maps it */
+static void glitch_store(uint8 *byte)
+{
+   int n;
+
+   for (n = 0; n < 16; n++)
+   {
+      uint8 *base, *dst;
+      int offset;
+
+      if (NULL == ppu.page[n])
+         continue;
+
+      base = ppu.page[n] + (n << 10);
+      if (byte < base || byte >= base + 0x400)
+         continue;
+
+      offset = byte - base;
+      if (offset & glitch_mask)
+         continue;               /* address is never fetched */
+
+      dst = glitch_mem + (n << 10);
+      dst[offset] = dst[offset | glitch_mask] = *byte;
+   }
+}
+
+static void glitch_setmask(uint16 mask)
+{
+   if (mask && NULL == glitch_mem)
+   {
+      glitch_mem = malloc(16 << 10);
+      if (NULL == glitch_mem)
+         mask = 0;
+   }
+
+   glitch_mask = mask;
+   if (glitch_mask)
+   {
+      glitch_build(0, 16);
+      fetch_page = glitch_page;
+   }
+   else
+   {
+      fetch_page = ppu.page;
+   }
+}
+
+/* page pointers changed, refresh their shadow copies */
+INLINE void glitch_remap(int first, int last)
+{
+   if (glitch_mask)
+      glitch_build(first, last);
+}
+
+/* ------------------------------------------------------------------ */
+/*  CHR-RAM pattern cache                                             */
+/*  The renderer merges a tile row's two bitplanes into one word of   */
+/*  interleaved 2 bit pixels.  For CHR-RAM that word is kept merged   */
+/*  for every row, indexed by offset into the RAM so bank switching   */
+/*  doesn't disturb it.  Stores mark their tile dirty and dirty tiles */
+/*  are merged again before the next line is drawn.  Reads through    */
+/*  the glitch shadow pages fall outside the RAM and merge directly.  */
+/* ------------------------------------------------------------------ */
+#define  MERGE_PLANES(pat1, pat2) \
+   ((((pat2) & 0xAA) << 8) | (((pat2) & 0x55) << 1) | (((pat1) & 0xAA) << 7) | ((pat1) & 0x55))
+
+static uint8 *chr_ram = NULL;
+static uint32 chr_size = 0;
+static uint16 *chr_pattern = NULL;      /* [tile * 8 + row] */
+static uint8 *chr_dirty = NULL;         /* a bit per tile */
+static bool chr_any_dirty = false;
+
+INLINE void chr_store(uint8 *byte)
+{
+   if (chr_size)
+   {
+      uint32 offset = (uint32) (byte - chr_ram);
+
+      if (offset < chr_size)
+      {
+         chr_dirty[offset >> 7] |= 1 << ((offset >> 4) & 7);
+         chr_any_dirty = true;
+      }
+   }
+}
+
+static void chr_refresh(void)
+{
+   uint32 i;
+
+   for (i = 0; i < (chr_size >> 7); i++)
+   {
+      int bit;
+
+      if (0 == chr_dirty[i])
+         continue;
+
+      for (bit = 0; bit < 8; bit++)
+      {
+         if (chr_dirty[i] & (1 << bit))
+         {
+            int tile = (i << 3) + bit;
+            const uint8 *data = chr_ram + (tile << 4);
+            uint16 *dest = chr_pattern + (tile << 3);
+            int row;
+
+            for (row = 0; row < 8; row++)
+               dest[row] = MERGE_PLANES(data[row], data[row + 8]);
+         }
+      }
+      chr_dirty[i] = 0;
+   }
+
+   chr_any_dirty = false;
+}
+
+/* merged pattern of the tile row starting at data_ptr */
+INLINE uint32 tile_pattern(const uint8 *data_ptr)
+{
+   if (chr_size)
+   {
+      uint32 offset = (uint32) (data_ptr - chr_ram);
+
+      if (offset < chr_size)
+         return chr_pattern[((offset >> 4) << 3) | (offset & 7)];
+   }
+
+   return MERGE_PLANES(data_ptr[0], data_ptr[8]);
+}
+
+/* CHR-RAM contents changed behind our back */
+void ppu_chrdirty(void)
+{
+   if (chr_size)
+   {
+      memset(chr_dirty, 0xFF, chr_size >> 7);
+      chr_any_dirty = true;
+   }
+}
+
+void ppu_setchrram(uint8 *vram, int length)
+{
+   free(chr_pattern);
+   free(chr_dirty);
+   chr_pattern = NULL;
+   chr_dirty = NULL;
+   chr_ram = vram;
+   chr_size = 0;
+   chr_any_dirty = false;
+
+   if (NULL == vram || length <= 0)
+      return;
+
+   chr_pattern = malloc(length);    /* 16 bytes per tile either way */
+   chr_dirty = malloc(length >> 7);
+   if (NULL == chr_pattern || NULL == chr_dirty)
+   {
+      free(chr_pattern);
+      free(chr_dirty);
+      chr_pattern = NULL;
+      chr_dirty = NULL;
+      return;
+   }
+
+   chr_size = length;
+   ppu_chrdirty();
+}
+
 INLINE bool is_rendering(void)
 {
     /* If your emulator counts the pre‑render line as 261 rather than -1,
@@ -124,22 +329,43 @@ INLINE void inc_v_rendering(void)
 }
 /* ---------- optional mapper callback (MMC3 edge IRQ, etc.) ---------- */
 static void (*mapper_ppu_hook)(uint16 addr) = NULL;
+static int mapper_caps = 0;      /* MMC_CAP_xxx of the loaded cart */
 
-INLINE uint8 *ppu_mem_ptr(uint16 x)
-{
-    x = ppu_glitch_addr(x);
+static void ppu_selectrender(void);
 
+INLINE void ppu_mem_access(uint16 x)
+{
     if (mapper_ppu_hook && ((x & 0x2000) == 0)) {
         ppu_fetch_delay();
         mapper_ppu_hook((uint16)(x & 0x1FFF));
     }
+}
 
-    return &ppu.page[x >> 10][x];
+INLINE uint8 *ppu_mem_ptr(uint16 x)
+{
+    ppu_mem_access(x);
+    return &fetch_page[x >> 10][x];
+}
+
+INLINE void ppu_mem_store(uint16 x, uint8 value)
+{
+    uint8 *byte = &ppu.page[x >> 10][x];
+
+    ppu_mem_access(x);
+    *byte = value;
+    chr_store(byte);
+    if (glitch_mask)
+       glitch_store(byte);
 }
 
 void ppu_set_mapper_hook(void (*fn)(uint16 addr))
 {
-    mapper_ppu_hook = fn;
+    if (0 == (mapper_caps & MMC_CAP_A12))
+        fn = NULL;      /* only A12 watchers get the per-fetch hook */
+    if (fn != mapper_ppu_hook) {
+        mapper_ppu_hook = fn;
+        ppu_selectrender();
+    }
 }
 
 void ppu_displaysprites(bool display)
@@ -174,6 +400,8 @@ void ppu_setcontext(ppu_t *src_ppu)
    ppu.page[13] = ppu.page[9] - 0x1000;
    ppu.page[14] = ppu.page[10] - 0x1000;
    ppu.page[15] = ppu.page[11] - 0x1000;
+   glitch_remap(0, 16);
+   ppu_selectrender();
 }
 
 void ppu_getcontext(ppu_t *dest_ppu)
@@ -238,6 +466,7 @@ void ppu_destroy(ppu_t **src_ppu)
 {
    if (*src_ppu)
    {
+      ppu_setchrram(NULL, 0);
       free(*src_ppu);
       *src_ppu = NULL;
    }
@@ -262,6 +491,7 @@ void ppu_setpage(int size, int page_num, uint8 *location)
       ppu.page[page_num++] = location;
       break;
    }
+   glitch_remap(page_num - size, page_num);
 }
 INLINE void ppu_notify_addr(uint16 addr)
 {
@@ -275,6 +505,7 @@ void ppu_mirrorhipages(void)
    ppu.page[13] = ppu.page[9] - 0x1000;
    ppu.page[14] = ppu.page[10] - 0x1000;
    ppu.page[15] = ppu.page[11] - 0x1000;
+   glitch_remap(12, 16);
 }
 
 void ppu_mirror(int nt1, int nt2, int nt3, int nt4)
@@ -287,6 +518,7 @@ void ppu_mirror(int nt1, int nt2, int nt3, int nt4)
    ppu.page[13] = ppu.page[9] - 0x1000;
    ppu.page[14] = ppu.page[10] - 0x1000;
    ppu.page[15] = ppu.page[11] - 0x1000;
+   glitch_remap(8, 16);
 }
 
 /* bleh, for snss */
@@ -320,6 +552,10 @@ void ppu_reset(int reset_type)
    
    ppu.latch = 0;
    ppu.vram_accessible = true;
+
+   /* the mapper installs its own again if it needs one */
+   mapper_ppu_hook = NULL;
+   ppu_selectrender();
 }
 
 /* we render a scanline of graphics first so we know exactly
@@ -399,7 +635,7 @@ void ppu_writehigh(uint32 address, uint8 value)
 
    case PPU_JOY0:
       /* VS system VROM switching - bleh!*/
-      if (ppu.vromswitch)
+      if (mapper_caps & MMC_CAP_VROMSWITCH)
          ppu.vromswitch(value);
 
       /* see if we need to strobe them joypads */
@@ -428,14 +664,11 @@ uint8 ppu_readhigh(uint32 address)
    switch (address)
    {
    case PPU_JOY0:
-      value = input_get(INP_JOYPAD0);
-      break;
-
    case PPU_JOY1:
-      /* TODO: better input handling */
-      value = input_get(INP_ZAPPER | INP_JOYPAD1 
-                        /*| INP_ARKANOID*/ 
-                        /*| INP_POWERPAD*/);
+      /* strobe held high keeps reloading the shift registers */
+      if (ppu.strobe)
+         input_strobe();
+      value = input_read(address - PPU_JOY0);
       break;
 
    default:
@@ -446,10 +679,48 @@ uint8 ppu_readhigh(uint32 address)
    return value;
 }
 
+/* $2002 read by the same instruction at the same 7 or 8 cycle spacing
+** three times running: the CPU is in a BIT/LDA + branch loop, the only
+** thing that fits in between.  Nothing it can see changes before the
+** sprite 0 hit (if pending) or the end of the CPU's slice, where vblank,
+** interrupts and mapper events come in, so burn the iterations up to there
+** and read again just before.
+*/
+static void ppu_statpoll(uint32 cycles)
+{
+   static uint32 last_cycles = 0, last_period = 0, last_pc = 0;
+   uint32 period = cycles - last_cycles;
+   uint32 pc = nes6502_getiopc();
+   int idle, until_strike;
+
+   last_cycles = cycles;
+   if (pc != last_pc || period < 7 || period > 8 || period != last_period)
+   {
+      /* a read from somewhere else starts the count again */
+      last_period = (pc == last_pc) ? period : 0;
+      last_pc = pc;
+      return;
+   }
+
+   idle = sched_slice_left();
+   until_strike = (int32) (ppu.strike_cycle - cycles);
+   if (ppu.strikeflag && until_strike > 0 && until_strike < idle)
+      idle = until_strike;
+
+   idle = (idle / (int) period - 1) * (int) period;
+   if (idle > 0)
+   {
+      nes6502_burn(idle);
+      nes6502_release();
+      last_cycles += idle;
+   }
+}
+
 /* Read from $2000-$2007 */
 uint8 ppu_read(uint32 address)
 {
     uint8 value;
+    uint32 cycles;
 
     /* mirror mask – all PPU regs repeat every 8 bytes up to $3FFF */
     switch (address & 0x2007)
@@ -459,9 +730,10 @@ uint8 ppu_read(uint32 address)
         value = (ppu.stat & 0xE0) | (ppu.latch & 0x1F);
 
         /* sprite‑0 strike check */
-        if (ppu.strikeflag &&
-            nes6502_getcycles(false) >= ppu.strike_cycle)
+        cycles = nes6502_getcycles(false);
+        if (ppu.strikeflag && cycles >= ppu.strike_cycle)
             value |= PPU_STATF_STRIKE;
+        ppu_statpoll(cycles);
 
         /* clear v‑blank flag and flip‑flop */
         ppu.stat &= ~PPU_STATF_VBLANK;
@@ -481,8 +753,7 @@ case PPU_VDATA:
     if ((ppu.bg_on || ppu.obj_on) && !ppu.vram_accessible) {
         /* Rendering fetches own the bus → open‑bus value            */
         ppu.vdata_latch = 0xFF;
-        nofrendo_log_printf("VRAM read at $%04X, scanline %d\n",
-                   ppu.vaddr, nes_getcontextptr()->scanline);
+        TRACE_DEBUG(TRACE_PPU_VRAM_READ, ppu.vaddr, nes_getcontextptr()->scanline);
     } else {
         uint32_t addr = ppu.vaddr & 0x3FFF;      /* mirror into 16 kB range */
         if (addr >= 0x3000) addr -= 0x1000;      /* palette mirrors          */
@@ -546,6 +817,7 @@ void ppu_write(uint32 address, uint8 value)
 
       /* Update temp address bits 10‑11 */
       ppu.vaddr_latch = (ppu.vaddr_latch & ~0x0C00) | ((value & 3) << 10);
+      ppu_selectrender();
       break;
 
 /*──────────────────────── $2001 – PPU_CTRL1 ────────────────────────*/
@@ -555,6 +827,7 @@ void ppu_write(uint32 address, uint8 value)
       ppu.bg_on   = (value & PPU_CTRL1F_BGON)   != 0;
       ppu.obj_mask= (value & PPU_CTRL1F_OBJMASK)==0;
       ppu.bg_mask = (value & PPU_CTRL1F_BGMASK)==0;
+      ppu_selectrender();
       break;
 
 /*──────────────────────── $2003 – OAM_ADDR ─────────────────────────*/
@@ -608,16 +881,15 @@ void ppu_write(uint32 address, uint8 value)
          if ((ppu.bg_on || ppu.obj_on) && !ppu.vram_accessible)
          {
                /* Illegal during the fetch phase → emulate bus corruption */
-               nofrendo_log_printf("VRAM write %04X on active scan‑line %d\n",
-                        ppu.vaddr, nes_getcontextptr()->scanline);
-               PPU_MEM(ppu.vaddr) = 0xFF;
+               TRACE_DEBUG(TRACE_PPU_VRAM_WRITE, ppu.vaddr, nes_getcontextptr()->scanline);
+               ppu_mem_store(ppu.vaddr, 0xFF);
          }
          else
          {
                uint32_t addr = ppu.vaddr;
                if (!ppu.vram_present && addr >= 0x3000)      /* palette mirrors */
                   addr -= 0x1000;
-               PPU_MEM(addr) = value;
+               ppu_mem_store(addr, value);
          }
       }
       /* ------------------------------------------------------------ *
@@ -717,12 +989,8 @@ void ppu_setvromswitch(ppuvromswitch_t func)
 }
 
 /* rendering routines */
-INLINE void draw_bgtile(uint8 *surface, uint8 pat1, uint8 pat2, 
-                        const uint8 *colors)
+INLINE void draw_bgtile(uint8 *surface, uint32 pattern, const uint8 *colors)
 {
-   uint32 pattern = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
-                    | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
-   
    *surface++ = colors[(pattern >> 14) & 3];
    *surface++ = colors[(pattern >> 6) & 3];
    *surface++ = colors[(pattern >> 12) & 3];
@@ -733,13 +1001,9 @@ INLINE void draw_bgtile(uint8 *surface, uint8 pat1, uint8 pat2,
    *surface = colors[pattern & 3];
 }
 
-INLINE int draw_oamtile(uint8 *surface, uint8 attrib, uint8 pat1, 
-                        uint8 pat2, const uint8 *col_tbl, bool check_strike)
+INLINE void draw_oamtile(uint8 *surface, uint8 attrib, uint32 color,
+                         const uint8 *col_tbl)
 {
-   int strike_pixel = -1;
-   uint32 color = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
-                  | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
-
    /* sprite is not 100% transparent */
    if (color)
    {
@@ -769,27 +1033,6 @@ INLINE int draw_oamtile(uint8 *surface, uint8 attrib, uint8 pat1,
          colors[0] = color & 3;
       }
 
-      /* check for solid sprite pixel overlapping solid bg pixel */
-      if (check_strike)
-      {
-         if (colors[0] && BG_SOLID(surface[0]))
-            strike_pixel = 0;
-         else if (colors[1] && BG_SOLID(surface[1]))
-            strike_pixel = 1;
-         else if (colors[2] && BG_SOLID(surface[2]))
-            strike_pixel = 2;
-         else if (colors[3] && BG_SOLID(surface[3]))
-            strike_pixel = 3;
-         else if (colors[4] && BG_SOLID(surface[4]))
-            strike_pixel = 4;
-         else if (colors[5] && BG_SOLID(surface[5]))
-            strike_pixel = 5;
-         else if (colors[6] && BG_SOLID(surface[6]))
-            strike_pixel = 6;
-         else if (colors[7] && BG_SOLID(surface[7]))
-            strike_pixel = 7;
-      }
-
       /* draw the character */
       if (attrib & OAMF_BEHIND)
       {
@@ -830,11 +1073,32 @@ INLINE int draw_oamtile(uint8 *surface, uint8 attrib, uint8 pat1,
             surface[7] = SP_PIXEL | col_tbl[colors[7]];
       }
    }
+}
 
-   return strike_pixel;
+/* The scanline renderers below are built from two bodies taking constant
+** mode flags, one copy per combination (see PPU_BG_VARIANTS and
+** PPU_OAM_VARIANTS), so none of the per-tile mode tests survive in them.
+** ppu_selectrender() points renderbg/renderoam at the right copies
+** whenever $2000/$2001, the mapper hooks or the whole context change.
+**
+**   clip   - blank (bg) or preserve (sprites) the left hand 8 pixels
+**   tall   - 8x16 sprites
+**   hooked - mapper wants to see fetches: MMC2/MMC4 tile latches or the
+**            per-access A12 hook.  Fetches go through PPU_MEM and the
+**            latch function is called for every tile.  Without it pattern
+**            and nametable bytes are read straight out of fetch_page.
+** The bodies must be inlined into every copy or the flags stay variables.
+*/
+#define  RENDER_INLINE  static __inline__ __attribute__((always_inline))
+
+RENDER_INLINE uint8 *render_mem_ptr(uint16 x, bool hooked)
+{
+   if (hooked)
+      return PPU_MEM_PTR(x);
+   return &fetch_page[x >> 10][x];
 }
 
-static void ppu_renderbg(uint8 *vidbuf)
+RENDER_INLINE void ppu_renderbg_body(uint8 *vidbuf, bool clip, bool hooked)
 {
    uint8 *bmp_ptr, *data_ptr, *tile_ptr, *attrib_ptr;
    uint32 refresh_vaddr, bg_offset, attrib_base;
@@ -842,13 +1106,6 @@ static void ppu_renderbg(uint8 *vidbuf)
    uint8 tile_index, x_tile, y_tile;
    uint8 col_high, attrib, attrib_shift;
 
-   /* draw a line of transparent background color if bg is disabled */
-   if (false == ppu.bg_on)
-   {
-      memset(vidbuf, FULLBG, NES_SCREEN_WIDTH);
-      return;
-   }
-
    bmp_ptr = vidbuf - ppu.tile_xofs; /* scroll x */
    refresh_vaddr = 0x2000 + (ppu.vaddr & 0x0FE0); /* mask out x tile */
    x_tile = ppu.vaddr & 0x1F;
@@ -856,9 +1113,9 @@ static void ppu_renderbg(uint8 *vidbuf)
    bg_offset = ((ppu.vaddr >> 12) & 7) + ppu.bg_base; /* offset in y tile */
 
    /* calculate initial values */
-   tile_ptr = &PPU_MEM(refresh_vaddr + x_tile); /* pointer to tile index */
+   tile_ptr = render_mem_ptr(refresh_vaddr + x_tile, hooked); /* pointer to tile index */
    attrib_base = (refresh_vaddr & 0x2C00) + 0x3C0 + ((y_tile & 0x1C) << 1);
-   attrib_ptr = &PPU_MEM(attrib_base + (x_tile >> 2));
+   attrib_ptr = render_mem_ptr(attrib_base + (x_tile >> 2), hooked);
    attrib = *attrib_ptr++;
    attrib_shift = (x_tile & 2) + ((y_tile & 2) << 1);
    col_high = ((attrib >> attrib_shift) & 3) << 2;
@@ -869,13 +1126,13 @@ static void ppu_renderbg(uint8 *vidbuf)
    {
       /* Tile number from nametable */
       tile_index = *tile_ptr++;
-      data_ptr = &PPU_MEM(bg_offset + (tile_index << 4));
+      data_ptr = render_mem_ptr(bg_offset + (tile_index << 4), hooked);
 
       /* Handle $FD/$FE tile VROM switching (PunchOut) */
-      if (ppu.latchfunc)
+      if (hooked && ppu.latchfunc)
          ppu.latchfunc(ppu.bg_base, tile_index);
 
-      draw_bgtile(bmp_ptr, data_ptr[0], data_ptr[8], ppu.palette + col_high);
+      draw_bgtile(bmp_ptr, tile_pattern(data_ptr), ppu.palette + col_high);
       bmp_ptr += 8;
 
       x_tile++;
@@ -891,8 +1148,8 @@ static void ppu_renderbg(uint8 *vidbuf)
                attrib_base ^= (1 << 10);
 
                /* recalculate pointers */
-               tile_ptr = &PPU_MEM(refresh_vaddr);
-               attrib_ptr = &PPU_MEM(attrib_base);
+               tile_ptr = render_mem_ptr(refresh_vaddr, hooked);
+               attrib_ptr = render_mem_ptr(attrib_base, hooked);
             }
 
             /* Get the attribute byte */
@@ -905,7 +1162,7 @@ static void ppu_renderbg(uint8 *vidbuf)
    }
 
    /* Blank left hand column if need be */
-   if (ppu.bg_mask)
+   if (clip)
    {
       uint32 *buf_ptr = (uint32 *) vidbuf;
       uint32 bg_clear = FULLBG | FULLBG << 8 | FULLBG << 16 | FULLBG << 24;
@@ -925,28 +1182,24 @@ typedef struct obj_s
 } obj_t;
 
 /* TODO: fetch valid OAM a scanline before, like the Real Thing */
-static void ppu_renderoam(uint8 *vidbuf, int scanline)
+RENDER_INLINE void ppu_renderoam_body(uint8 *vidbuf, int scanline, bool clip, bool tall, bool hooked)
 {
    uint8 *buf_ptr;
    uint32 vram_offset, savecol[2];
    int sprite_num, spritecount;
    obj_t *sprite_ptr;
-   uint8 sprite_height;
-
-   if (false == ppu.obj_on)
-      return;
+   const int sprite_height = tall ? 16 : 8;
 
    /* Get our buffer pointer */
    buf_ptr = vidbuf;
 
    /* Save left hand column? */
-   if (ppu.obj_mask)
+   if (clip)
    {
       savecol[0] = ((uint32 *) buf_ptr)[0];
       savecol[1] = ((uint32 *) buf_ptr)[1];
    }
 
-   sprite_height = ppu.obj_height;
    vram_offset = ppu.obj_base;
    spritecount = 0;
 
@@ -959,8 +1212,6 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
       int y_offset;
       uint8 tile_index, attrib, col_high;
       uint8 sprite_y, sprite_x;
-      bool check_strike;
-      int strike_pixel;
 
       sprite_y = sprite_ptr->y_loc + 1;
 
@@ -976,30 +1227,30 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
       bmp_ptr = buf_ptr + sprite_x;
 
       /* Handle $FD/$FE tile VROM switching (PunchOut) */
-      if (ppu.latchfunc)
+      if (hooked && ppu.latchfunc)
          ppu.latchfunc(vram_offset, tile_index);
 
       /* Get upper two bits of color */
       col_high = ((attrib & 3) << 2);
 
       /* 8x16 even sprites use $0000, odd use $1000 */
-      if (16 == ppu.obj_height)
+      if (tall)
          vram_adr = ((tile_index & 1) << 12) | ((tile_index & 0xFE) << 4);
       else
          vram_adr = vram_offset + (tile_index << 4);
 
       /* Get the address of the tile */
-      data_ptr = &PPU_MEM(vram_adr);
+      data_ptr = render_mem_ptr(vram_adr, hooked);
 
       /* Calculate offset (line within the sprite) */
       y_offset = scanline - sprite_y;
-      if (y_offset > 7)
+      if (tall && y_offset > 7)
          y_offset += 8;
 
       /* Account for vertical flippage */
       if (attrib & OAMF_VFLIP)
       {
-         if (16 == ppu.obj_height)
+         if (tall)
             y_offset -= 23;
          else
             y_offset -= 7;
@@ -1011,13 +1262,7 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
          data_ptr += y_offset;
       }
 
-      /* if we're on sprite 0 and sprite 0 strike flag isn't set,
-      ** check for a strike 
-      */
-      check_strike = (0 == sprite_num) && (false == ppu.strikeflag);
-      strike_pixel = draw_oamtile(bmp_ptr, attrib, data_ptr[0], data_ptr[8], ppu.palette + 16 + col_high, check_strike);
-      if (strike_pixel >= 0)
-         ppu_setstrike(strike_pixel);
+      draw_oamtile(bmp_ptr, attrib, tile_pattern(data_ptr), ppu.palette + 16 + col_high);
 
       /* maximum of 8 sprites per scanline */
       if (++spritecount == PPU_MAXSPRITE)
@@ -1028,121 +1273,182 @@ static void ppu_renderoam(uint8 *vidbuf, int scanline)
    }
 
    /* Restore lefthand column */
-   if (ppu.obj_mask)
+   if (clip)
    {
       ((uint32 *) buf_ptr)[0] = savecol[0];
       ((uint32 *) buf_ptr)[1] = savecol[1];
    }
 }
 
-/* Fake rendering a line */
-/* This is needed for sprite 0 hits when we're skipping drawing a frame */
-static void ppu_fakeoam(int scanline)
+/* draw a line of transparent background color if bg is disabled */
+static void ppu_renderbg_off(uint8 *vidbuf)
 {
-   uint8 *data_ptr;
-   obj_t *sprite_ptr;
-   uint32 vram_adr, color;
-   int y_offset;
-   uint8 pat1, pat2;
-   uint8 tile_index, attrib;
-   uint8 sprite_height, sprite_y, sprite_x;
+   memset(vidbuf, FULLBG, NES_SCREEN_WIDTH);
+}
+
+static void ppu_renderoam_off(uint8 *vidbuf, int scanline)
+{
+   UNUSED(vidbuf);
+   UNUSED(scanline);
+}
+
+/*       name                 clip   hooked */
+#define  PPU_BG_VARIANTS(V) \
+   V(bg,                   false, false) \
+   V(bg_clip,              true,  false) \
+   V(bg_hooked,            false, true ) \
+   V(bg_clip_hooked,       true,  true )
+
+/*       name                 clip   tall   hooked */
+#define  PPU_OAM_VARIANTS(V) \
+   V(oam,                  false, false, false) \
+   V(oam_clip,             true,  false, false) \
+   V(oam_tall,             false, true,  false) \
+   V(oam_clip_tall,        true,  true,  false) \
+   V(oam_hooked,           false, false, true ) \
+   V(oam_clip_hooked,      true,  false, true ) \
+   V(oam_tall_hooked,      false, true,  true ) \
+   V(oam_clip_tall_hooked, true,  true,  true )
+
+#define  BG_VARIANT_INDEX(clip, hooked)         ((clip) | (hooked) << 1)
+#define  OAM_VARIANT_INDEX(clip, tall, hooked)  ((clip) | (tall) << 1 | (hooked) << 2)
+
+#define  BG_DEFINE(name, clip, hooked) \
+static void ppu_render_##name(uint8 *vidbuf) \
+{ \
+   ppu_renderbg_body(vidbuf, clip, hooked); \
+}
+#define  OAM_DEFINE(name, clip, tall, hooked) \
+static void ppu_render_##name(uint8 *vidbuf, int scanline) \
+{ \
+   ppu_renderoam_body(vidbuf, scanline, clip, tall, hooked); \
+}
+PPU_BG_VARIANTS(BG_DEFINE)
+PPU_OAM_VARIANTS(OAM_DEFINE)
+
+#define  BG_ENTRY(name, clip, hooked)        [BG_VARIANT_INDEX(clip, hooked)] = ppu_render_##name,
+#define  OAM_ENTRY(name, clip, tall, hooked) [OAM_VARIANT_INDEX(clip, tall, hooked)] = ppu_render_##name,
 
-   /* we don't need to be here if strike flag is set */
+static void (*const bg_variant[4])(uint8 *vidbuf) = { PPU_BG_VARIANTS(BG_ENTRY) };
+static void (*const oam_variant[8])(uint8 *vidbuf, int scanline) = { PPU_OAM_VARIANTS(OAM_ENTRY) };
 
-   if (false == ppu.obj_on || ppu.strikeflag)
+/* picked by ppu_selectrender() */
+static void (*renderbg)(uint8 *vidbuf) = ppu_renderbg_off;
+static void (*renderoam)(uint8 *vidbuf, int scanline) = ppu_renderoam_off;
+
+static void ppu_selectrender(void)
+{
+   bool hooked = (mapper_caps & MMC_CAP_LATCH) || NULL != mapper_ppu_hook;
+
+   if (ppu.bg_on)
+      renderbg = bg_variant[BG_VARIANT_INDEX(ppu.bg_mask, hooked)];
+   else
+      renderbg = ppu_renderbg_off;
+
+   if (ppu.obj_on)
+      renderoam = oam_variant[OAM_VARIANT_INDEX(ppu.obj_mask, 16 == ppu.obj_height, hooked)];
+   else
+      renderoam = ppu_renderoam_off;
+}
+
+void ppu_setmappercaps(int caps)
+{
+   mapper_caps = caps;
+   ppu_selectrender();
+}
+
+/* mirror image of a row of pixel bits */
+INLINE uint8 reverse_bits(uint8 bits)
+{
+   bits = ((bits & 0xF0) >> 4) | ((bits & 0x0F) << 4);
+   bits = ((bits & 0xCC) >> 2) | ((bits & 0x33) << 2);
+   return ((bits & 0xAA) >> 1) | ((bits & 0x55) << 1);
+}
+
+/* Sprite 0 hit for this line, found by intersecting the opaque pixels of
+** sprite 0's row with the opaque background pixels under it.  Runs ahead
+** of the CPU like the renderer, whether the line is drawn or not, and
+** only on lines sprite 0 covers until it hits.  Pattern and nametable
+** bytes are read without going through the mapper hooks; this is not a
+** PPU fetch.
+*/
+static void ppu_strikecheck(int scanline)
+{
+   obj_t *sprite_ptr = (obj_t *) ppu.oam;
+   const uint8 *data_ptr;
+   uint32 vram_adr, refresh_vaddr, bg_offset, bg_bits;
+   uint8 sprite_y, sprite_x, attrib, x_tile;
+   uint8 sprite_bits, hit;
+   int y_offset, bg_x, tile, pixel;
+
+   if (ppu.strikeflag || false == ppu.bg_on || false == ppu.obj_on)
       return;
 
-   sprite_height = ppu.obj_height;
-   sprite_ptr = (obj_t *) ppu.oam;
    sprite_y = sprite_ptr->y_loc + 1;
 
-   /* Check to see if sprite is out of range */
-   if ((sprite_y > scanline) || (sprite_y <= (scanline - sprite_height)) 
-       || (0 == sprite_y) || (sprite_y > 240))
+   /* same range test as the renderer */
+   if ((sprite_y > scanline) || (sprite_y <= (scanline - ppu.obj_height))
+       || (0 == sprite_y) || (sprite_y >= 240))
       return;
 
    sprite_x = sprite_ptr->x_loc;
-   tile_index = sprite_ptr->tile;
    attrib = sprite_ptr->atr;
 
    /* 8x16 even sprites use $0000, odd use $1000 */
    if (16 == ppu.obj_height)
-      vram_adr = ((tile_index & 1) << 12) | ((tile_index & 0xFE) << 4);
+      vram_adr = ((sprite_ptr->tile & 1) << 12) | ((sprite_ptr->tile & 0xFE) << 4);
    else
-      vram_adr = ppu.obj_base + (tile_index << 4);
-
-   data_ptr = &PPU_MEM(vram_adr);
+      vram_adr = ppu.obj_base + (sprite_ptr->tile << 4);
 
-   /* Calculate offset (line within the sprite) */
    y_offset = scanline - sprite_y;
+   if (attrib & OAMF_VFLIP)
+      y_offset = ppu.obj_height - 1 - y_offset;
    if (y_offset > 7)
       y_offset += 8;
 
-   /* Account for vertical flippage */
-   if (attrib & OAMF_VFLIP)
-   {
-      if (16 == ppu.obj_height)
-         y_offset -= 23;
-      else
-         y_offset -= 7;
-      data_ptr -= y_offset;
-   }
-   else
-   {
-      data_ptr += y_offset;
-   }
+   /* opaque sprite pixels, leftmost in bit 7 */
+   data_ptr = &fetch_page[(vram_adr + y_offset) >> 10][vram_adr + y_offset];
+   sprite_bits = data_ptr[0] | data_ptr[8];
+   if (attrib & OAMF_HFLIP)
+      sprite_bits = reverse_bits(sprite_bits);
 
-   /* check for a solid sprite 0 pixel */
-   pat1 = data_ptr[0];
-   pat2 = data_ptr[8];
-   color = ((pat2 & 0xAA) << 8) | ((pat2 & 0x55) << 1)
-                  | ((pat1 & 0xAA) << 7) | (pat1 & 0x55);
+   /* no hit at x=255, nor in the left column while either layer is clipped */
+   if (sprite_x > 247)
+      sprite_bits &= 0xFE << (sprite_x - 248);
+   if (sprite_x < 8 && (ppu.bg_mask || ppu.obj_mask))
+      sprite_bits &= 0xFF >> (8 - sprite_x);
 
-   if (color)
+   if (0 == sprite_bits)
+      return;
+
+   /* the two background tiles under the sprite, vaddr as the renderer sees it */
+   bg_x = sprite_x + ppu.tile_xofs;
+   refresh_vaddr = 0x2000 + (ppu.vaddr & 0x0FE0);
+   x_tile = (ppu.vaddr & 0x1F) + (bg_x >> 3);
+   bg_offset = ((ppu.vaddr >> 12) & 7) + ppu.bg_base;
+
+   bg_bits = 0;
+   for (tile = 0; tile < 2; tile++, x_tile++)
    {
-      uint8 colors[8];
+      uint32 addr = refresh_vaddr + (x_tile & 0x1F);
 
-      /* buckle up, it's going to get ugly... */
-      if (0 == (attrib & OAMF_HFLIP))
-      {
-         colors[0] = (color >> 14) & 3;
-         colors[1] = (color >> 6) & 3;
-         colors[2] = (color >> 12) & 3;
-         colors[3] = (color >> 4) & 3;
-         colors[4] = (color >> 10) & 3;
-         colors[5] = (color >> 2) & 3;
-         colors[6] = (color >> 8) & 3;
-         colors[7] = color & 3;
-      }
-      else
-      {
-         colors[7] = (color >> 14) & 3;
-         colors[6] = (color >> 6) & 3;
-         colors[5] = (color >> 12) & 3;
-         colors[4] = (color >> 4) & 3;
-         colors[3] = (color >> 10) & 3;
-         colors[2] = (color >> 2) & 3;
-         colors[1] = (color >> 8) & 3;
-         colors[0] = color & 3;
-      }
+      if (x_tile & 0x20)
+         addr ^= (1 << 10); /* next nametable */
 
-      if (colors[0])
-         ppu_setstrike(sprite_x + 0);
-      else if (colors[1])
-         ppu_setstrike(sprite_x + 1);
-      else if (colors[2])
-         ppu_setstrike(sprite_x + 2);
-      else if (colors[3])
-         ppu_setstrike(sprite_x + 3);
-      else if (colors[4])
-         ppu_setstrike(sprite_x + 4);
-      else if (colors[5])
-         ppu_setstrike(sprite_x + 5);
-      else if (colors[6])
-         ppu_setstrike(sprite_x + 6);
-      else if (colors[7])
-         ppu_setstrike(sprite_x + 7);
+      addr = bg_offset + (fetch_page[addr >> 10][addr] << 4);
+      data_ptr = &fetch_page[addr >> 10][addr];
+      bg_bits = (bg_bits << 8) | data_ptr[0] | data_ptr[8];
    }
+
+   /* line the background pixels up with the sprite's */
+   hit = sprite_bits & (uint8) (bg_bits >> (8 - (bg_x & 7)));
+   if (0 == hit)
+      return;
+
+   for (pixel = 0; 0 == (hit & 0x80); pixel++)
+      hit <<= 1;
+
+   ppu_setstrike(sprite_x + pixel);
 }
 
 bool ppu_enabled(void)
@@ -1150,10 +1456,65 @@ bool ppu_enabled(void)
    return (ppu.bg_on || ppu.obj_on);
 }
 
+/* Where PPU A12 goes high while a scanline is rendered, for MMC_CAP_A12 mappers that
+** count scanlines off it.  The background is fetched up to dot 256, the
+** 8 sprite slots from dot 257 and the first two tiles of the next line
+** from dot 321, so with 8x8 sprites it only depends on which of the two
+** pattern tables each of them uses.  With 8x16 sprites each slot picks
+** its own table (empty slots fetch tile $FF); from a $0000 background A12
+** rises at the first slot using $1000.  Short low pulses between slots
+** are not seen by the MMC3, so a $1000 background with 8x16 sprites is
+** the only case where the result depends on the fetch timing.
+*/
+int ppu_a12_rise(int scanline)
+{
+   obj_t *sprite_ptr;
+   int sprite_num, slot;
+
+   if (0 == (mapper_caps & MMC_CAP_A12))
+      return PPU_A12_NONE;
+
+   if (16 != ppu.obj_height)
+   {
+      if (ppu.bg_base == ppu.obj_base)
+         return PPU_A12_NONE;
+      return ppu.obj_base ? 260 : 324;
+   }
+
+   if (ppu.bg_base)
+      return PPU_A12_IRREGULAR;
+
+   /* same sprites as ppu_renderoam() fetches for this line */
+   slot = 0;
+   if (scanline < 240)
+   {
+      sprite_ptr = (obj_t *) ppu.oam;
+      for (sprite_num = 0; sprite_num < 64; sprite_num++, sprite_ptr++)
+      {
+         uint8 sprite_y = sprite_ptr->y_loc + 1;
+
+         if ((sprite_y > scanline) || (sprite_y <= (scanline - 16))
+             || (0 == sprite_y) || (sprite_y >= 240))
+            continue;
+
+         if (sprite_ptr->tile & 1)
+            break;
+
+         if (++slot == PPU_MAXSPRITE)
+            return PPU_A12_NONE;
+      }
+   }
+
+   return 260 + (slot << 3);
+}
+
 static void ppu_renderscanline(bitmap_t *bmp, int scanline, bool draw_flag)
 {
    uint8 *buf = bmp->line[scanline];
 
+   if (chr_any_dirty)
+      chr_refresh();
+
    /* start scanline - transfer ppu latch into vaddr */
    if (ppu.bg_on || ppu.obj_on)
    {
@@ -1168,14 +1529,14 @@ static void ppu_renderscanline(bitmap_t *bmp, int scanline, bool draw_flag)
       }
    }
 
+   ppu_strikecheck(scanline);
+
    if (draw_flag)
-      ppu_renderbg(buf);
+      renderbg(buf);
 
    /* TODO: fetch obj data 1 scanline before */
    if (true == ppu.drawsprites && true == draw_flag)
-      ppu_renderoam(buf, scanline);
-   else
-      ppu_fakeoam(scanline);
+      renderoam(buf, scanline);
 }
 
 
@@ -1222,6 +1583,9 @@ void ppu_checknmi(void)
 
 void ppu_scanline(bitmap_t *bmp, int scanline, bool draw_flag)
 {
+   /* pick up analog glitch changes once per frame */
+   if (scanline == 0 && glitch_mask != ppu_glitch_mask())
+         glitch_setmask(ppu_glitch_mask());
    if (scanline == 0 && ppu.bg_base == 0x1000 && ppu.obj_base == 0x0000)
          ppu_notify_addr(0x1000);
    if (scanline < 240)
@@ -1252,17 +1616,42 @@ void ppu_scanline(bitmap_t *bmp, int scanline, bool draw_flag)
    }
 }
 
-/*
-bool ppu_checkzapperhit(bitmap_t *bmp, int x, int y)
+/* The zapper's photodiode sees the beam go past its aim point and stays
+** lit for a couple dozen lines. Lines up to the current one already hold
+** this frame, so look around (x, y) once the beam has passed it.
+*/
+#define  ZAPPER_DECAY_LINES   26
+#define  ZAPPER_BRIGHT        0x260    /* r + g + b, white and the light pastels */
+
+bool ppu_checkzapperhit(int x, int y)
 {
-   uint8 pixel = bmp->line[y][x] & 0x3F;
+   bitmap_t *bmp = vid_getbuffer();
+   int scanline = nes_getcontextptr()->scanline;
+   int i, j;
+
+   if (NULL == bmp || scanline < y || scanline >= y + ZAPPER_DECAY_LINES)
+      return false;
+
+   for (j = y - 1; j <= y + 1 && j <= scanline; j++)
+   {
+      if (j < 0 || j >= NES_SCREEN_HEIGHT)
+         continue;
+
+      for (i = x - 1; i <= x + 1; i++)
+      {
+         rgb_t *rgb;
 
-   if (0x20 == pixel || 0x30 == pixel)
-      return true;
+         if (i < 0 || i >= NES_SCREEN_WIDTH)
+            continue;
+
+         rgb = &ppu.curpal[bmp->line[j][i]];
+         if (rgb->r + rgb->g + rgb->b >= ZAPPER_BRIGHT)
+            return true;
+      }
+   }
 
    return false;
 }
-*/
 
 /*************************************************/
 /* TODO: all this stuff should go somewhere else */
@@ -1340,8 +1729,8 @@ static void draw_sprite(bitmap_t *bmp, int x, int y, uint8 tile_num, uint8 attri
       if (line == 8)
          data_ptr += 8;
 
-      draw_bgtile(vid, data_ptr[0], data_ptr[8], ppu.palette + 16 + col_high);
-      //draw_oamtile(vid, attrib, data_ptr[0], data_ptr[8], ppu.palette + 16 + col_high);
+      draw_bgtile(vid, MERGE_PLANES(data_ptr[0], data_ptr[8]), ppu.palette + 16 + col_high);
+      //draw_oamtile(vid, attrib, MERGE_PLANES(data_ptr[0], data_ptr[8]), ppu.palette + 16 + col_high);
 
       data_ptr++;
       vid += bmp->pitch;
@@ -1398,7 +1787,7 @@ void ppu_dumppattern(bitmap_t *bmp, int table_num, int x_loc, int y_loc, int col
 
          for (line = 0; line < 8; line ++)
          {
-            draw_bgtile(ptr, data_ptr[0], data_ptr[8], ppu.palette + col_high);
+            draw_bgtile(ptr, MERGE_PLANES(data_ptr[0], data_ptr[8]), ppu.palette + col_high);
             data_ptr++;
             ptr += bmp->pitch;
          }
@@ -120,6 +120,7 @@ extern void ppu_set_mapper_hook(void (*fn)(uint16 addr));
 /* TODO: should use this pointers */
 extern void ppu_setlatchfunc(ppulatchfunc_t func);
 extern void ppu_setvromswitch(ppuvromswitch_t func);
+extern void ppu_setmappercaps(int caps);
 
 extern void ppu_getcontext(ppu_t *dest_ppu);
 extern void ppu_setcontext(ppu_t *src_ppu);
@@ -133,10 +134,19 @@ extern void ppu_mirror(int nt1, int nt2, int nt3, int nt4);
 extern void ppu_setpage(int size, int page_num, uint8 *location);
 extern uint8 *ppu_getpage(int page);
 
+/* CHR-RAM pattern cache */
+extern void ppu_setchrram(uint8 *vram, int length);
+extern void ppu_chrdirty(void);
+
 
 /* control */
 extern void ppu_reset(int reset_type);
 extern bool ppu_enabled(void);
+
+/* PPU dot of the A12 rising edge on a rendered scanline */
+#define  PPU_A12_NONE         -1    /* A12 does not rise */
+#define  PPU_A12_IRREGULAR    -2    /* depends on the fetch timing */
+extern int ppu_a12_rise(int scanline);
 extern void ppu_scanline(bitmap_t *bmp, int scanline, bool draw_flag);
 extern void ppu_endscanline(int scanline);
 extern void ppu_checknmi();
@@ -149,6 +159,7 @@ extern uint8 ppu_read(uint32 address);
 extern void ppu_write(uint32 address, uint8 value);
 extern uint8 ppu_readhigh(uint32 address);
 extern void ppu_writehigh(uint32 address, uint8 value);
+extern bool ppu_checkzapperhit(int x, int y);
 
 /* rendering */
 extern void ppu_setpal(ppu_t *src_ppu, rgb_t *pal);
@@ -502,12 +502,9 @@ void rom_free(rominfo_t **rominfo)
 
    rom_savesram(*rominfo);
 
+   /* rom and vrom point into the mapped image, they aren't ours to free */
    if ((*rominfo)->sram)
       free((*rominfo)->sram);
-   if ((*rominfo)->rom)
-      free((*rominfo)->rom);
-   if ((*rominfo)->vrom)
-      free((*rominfo)->vrom);
    if ((*rominfo)->vram)
       free((*rominfo)->vram);
 
@@ -0,0 +1,200 @@
+/*
+** Nofrendo (c) 1998-2000 Matthew Conte (matt@conte.com)
+**
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of version 2 of the GNU Library General 
+** Public License as published by the Free Software Foundation.
+**
+** This program is distributed in the hope that it will be useful, 
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU 
+** Library General Public License for more details.  To obtain a 
+** copy of the GNU Library General Public License, write to the Free 
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+**
+**
+** nes_sched.c
+**
+** CPU cycle event scheduler
+*/
+
+#include "noftypes.h"
+#include "nes6502.h"
+#include "nes_sched.h"
+
+/* binary min-heap of pending slots, ordered by deadline */
+static struct
+{
+   uint32 when[SCHED_MAX];
+   sched_func_t func[SCHED_MAX];
+   int pos[SCHED_MAX];           /* index in heap[], or -1 */
+   int heap[SCHED_MAX];
+   int count;
+   bool running;
+   uint32 horizon;               /* where the current slice stops */
+} sched;
+
+/* deadlines are compared relative to each other so the cycle count can wrap */
+#define  SCHED_BEFORE(a, b)   ((int32) ((a) - (b)) < 0)
+
+static void sched_swap(int i, int j)
+{
+   int id = sched.heap[i];
+
+   sched.heap[i] = sched.heap[j];
+   sched.heap[j] = id;
+   sched.pos[sched.heap[i]] = i;
+   sched.pos[sched.heap[j]] = j;
+}
+
+static void sched_up(int i)
+{
+   while (i > 0)
+   {
+      int parent = (i - 1) >> 1;
+
+      if (!SCHED_BEFORE(sched.when[sched.heap[i]], sched.when[sched.heap[parent]]))
+         break;
+      sched_swap(i, parent);
+      i = parent;
+   }
+}
+
+static void sched_down(int i)
+{
+   for (;;)
+   {
+      int child = (i << 1) + 1;
+
+      if (child >= sched.count)
+         break;
+      if (child + 1 < sched.count
+          && SCHED_BEFORE(sched.when[sched.heap[child + 1]], sched.when[sched.heap[child]]))
+         child++;
+      if (!SCHED_BEFORE(sched.when[sched.heap[child]], sched.when[sched.heap[i]]))
+         break;
+      sched_swap(i, child);
+      i = child;
+   }
+}
+
+void sched_reset(void)
+{
+   int id;
+
+   for (id = 0; id < SCHED_MAX; id++)
+   {
+      sched.pos[id] = -1;
+      sched.func[id] = NULL;
+      sched.when[id] = 0;
+   }
+   sched.count = 0;
+}
+
+void sched_cancel(sched_id_t id)
+{
+   int i = sched.pos[id];
+
+   if (i < 0)
+      return;
+
+   sched.pos[id] = -1;
+   if (i != --sched.count)
+   {
+      /* move the last one into the hole and let it find its place */
+      int moved = sched.heap[sched.count];
+
+      sched.heap[i] = moved;
+      sched.pos[moved] = i;
+      sched_up(i);
+      sched_down(sched.pos[moved]);
+   }
+}
+
+void sched_at(sched_id_t id, uint32 cycle, sched_func_t func)
+{
+   sched_cancel(id);
+
+   sched.when[id] = cycle;
+   sched.func[id] = func;
+   sched.pos[id] = sched.count;
+   sched.heap[sched.count++] = id;
+   sched_up(sched.pos[id]);
+
+   /* set from inside the CPU: stop the slice early if it runs past this */
+   if (sched.running && SCHED_BEFORE(cycle, sched.horizon))
+      nes6502_release();
+}
+
+void sched_in(sched_id_t id, int cycles, sched_func_t func)
+{
+   sched_at(id, nes6502_getcycles(false) + cycles, func);
+}
+
+uint32 sched_when(sched_id_t id)
+{
+   return sched.when[id];
+}
+
+int sched_left(sched_id_t id)
+{
+   int left;
+
+   if (sched.pos[id] < 0)
+      return 0;
+
+   left = (int32) (sched.when[id] - nes6502_getcycles(false));
+   return (left > 0) ? left : 0;
+}
+
+int sched_slice_left(void)
+{
+   int left;
+
+   if (false == sched.running)
+      return 0;
+
+   left = (int32) (sched.horizon - nes6502_getcycles(false));
+   return (left > 0) ? left : 0;
+}
+
+int sched_run(int cycles)
+{
+   uint32 start = nes6502_getcycles(false);
+   uint32 end = start + cycles;
+
+   for (;;)
+   {
+      uint32 now = nes6502_getcycles(false);
+
+      /* fire everything that is due, in order */
+      while (sched.count && !SCHED_BEFORE(now, sched.when[sched.heap[0]]))
+      {
+         int id = sched.heap[0];
+
+         sched_cancel(id);
+         sched.func[id]();
+      }
+
+      if (!SCHED_BEFORE(now, end))
+         break;
+
+      sched.horizon = end;
+      if (sched.count && SCHED_BEFORE(sched.when[sched.heap[0]], end))
+         sched.horizon = sched.when[sched.heap[0]];
+
+      sched.running = true;
+      cycles = nes6502_execute((int32) (sched.horizon - now));
+      sched.running = false;
+
+      /* a jammed CPU does not move on */
+      if (0 == cycles)
+         break;
+   }
+
+   return (int32) (nes6502_getcycles(false) - start);
+}
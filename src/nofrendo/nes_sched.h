@@ -0,0 +1,62 @@
+/*
+** Nofrendo (c) 1998-2000 Matthew Conte (matt@conte.com)
+**
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of version 2 of the GNU Library General 
+** Public License as published by the Free Software Foundation.
+**
+** This program is distributed in the hope that it will be useful, 
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU 
+** Library General Public License for more details.  To obtain a 
+** copy of the GNU Library General Public License, write to the Free 
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+**
+**
+** nes_sched.h
+**
+** CPU cycle event scheduler
+*/
+
+#ifndef _NES_SCHED_H_
+#define _NES_SCHED_H_
+
+#include "noftypes.h"
+
+/* Everything that has to happen at a given CPU cycle registers its next
+** deadline here, and the CPU runs without interruption up to the
+** nearest one.  Each source owns one slot; setting it again moves it.
+*/
+typedef enum
+{
+   SCHED_NMI,        /* vblank NMI */
+   SCHED_FIQ,        /* APU frame counter IRQ */
+   SCHED_MAPPER,     /* mapper IRQ counter */
+   SCHED_MAX
+} sched_id_t;
+
+typedef void (*sched_func_t)(void);
+
+extern void sched_reset(void);
+
+/* cycle is an absolute nes6502_getcycles() value */
+extern void sched_at(sched_id_t id, uint32 cycle, sched_func_t func);
+extern void sched_in(sched_id_t id, int cycles, sched_func_t func);
+extern void sched_cancel(sched_id_t id);
+
+/* when the event is (or was last) due, and cycles left until then */
+extern uint32 sched_when(sched_id_t id);
+extern int sched_left(sched_id_t id);
+
+/* cycles until the CPU's current slice ends and something else can
+** happen: the next event, or the end of the scanline; 0 outside of one */
+extern int sched_slice_left(void);
+
+/* run the CPU for this many cycles, firing events on the way */
+extern int sched_run(int cycles);
+
+#endif /* _NES_SCHED_H_ */
@@ -25,6 +25,8 @@
 
 #include "noftypes.h"
 #include "nesinput.h"
+#include "nes_ppu.h"
+#include "nes6502.h"
 #include "log.h"
 
 /* TODO: make a linked list of inputs sources, so they
@@ -34,9 +36,35 @@
 static nesinput_t *nes_input[MAX_CONTROLLERS];
 static int active_entries = 0;
 
-/* read counters */
-static int pad0_readcount, pad1_readcount, ppad_readcount, ark_readcount;
+/* host hook that refreshes the input sources, pulled when the game
+** looks at the ports rather than once a frame
+*/
+static void (*input_poll)(void) = NULL;
+static uint32 poll_cycles;
+
+/* never pull more than once a scanline, zapper loops read thousands of times */
+#define  POLL_INTERVAL     114
+
+/* each port has a D0 (pads), D3 and D4 (zapper, arkanoid, power pad) line.
+** strobe latches the serial bits, every read shifts them down and feeds
+** in 1s, which is what the shift registers return once they run dry
+*/
+typedef struct inport_s
+{
+   int device;
+   uint32 d0, d3, d4;
+   uint8 lines;         /* which of D0/D3/D4 the device drives */
+   uint8 live;          /* bits not behind the shift register */
+} inport_t;
+
+static inport_t port[2] =
+{
+   { INP_DEV_JOYPAD, 0, 0, 0, 0x01, 0 },
+   { INP_DEV_JOYPAD, 0, 0, 0, 0x01, 0 }
+};
 
+/* Four Score signature, shifted out after the two pads on each port */
+static const uint32 fourscore_id[2] = { 0x08, 0x04 };
 
 static int retrieve_type(int type)
 {
@@ -53,28 +81,26 @@ static int retrieve_type(int type)
    return value;
 }
 
-static uint8 get_pad0(void)
+static void pull_sources(void)
 {
-   uint8 value;
-
-   value = (uint8) retrieve_type(INP_JOYPAD0);
+   uint32 cycles;
 
-   /* mask out left/right simultaneous keypresses */
-   if ((value & INP_PAD_UP) && (value & INP_PAD_DOWN))
-      value &= ~(INP_PAD_UP | INP_PAD_DOWN);
+   if (NULL == input_poll)
+      return;
 
-   if ((value & INP_PAD_LEFT) && (value & INP_PAD_RIGHT))
-      value &= ~(INP_PAD_LEFT | INP_PAD_RIGHT);
+   cycles = nes6502_getcycles(false);
+   if (cycles - poll_cycles < POLL_INTERVAL)
+      return;
 
-   /* return (0x40 | value) due to bus conflicts */
-   return (0x40 | ((value >> pad0_readcount++) & 1));
+   poll_cycles = cycles;
+   input_poll();
 }
 
-static uint8 get_pad1(void)
+static uint32 get_pad(int type)
 {
    uint8 value;
 
-   value = (uint8) retrieve_type(INP_JOYPAD1);
+   value = (uint8) retrieve_type(type);
 
    /* mask out left/right simultaneous keypresses */
    if ((value & INP_PAD_UP) && (value & INP_PAD_DOWN))
@@ -83,71 +109,94 @@ static uint8 get_pad1(void)
    if ((value & INP_PAD_LEFT) && (value & INP_PAD_RIGHT))
       value &= ~(INP_PAD_LEFT | INP_PAD_RIGHT);
 
-   /* return (0x40 | value) due to bus conflicts */
-   return (0x40 | ((value >> pad1_readcount++) & 1));
+   return value;
 }
 
-static uint8 get_zapper(void)
+/* knob position goes out MSB first and inverted */
+static uint32 get_arkanoid(int value)
 {
-   return (uint8) (retrieve_type(INP_ZAPPER));
+   uint32 bits = 0;
+   int i;
+
+   value = ~INP_POS_X(value);
+   for (i = 0; i < 8; i++)
+      bits |= ((value >> (7 - i)) & 1) << i;
+
+   return bits;
 }
 
-static uint8 get_powerpad(void)
+static void latch_port(int num)
 {
+   inport_t *p = &port[num];
    int value;
-   uint8 ret_val = 0;
-   
-   value = retrieve_type(INP_POWERPAD);
 
-   if (((value >> 8) >> ppad_readcount) & 1)
-      ret_val |= 0x10;
-   if (((value & 0xFF) >> ppad_readcount) & 1)
-      ret_val |= 0x08;
+   p->d0 = p->d3 = p->d4 = 0xFFFFFFFF;
+   p->lines = 0x01;
+   p->live = 0;
 
-   ppad_readcount++;
-
-   return ret_val;
+   switch (p->device)
+   {
+   case INP_DEV_JOYPAD:
+      p->d0 = get_pad(num ? INP_JOYPAD1 : INP_JOYPAD0) | 0xFFFFFF00;
+      break;
+
+   case INP_DEV_FOURSCORE:
+      p->d0 = get_pad(num ? INP_JOYPAD1 : INP_JOYPAD0)
+              | (get_pad(num ? INP_JOYPAD3 : INP_JOYPAD2) << 8)
+              | (fourscore_id[num] << 16) | 0xFF000000;
+      break;
+
+   case INP_DEV_ARKANOID:
+      value = retrieve_type(INP_ARKANOID);
+      p->d4 = get_arkanoid(value) | 0xFFFFFF00;
+      p->lines = 0x10;
+      p->live = value & INP_ARKANOID_FIRE;
+      break;
+
+   case INP_DEV_POWERPAD:
+      /* upper byte is what's returned in D4, lower is D3 */
+      value = retrieve_type(INP_POWERPAD);
+      p->d3 = (value & 0xFF) | 0xFFFFFF00;
+      p->d4 = ((value >> 8) & 0x0F) | 0xFFFFFFF0;
+      p->lines = 0x18;
+      break;
+
+   default:
+      p->lines = 0;
+      break;
+   }
 }
 
-static uint8 get_vsdips0(void)
+/* the zapper has no shift register, it reports what it sees right now */
+static uint8 get_zapper(void)
 {
-   return (retrieve_type(INP_VSDIPSW0));
-}
+   int value;
 
-static uint8 get_vsdips1(void)
-{
-   return (retrieve_type(INP_VSDIPSW1));
-}
+   pull_sources();
+   value = retrieve_type(INP_ZAPPER);
 
-static uint8 get_arkanoid(void)
-{
-   uint8 value = retrieve_type(INP_ARKANOID);
+   if (ppu_checkzapperhit(INP_POS_X(value), INP_POS_Y(value)))
+      return INP_ZAPPER_HIT | (value & INP_ZAPPER_TRIG);
 
-   if ((value >> (7 - ark_readcount++)) & 1)
-      return 0x02;
-   else
-      return 0;
+   return INP_ZAPPER_MISS | (value & INP_ZAPPER_TRIG);
 }
 
-/* return input state for all types indicated (can be ORed together) */
-uint8 input_get(int types)
+/* read $4016 (port 0) or $4017 (port 1) */
+uint8 input_read(int num)
 {
-   uint8 value = 0;
-
-   if (types & INP_JOYPAD0)
-      value |= get_pad0();
-   if (types & INP_JOYPAD1)
-      value |= get_pad1();
-   if (types & INP_ZAPPER)
-      value |= get_zapper();
-   if (types & INP_POWERPAD)
-      value |= get_powerpad();
-   if (types & INP_VSDIPSW0)
-      value |= get_vsdips0();
-   if (types & INP_VSDIPSW1)
-      value |= get_vsdips1();
-   if (types & INP_ARKANOID)
-      value |= get_arkanoid();
+   inport_t *p = &port[num];
+   uint8 value;
+
+   if (INP_DEV_ZAPPER == p->device)
+      return 0x40 | get_zapper();
+
+   /* return (0x40 | value) due to bus conflicts */
+   value = ((p->d0 & 1) | ((p->d3 & 1) << 3) | ((p->d4 & 1) << 4)) & p->lines;
+   value |= 0x40 | p->live;
+
+   p->d0 = (p->d0 >> 1) | 0x80000000;
+   p->d3 = (p->d3 >> 1) | 0x80000000;
+   p->d4 = (p->d4 >> 1) | 0x80000000;
 
    return value;
 }
@@ -172,12 +221,39 @@ void input_event(nesinput_t *input, int state, int value)
       input->data &= ~value;  /* mask it out */
 }
 
+/* controllers load their shift registers */
 void input_strobe(void)
 {
-   pad0_readcount = 0;
-   pad1_readcount = 0;
-   ppad_readcount = 0;
-   ark_readcount = 0;
+   pull_sources();
+   latch_port(0);
+   latch_port(1);
+}
+
+/* Four Score takes both ports, and goes away when either is replaced */
+void input_setport(int num, int device)
+{
+   if (INP_DEV_FOURSCORE == device)
+      port[0].device = port[1].device = device;
+   else
+   {
+      if (INP_DEV_FOURSCORE == port[num ^ 1].device)
+         port[num ^ 1].device = INP_DEV_JOYPAD;
+      port[num].device = device;
+   }
+
+   latch_port(0);
+   latch_port(1);
+}
+
+int input_getport(int num)
+{
+   return port[num].device;
+}
+
+void input_setpoll(void (*poll)(void))
+{
+   input_poll = poll;
+   poll_cycles = nes6502_getcycles(false) - POLL_INTERVAL;
 }
 
 /*
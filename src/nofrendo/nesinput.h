@@ -40,6 +40,15 @@
 #define  INP_ZAPPER_MISS   0x08
 #define  INP_ZAPPER_TRIG   0x10
 
+#define  INP_ARKANOID_FIRE 0x08
+
+/* zapper aim and arkanoid knob ride above the buttons in nesinput_t.data,
+** the knob reading in x (higher is further right), only one source sets them
+*/
+#define  INP_POS(x, y)     ((((y) & 0xFF) << 16) | (((x) & 0xFF) << 8))
+#define  INP_POS_X(data)   (((data) >> 8) & 0xFF)
+#define  INP_POS_Y(data)   (((data) >> 16) & 0xFF)
+
 #define  INP_JOYPAD0       0x0001
 #define  INP_JOYPAD1       0x0002
 #define  INP_ZAPPER        0x0004
@@ -47,6 +56,8 @@
 #define  INP_ARKANOID      0x0010
 #define  INP_VSDIPSW0      0x0020
 #define  INP_VSDIPSW1      0x0040
+#define  INP_JOYPAD2       0x0080
+#define  INP_JOYPAD3       0x0100
 
 /* upper byte is what's returned in D4, lower is D3 */
 #define  INP_PPAD_1        0x0002
@@ -69,6 +80,17 @@ enum
    INP_STATE_MAKE
 };
 
+/* what's plugged into $4016 (port 0) and $4017 (port 1) */
+enum
+{
+   INP_DEV_NONE,
+   INP_DEV_JOYPAD,      /* joypad 0 on port 0, joypad 1 on port 1 */
+   INP_DEV_FOURSCORE,   /* takes both ports: joypads 0,2 on port 0, 1,3 on port 1 */
+   INP_DEV_ZAPPER,
+   INP_DEV_ARKANOID,
+   INP_DEV_POWERPAD
+};
+
 typedef struct nesinput_s
 {
    int type;
@@ -77,10 +99,13 @@ typedef struct nesinput_s
 
 #define  MAX_CONTROLLERS   32
 
-extern uint8 input_get(int type);
+extern uint8 input_read(int port);
 extern void input_register(nesinput_t *input);
 extern void input_event(nesinput_t *input, int state, int value);
 extern void input_strobe(void);
+extern void input_setport(int port, int device);
+extern int input_getport(int port);
+extern void input_setpoll(void (*poll)(void));
 
 #endif /* _NESINPUT_H_ */
 
@@ -276,6 +276,7 @@ static void load_vramblock(nes_t *state, SNSS_FILE *snssFile)
 
    ASSERT(snssFile->vramBlock.vramSize <= VRAM_8K); /* can't handle more than this! */
    memcpy(state->rominfo->vram, snssFile->vramBlock.vram, snssFile->vramBlock.vramSize);
+   ppu_chrdirty();
 }
 
 static void load_sramblock(nes_t *state, SNSS_FILE *snssFile)
@@ -29,6 +29,7 @@
 
 #include "version.h"
 #include "nes.h"
+#include "../title_arena.h"
 
 // TODO. this is really ugly. need to resolve with emu_nofrendo
 
@@ -227,12 +228,18 @@ int nes_emulate_init(const char* path, int width, int height)
         _nes_p = nes_create();
         vid_setmode(NES_SCREEN_WIDTH, 240);
     }
-    if (nes_insertcart(path,_nes_p))
+    else
+        nes_ejectcart(_nes_p);      // saves battery ram before the arena lets it go
+
+    // everything the cart allocates while loading comes from the title arena
+    arena_begin();
+    int err = nes_insertcart(path,_nes_p);
+    arena_end();
+    if (err)
         return -1;
 
     osd_setsound(_nes_p->apu->process);
     _nes_p->scanline_cycles = 0;
-    _nes_p->fiq_cycles = (int) NES_FIQ_PERIOD;
     return 0;
 }
 
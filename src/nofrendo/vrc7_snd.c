@@ -0,0 +1,103 @@
+/*
+** Nofrendo (c) 1998-2000 Matthew Conte (matt@conte.com)
+**
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of version 2 of the GNU Library General 
+** Public License as published by the Free Software Foundation.
+**
+** This program is distributed in the hope that it will be useful, 
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU 
+** Library General Public License for more details.  To obtain a 
+** copy of the GNU Library General Public License, write to the Free 
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+**
+**
+** vrc7_snd.c
+**
+** Konami VRC7 FM sound hardware emulation
+*/
+
+#include "noftypes.h"
+#include "nes_apu.h"
+#include "vrc7_snd.h"
+#include "../smsplus/opll.h"
+
+/* the VRC7's OPLL runs off its own 3.58MHz crystal */
+#define  VRC7_CLOCK     3579545
+
+static struct
+{
+   OPLL *opll;
+   uint8 latch;
+} vrc7;
+
+static void vrc7_write(uint32 address, uint8 value)
+{
+   if (0x9010 == address)
+      vrc7.latch = value;
+   else if (vrc7.opll)
+      OPLL_writeReg(vrc7.opll, vrc7.latch, value);
+}
+
+/* mix vrc7 sound channels into a block of samples */
+static void vrc7_process(int32 *buffer, int num_samples)
+{
+   if (vrc7.opll)
+      OPLL_calc_block(vrc7.opll, buffer, num_samples);
+}
+
+static void vrc7_reset(void)
+{
+   vrc7.latch = 0;
+   if (vrc7.opll)
+   {
+      OPLL_reset(vrc7.opll);
+      OPLL_reset_patch(vrc7.opll, OPLL_VRC7_TONE);
+   }
+}
+
+static int vrc7_init(void)
+{
+   apu_t apu;
+
+   apu_getcontext(&apu);
+   OPLL_init(VRC7_CLOCK, apu.sample_rate);
+   vrc7.opll = OPLL_new();
+   if (NULL == vrc7.opll)
+      return -1;
+
+   OPLL_reset_patch(vrc7.opll, OPLL_VRC7_TONE);
+   return 0;
+}
+
+static void vrc7_shutdown(void)
+{
+   if (vrc7.opll)
+   {
+      OPLL_delete(vrc7.opll);
+      vrc7.opll = NULL;
+   }
+}
+
+static apu_memwrite vrc7_memwrite[] =
+{
+   { 0x9010, 0x9010, vrc7_write }, /* register select */
+   { 0x9030, 0x9030, vrc7_write }, /* register data */
+   {     -1,     -1, NULL }
+};
+
+apuext_t vrc7_ext =
+{
+   vrc7_init,
+   vrc7_shutdown,
+   vrc7_reset,
+   NULL, /* block output only */
+   NULL, /* no reads */
+   vrc7_memwrite,
+   vrc7_process
+};
@@ -0,0 +1,166 @@
+/*
+** Nofrendo (c) 1998-2000 Matthew Conte (matt@conte.com)
+**
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of version 2 of the GNU Library General 
+** Public License as published by the Free Software Foundation.
+**
+** This program is distributed in the hope that it will be useful, 
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU 
+** Library General Public License for more details.  To obtain a 
+** copy of the GNU Library General Public License, write to the Free 
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+**
+**
+** vrcirq.c
+**
+** Konami VRC4/VRC6/VRC7 IRQ counter
+*/
+
+#include "noftypes.h"
+#include "nes.h"
+#include "nes6502.h"
+#include "nes_sched.h"
+#include "vrcirq.h"
+
+/* An 8 bit up counter clocked every scanline (341 PPU dots) or, in cycle
+** mode, every CPU cycle, which raises an IRQ and reloads from the latch
+** when it overflows.  The counter itself can't be read, so rather than
+** clocking it only the overflow is scheduled.
+*/
+static struct
+{
+   int counter, latch;
+   bool enabled, wait_state, cycle_mode;
+   uint32 start;                 /* cycle it started counting from counter */
+   int prescaler;                /* PPU dots (1/3 cycles) of a line already counted at start */
+} irq;
+
+static void vrcirq_overflow(void);
+
+/* CPU cycles from start to clock the counter this many times */
+static int vrcirq_cycles(int clocks)
+{
+   if (irq.cycle_mode)
+      return clocks;
+   return (clocks * 341 - irq.prescaler + 2) / 3;
+}
+
+/* bring irq.counter up to date */
+static void vrcirq_sync(void)
+{
+   uint32 now = nes6502_getcycles(false);
+   int elapsed;
+
+   if (false == irq.enabled)
+      return;
+
+   elapsed = (int32) (now - irq.start);
+   if (false == irq.cycle_mode)
+   {
+      /* carry the part of a line already counted, or IRQs drift later */
+      int dots = elapsed * 3 + irq.prescaler;
+      elapsed = dots / 341;
+      irq.prescaler = dots % 341;
+   }
+   irq.counter += elapsed;
+   if (irq.counter > 0xFF)
+      irq.counter = 0xFF;
+   irq.start = now;
+}
+
+static void vrcirq_schedule(void)
+{
+   if (irq.enabled)
+   {
+      irq.start = nes6502_getcycles(false);
+      sched_in(SCHED_MAPPER, vrcirq_cycles(256 - irq.counter), vrcirq_overflow);
+   }
+   else
+   {
+      sched_cancel(SCHED_MAPPER);
+   }
+}
+
+static void vrcirq_overflow(void)
+{
+   uint32 when = sched_when(SCHED_MAPPER);
+
+   /* the overflow lands up to 2 dots into the next line */
+   if (false == irq.cycle_mode)
+      irq.prescaler = ((int32) (when - irq.start) * 3 + irq.prescaler) % 341;
+   irq.counter = irq.latch;
+   irq.start = when;
+   sched_at(SCHED_MAPPER, irq.start + vrcirq_cycles(256 - irq.latch), vrcirq_overflow);
+   nes_irq();
+}
+
+void vrcirq_reset(void)
+{
+   irq.counter = irq.latch = 0;
+   irq.enabled = irq.wait_state = irq.cycle_mode = false;
+   irq.prescaler = 0;
+   sched_cancel(SCHED_MAPPER);
+}
+
+void vrcirq_latch(uint8 value)
+{
+   irq.latch = value;
+}
+
+void vrcirq_latch_lo(uint8 value)
+{
+   irq.latch = (irq.latch & 0xF0) | (value & 0x0F);
+}
+
+void vrcirq_latch_hi(uint8 value)
+{
+   irq.latch = (irq.latch & 0x0F) | ((value & 0x0F) << 4);
+}
+
+void vrcirq_control(uint8 value)
+{
+   nes_irq_ack();
+
+   irq.wait_state = (value & 0x01) ? true : false;
+   irq.enabled = (value & 0x02) ? true : false;
+   irq.cycle_mode = (value & 0x04) ? true : false;
+   if (irq.enabled)
+   {
+      irq.counter = irq.latch;
+      irq.prescaler = 0;
+   }
+   vrcirq_schedule();
+}
+
+void vrcirq_ack(void)
+{
+   nes_irq_ack();
+
+   if (irq.enabled != irq.wait_state)
+   {
+      vrcirq_sync();
+      irq.enabled = irq.wait_state;
+      vrcirq_schedule();
+   }
+}
+
+void vrcirq_getstate(uint8 *counter, uint8 *enabled)
+{
+   vrcirq_sync();
+   *counter = irq.counter;
+   *enabled = irq.enabled;
+}
+
+void vrcirq_setstate(uint8 counter, uint8 enabled)
+{
+   irq.counter = counter;
+   irq.enabled = enabled ? true : false;
+   irq.prescaler = 0;
+   vrcirq_schedule();
+}
@@ -0,0 +1,41 @@
+/*
+** Nofrendo (c) 1998-2000 Matthew Conte (matt@conte.com)
+**
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of version 2 of the GNU Library General 
+** Public License as published by the Free Software Foundation.
+**
+** This program is distributed in the hope that it will be useful, 
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU 
+** Library General Public License for more details.  To obtain a 
+** copy of the GNU Library General Public License, write to the Free 
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+**
+**
+** vrcirq.h
+**
+** Konami VRC4/VRC6/VRC7 IRQ counter
+*/
+
+#ifndef _VRCIRQ_H_
+#define _VRCIRQ_H_
+
+#include "noftypes.h"
+
+extern void vrcirq_reset(void);
+
+extern void vrcirq_latch(uint8 value);
+extern void vrcirq_latch_lo(uint8 value);
+extern void vrcirq_latch_hi(uint8 value);
+extern void vrcirq_control(uint8 value);
+extern void vrcirq_ack(void);
+
+extern void vrcirq_getstate(uint8 *counter, uint8 *enabled);
+extern void vrcirq_setstate(uint8 counter, uint8 enabled);
+
+#endif /* _VRCIRQ_H_ */
@@ -66,69 +66,81 @@ typedef struct vrcvisnd_s
 static vrcvisnd_t vrcvi;
 
 /* VRCVI rectangle wave generation */
-static int32 vrcvi_rectangle(vrcvirectangle_t *chan)
+static void vrcvi_rectangle(vrcvirectangle_t *chan, int32 *buffer, int num_samples)
 {
+   float accum = chan->accum;
+   uint8 adder = chan->adder;
+   int32 volume = chan->enabled ? chan->volume : 0;
+
    /* reg0: 0-3=volume, 4-6=duty cycle
    ** reg1: 8 bits of freq
    ** reg2: 0-3=high freq, 7=enable
    */
 
-   chan->accum -= vrcvi.incsize; /* # of clocks per wave cycle */
-   while (chan->accum < 0)
+   while (num_samples--)
    {
-      chan->accum += chan->freq;
-      chan->adder = (chan->adder + 1) & 0x0F;
-   }
+      accum -= vrcvi.incsize; /* # of clocks per wave cycle */
+      while (accum < 0)
+      {
+         accum += chan->freq;
+         adder = (adder + 1) & 0x0F;
+      }
 
-   /* return if not enabled */
-   if (false == chan->enabled)
-      return 0;
+      /* a disabled channel keeps its phase running but outputs nothing */
+      if (adder < chan->duty_flip)
+         *buffer++ -= volume;
+      else
+         *buffer++ += volume;
+   }
 
-   if (chan->adder < chan->duty_flip)
-      return -(chan->volume);
-   else
-      return chan->volume;
+   chan->accum = accum;
+   chan->adder = adder;
 }
 
 /* VRCVI sawtooth wave generation */
-static int32 vrcvi_sawtooth(vrcvisawtooth_t *chan)
+static void vrcvi_sawtooth(vrcvisawtooth_t *chan, int32 *buffer, int num_samples)
 {
+   float accum = chan->accum;
+   uint8 adder = chan->adder;
+   uint8 output_acc = chan->output_acc;
+
    /* reg0: 0-5=phase accumulator bits
    ** reg1: 8 bits of freq
    ** reg2: 0-3=high freq, 7=enable
    */
 
-   chan->accum -= vrcvi.incsize; /* # of clocks per wav cycle */
-   while (chan->accum < 0)
+   while (num_samples--)
    {
-      chan->accum += chan->freq;
-      chan->output_acc += chan->volume;
-      
-      chan->adder++;
-      if (7 == chan->adder)
+      accum -= vrcvi.incsize; /* # of clocks per wav cycle */
+      while (accum < 0)
       {
-         chan->adder = 0;
-         chan->output_acc = 0;
+         accum += chan->freq;
+         output_acc += chan->volume;
+
+         adder++;
+         if (7 == adder)
+         {
+            adder = 0;
+            output_acc = 0;
+         }
       }
-   }
 
-   /* return if not enabled */
-   if (false == chan->enabled)
-      return 0;
+      if (chan->enabled)
+         *buffer += (output_acc >> 3) << 9;
+      buffer++;
+   }
 
-   return (chan->output_acc >> 3) << 9;
+   chan->accum = accum;
+   chan->adder = adder;
+   chan->output_acc = output_acc;
 }
 
-/* mix vrcvi sound channels together */
-static int32 vrcvi_process(void)
+/* mix vrcvi sound channels into a block of samples */
+static void vrcvi_process(int32 *buffer, int num_samples)
 {
-   int32 output;
-
-   output = vrcvi_rectangle(&vrcvi.rectangle[0]);
-   output += vrcvi_rectangle(&vrcvi.rectangle[1]);
-   output += vrcvi_sawtooth(&vrcvi.saw);
-
-   return output;
+   vrcvi_rectangle(&vrcvi.rectangle[0], buffer, num_samples);
+   vrcvi_rectangle(&vrcvi.rectangle[1], buffer, num_samples);
+   vrcvi_sawtooth(&vrcvi.saw, buffer, num_samples);
 }
 
 /* write to registers */
@@ -211,9 +223,10 @@ apuext_t vrcvi_ext =
    NULL, /* no init */
    NULL, /* no shutdown */
    vrcvi_reset,
-   vrcvi_process,
+   NULL, /* block output only */
    NULL, /* no reads */
-   vrcvi_memwrite
+   vrcvi_memwrite,
+   vrcvi_process
 };
 
 /*
@@ -9,7 +9,9 @@
  *  Changes from the original version
  *  ---------------------------------
  *    – “Dead page” is now a full 8 KiB, so page 7 access is in‑bounds.
- *    – WRAM starts **disabled** after power‑on, matching real MMC3/6.
+ *    – WRAM starts enabled, like the $6000 mapping nes_insertcart() sets up;
+ *      games that care write $A001 before touching it.
+ *    – Banks and enable changes go through the live CPU context.
  *    – add_write_handler() refuses to install a duplicate gate.
  *    – mmc_bankwram() accepts both 4 KiB and 8 KiB requests.
  *    – Extra comments on MMC6’s inverted WP bit.
@@ -38,29 +40,24 @@ static uint8_t dead_page[PAGE_SIZE] = { [0 ... PAGE_SIZE - 1] = 0xFF };
 /*──────────────────── Internal helpers ──────────────────────*/
 static void remap_page(void)
 {
-    nes_t *ctx = nes_getcontextptr();
-    if (!ctx)                            /* core not initialised yet?  */
-        return;
-
+    nes6502_context cpu;
     uint8_t *page0 = (wram_en && base) ? (base + cur_bank * PAGE_SIZE)
                                        : dead_page;
 
-    ctx->cpu->mem_page[6] = page0;
-    ctx->cpu->mem_page[7] = page0 + 0x1000;
+    /* same dance as mmc_bankrom(), the running core has its own copy */
+    nes6502_getcontext(&cpu);
+    cpu.mem_page[6] = page0;
+    cpu.mem_page[7] = page0 + 0x1000;
+    nes6502_setcontext(&cpu);
 }
 
 /* $6000‑7FFF write gate */
 static void wram_write(uint32_t addr, uint8_t val)
 {
-    if (!wram_en || !base)
-        return;                         
-    if (wram_wp) {
-       printf("WRAM write %04X while WP set, PC=%04X\n",  (unsigned)addr,(unsigned)NES->cpu->pc_reg);   /* or another PC getter */
-    }
-
-    /* Inlined bank_writebyte() – faster, no extra symbol needed */
-    NES->cpu->mem_page[addr >> NES6502_BANKSHIFT]
-                     [addr &  NES6502_BANKMASK] = val;
+    if (!wram_en || wram_wp || !base)
+        return;
+
+    base[cur_bank * PAGE_SIZE + (addr - WINDOW_START)] = val;
 }
 
 /* Push our handler into the machine’s write‑handler table (idempotent) */
@@ -122,11 +119,13 @@ void wram_init(struct nes_s *nes)
         return;
 
     base     = nes->rominfo->sram;
-    banks    = nes->rominfo->sram_banks ? nes->rominfo->sram_banks : 1;
+    banks    = nes->rominfo->sram_banks * 0x400 / PAGE_SIZE;   /* sram_banks are 1 KiB */
+    if (banks < 1)
+        banks = 1;
     cur_bank = 0;
 
-    /* power-on state = disabled & writable */
-    wram_en  = false;
+    /* power-on state = enabled & writable, matching the mapping already in place */
+    wram_en  = true;
     wram_wp  = false;
 
     /* 1.  Install the write gate so CPU writes are captured                     */
@@ -0,0 +1,180 @@
+#include "perf_counters.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include "Arduino.h"
+static inline uint32_t perf_ticks() { return xthal_get_ccount(); }
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint32_t perf_ticks() { return (uint32_t)__rdtsc(); }
+#else
+#include <time.h>
+static inline uint32_t perf_ticks()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec*1000000000ULL + ts.tv_nsec);
+}
+#endif
+
+static const char* _perf_names[PERF_COUNT] = {
+    "cpu", "render", "audio", "gui", "input", "io"
+};
+
+typedef struct {
+    uint32_t frame;                 // cycles this frame
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PERF_BUCKETS];
+} perf_counter;
+
+typedef struct {
+    perf_counter c[PERF_COUNT];
+    uint32_t frames;
+    uint32_t budget;
+} perf_window;
+
+// the emulator task accumulates into _perf and publishes every PERF_WINDOW frames.
+// readers on either core copy _perf_last under _perf_seq, odd while it's being written.
+#define PERF_WINDOW 120
+
+static perf_window _perf;           // accumulating, emulator task only
+static perf_window _perf_last;      // last completed window
+static std::atomic<uint32_t> _perf_seq(0);
+
+// small stack of open scopes, time is charged to the innermost
+#define PERF_DEPTH 8
+static uint8_t _stack[PERF_DEPTH];
+static int _depth = 0;
+static uint32_t _mark = 0;
+
+// scopes nested deeper than PERF_DEPTH keep charging the deepest one tracked
+static void perf_charge()
+{
+    uint32_t t = perf_ticks();
+    if (_depth)
+        _perf.c[_stack[(_depth < PERF_DEPTH ? _depth : PERF_DEPTH)-1]].frame += t - _mark;
+    _mark = t;
+}
+
+extern "C"
+void perf_begin(int id)
+{
+    perf_charge();
+    if (_depth < PERF_DEPTH)
+        _stack[_depth] = (uint8_t)(id < PERF_COUNT ? id : PERF_CPU);
+    _depth++;
+}
+
+extern "C"
+void perf_end()
+{
+    if (!_depth)
+        return;
+    perf_charge();
+    _depth--;
+}
+
+static void perf_reset(perf_window& w)
+{
+    memset(&w,0,sizeof(w));
+    for (int i = 0; i < PERF_COUNT; i++)
+        w.c[i].min = 0xFFFFFFFF;
+}
+
+extern "C"
+void perf_frame(uint32_t budget)
+{
+    static bool inited = false;
+    if (!inited) {
+        perf_reset(_perf);
+        inited = true;
+    }
+    perf_charge();
+    for (int i = 0; i < PERF_COUNT; i++) {
+        perf_counter& c = _perf.c[i];
+        uint32_t f = c.frame;
+        c.frame = 0;
+        if (f < c.min) c.min = f;
+        if (f > c.max) c.max = f;
+        c.sum += f;
+        uint32_t b = budget ? (uint32_t)(((uint64_t)f*PERF_BUCKETS)/budget) : 0;
+        c.hist[b < PERF_BUCKETS ? b : PERF_BUCKETS-1]++;
+    }
+    _perf.budget = budget;
+    if (++_perf.frames < PERF_WINDOW)
+        return;
+
+    uint32_t seq = _perf_seq.load(std::memory_order_relaxed);
+    _perf_seq.store(seq + 1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _perf_last = _perf;
+    _perf_seq.store(seq + 2,std::memory_order_release);
+    perf_reset(_perf);
+}
+
+// copy of the last completed window, returns its sequence or 0 if there isn't one yet
+static uint32_t perf_snapshot(perf_window& w)
+{
+    for (;;) {
+        uint32_t seq = _perf_seq.load(std::memory_order_acquire);
+        if (!seq)
+            return 0;
+        if (seq & 1)
+            continue;                   // publish in progress on the other core
+        w = _perf_last;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_perf_seq.load(std::memory_order_relaxed) == seq)
+            return seq;
+    }
+}
+
+static uint32_t avg(const perf_counter& c, uint32_t frames)
+{
+    return frames ? (uint32_t)(c.sum/frames) : 0;
+}
+
+extern "C"
+int perf_summary(char* buf, int len)
+{
+    static uint32_t printed = 0;
+    perf_window w;
+    uint32_t seq = perf_snapshot(w);
+    if (!seq || seq == printed || !w.budget)
+        return 0;
+    printed = seq;
+
+    int n = 0;
+    for (int i = 0; i < PERF_COUNT && n < len; i++) {
+        const perf_counter& c = w.c[i];
+        n += snprintf(buf+n,len-n,"%s%s:%d%%(%d%%)",i ? " " : "",_perf_names[i],
+            (int)((avg(c,w.frames)*100ULL)/w.budget),(int)((c.max*100ULL)/w.budget));
+    }
+    return n;
+}
+
+// name, average % of frame, worst case, then a histogram of frames by 1/8ths of the budget
+extern "C"
+int perf_format(int line, char* buf, int len)
+{
+    if (line == 0)
+        return snprintf(buf,len,"%-6s avg  max  0%%....100%%","cycles");
+    perf_window w;
+    if (line > PERF_COUNT || !perf_snapshot(w) || !w.frames || !w.budget)
+        return 0;
+
+    const perf_counter& c = w.c[line-1];
+    char hist[PERF_BUCKETS+1];
+    for (int i = 0; i < PERF_BUCKETS; i++) {
+        static const char* shades = " .:-=+*#";
+        uint32_t s = (c.hist[i]*7 + w.frames - 1)/w.frames;    // any hits show up
+        hist[i] = shades[s];
+    }
+    hist[PERF_BUCKETS] = 0;
+    return snprintf(buf,len,"%-6s %3d%% %3d%% |%s|",_perf_names[line-1],
+        (int)((avg(c,w.frames)*100ULL)/w.budget),(int)((c.max*100ULL)/w.budget),hist);
+}
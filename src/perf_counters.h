@@ -0,0 +1,57 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+// Per-subsystem cycle accounting for the emulator core.
+// Scopes nest and are exclusive: entering RENDER from inside CPU stops charging
+// CPU until RENDER ends, so the counters add up to the time spent in gui_update().
+// Only meant to be used from the emulator task, which closes a window every 120
+// frames; perf_summary() and perf_format() read the last one from either core.
+
+#ifndef PERF_COUNTERS
+#define PERF_COUNTERS 1
+#endif
+
+enum {
+    PERF_CPU,       // cpu emulation, whatever isn't claimed by a nested scope
+    PERF_RENDER,    // ppu/vdp/antic line rendering
+    PERF_AUDIO,     // sound synthesis and audio_write
+    PERF_GUI,       // overlay drawing
+    PERF_INPUT,     // hid, gpio, glitch pot polling
+    PERF_IO,        // file reads
+    PERF_COUNT
+};
+
+#define PERF_BUCKETS 8  // histogram buckets, each 1/8 of a frame
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void perf_begin(int id);
+void perf_end();
+void perf_frame(uint32_t budget);                   // close a frame, budget in cycles
+int perf_summary(char* buf, int len);               // one line summary of a window not yet printed
+int perf_format(int line, char* buf, int len);      // overlay lines, returns 0 past the end
+
+#ifdef __cplusplus
+}
+
+struct PerfScope {
+    PerfScope(int id) { perf_begin(id); }
+    ~PerfScope() { perf_end(); }
+};
+#endif
+
+#if PERF_COUNTERS
+#define PERF_BEGIN(_id) perf_begin(_id)
+#define PERF_END() perf_end()
+#define PERF_SCOPE(_id) PerfScope _perf_scope(_id)
+#else
+#define PERF_BEGIN(_id) do {} while (0)
+#define PERF_END() do {} while (0)
+#define PERF_SCOPE(_id) do {} while (0)
+#endif
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,504 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include "opll.h"
+
+/*
+    Attenuation is kept in 0.1875 dB units throughout (TL is 0.75 dB, the
+    channel volume 3 dB and the envelope 0.375 dB per step) and is turned
+    into a 1/256 octave offset into the log-sin table when a block starts.
+    The phase accumulators are 32 bits wide with the 10 bit table index on
+    top, stepped at the output rate rather than at the chip's clk/72.
+*/
+
+#ifndef M_PI
+#define M_PI            (3.14159265358979323846)
+#endif
+
+#define EG_SHIFT        (15)
+#define EG_MAX          (127 << EG_SHIFT)
+#define ATT_MAX         (511)
+
+enum { EG_ATTACK, EG_DECAY, EG_SUSTAIN, EG_RELEASE, EG_FINISH };
+
+typedef struct
+{
+    /* patch */
+    uint8_t am, pm, eg_type, ksr, mult, ksl, wf, fb;
+    uint8_t ar, dr, sl, rr;
+
+    /* state */
+    uint8_t key;
+    uint8_t state;
+    uint32_t eg;
+    uint32_t phase;
+    uint32_t inc;           /* phase step for the current block (vibrato applied) */
+    uint32_t base_inc;
+    int tll;                /* TL or volume plus key scale level */
+    int ksr_val;
+    int att8;               /* total attenuation, log-sin units */
+    int out[2];             /* last two outputs, for feedback */
+}OPLL_SLOT;
+
+struct OPLL_s
+{
+    uint8_t reg[0x40];
+    uint8_t tone[19][8];
+    int channels;           /* 9, or 6 for VRC7 */
+    int rhythm;
+    OPLL_SLOT slot[18];
+    uint32_t noise;
+    uint32_t am_phase;
+    uint32_t pm_phase;
+    int am_val;
+    int pm_val;
+    int eg_count;
+};
+
+static const unsigned char ym2413_tone[19 * 16] =
+{
+#include "ym2413tone.h"
+};
+
+static const unsigned char vrc7_tone[19 * 16] =
+{
+#include "vrc7tone.h"
+};
+
+/* multiplier x 2 */
+static const uint8_t mult_tab[16] = { 1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 20, 24, 24, 30, 30 };
+static const uint8_t ksl_tab[16] = { 0, 32, 40, 45, 48, 51, 53, 55, 56, 58, 59, 60, 61, 62, 63, 64 };
+static const uint8_t ksl_shift[4] = { 8, 2, 1, 0 };
+static const int8_t pm_tab[8] = { 0, 1, 2, 1, 0, -1, -2, -1 };
+
+static uint16_t logsin_tab[256];    /* -log2(sin), quarter wave, 1/256 octave */
+static uint16_t exp_tab[256];       /* 2^-x, 4096 full scale */
+static uint32_t eg_rate_tab[64];    /* envelope step per sample at each rate */
+static uint32_t phase_scale;        /* chip phase step to output rate, 12.20 */
+static uint32_t am_step, pm_step;
+
+void OPLL_init(unsigned int clk, unsigned int rate)
+{
+    double ratio = (clk / 72.0) / rate;
+    int i;
+
+    for(i = 0; i < 256; i += 1)
+    {
+        double s = sin((i + 0.5) * M_PI / 512.0);
+        logsin_tab[i] = (uint16_t)(-log(s) / log(2.0) * 256.0 + 0.5);
+        exp_tab[i] = (uint16_t)(pow(2.0, -i / 256.0) * 4096.0 + 0.5);
+    }
+
+    /* (4 + r) << (rate / 4) envelope steps per 32768 chip samples, as on the OPL */
+    for(i = 0; i < 64; i += 1)
+        eg_rate_tab[i] = (i < 4) ? 0 : (uint32_t)((double)((4 + (i & 3)) << (i >> 2)) * (1 << EG_SHIFT) / 32768.0 * ratio);
+
+    phase_scale = (uint32_t)(ratio * (1 << 20) + 0.5);
+
+    /* 3.7 Hz tremolo, 6.4 Hz vibrato */
+    am_step = (uint32_t)(3.7 * 4294967296.0 / rate);
+    pm_step = (uint32_t)(6.4 * 4294967296.0 / rate);
+}
+
+OPLL *OPLL_new(void)
+{
+    OPLL *opll = (OPLL *)malloc(sizeof(OPLL));
+    if(!opll) return NULL;
+    memset(opll, 0, sizeof(OPLL));
+    OPLL_reset_patch(opll, OPLL_2413_TONE);
+    OPLL_reset(opll);
+    return opll;
+}
+
+void OPLL_delete(OPLL *opll)
+{
+    free(opll);
+}
+
+void OPLL_reset(OPLL *opll)
+{
+    int i;
+
+    memset(opll->reg, 0, sizeof(opll->reg));
+    memset(opll->tone[0], 0, 8);
+    memset(opll->slot, 0, sizeof(opll->slot));
+    for(i = 0; i < 18; i += 1)
+    {
+        opll->slot[i].state = EG_FINISH;
+        opll->slot[i].eg = EG_MAX;
+        opll->slot[i].att8 = ATT_MAX << 3;
+    }
+    opll->rhythm = 0;
+    opll->noise = 1;
+    opll->am_phase = opll->pm_phase = 0;
+    opll->am_val = opll->pm_val = 0;
+    opll->eg_count = OPLL_EG_BLOCK;
+}
+
+/* Load the instrument ROM; user instrument 0 is left alone */
+void OPLL_reset_patch(OPLL *opll, int type)
+{
+    const unsigned char *tone = (type == OPLL_VRC7_TONE) ? vrc7_tone : ym2413_tone;
+    int i;
+
+    for(i = 1; i < 19; i += 1)
+        memcpy(opll->tone[i], &tone[i * 16], 8);
+    opll->channels = (type == OPLL_VRC7_TONE) ? 6 : 9;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Register side                                                            */
+/*--------------------------------------------------------------------------*/
+
+static uint32_t slot_inc(int fnum, int block, int mult)
+{
+    uint64_t inc = ((uint64_t)(fnum << block) * mult_tab[mult] * phase_scale) >> 8;
+    return (inc > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)inc;
+}
+
+/* Recompute the static attenuation of a slot for the current block */
+static void slot_att(OPLL *opll, OPLL_SLOT *s)
+{
+    int att = s->tll + ((s->eg >> EG_SHIFT) << 1);
+    if(s->am) att += opll->am_val;
+    if(att > ATT_MAX) att = ATT_MAX;
+    s->att8 = att << 3;
+}
+
+static void update_channel(OPLL *opll, int ch)
+{
+    int fnum = opll->reg[0x10 + ch] | ((opll->reg[0x20 + ch] & 1) << 8);
+    int block = (opll->reg[0x20 + ch] >> 1) & 7;
+    int inst = opll->reg[0x30 + ch] >> 4;
+    int vol = opll->reg[0x30 + ch] & 0x0F;
+    int ksl_base = (ksl_tab[fnum >> 5] << 2) - ((8 - block) << 5);
+    const uint8_t *t;
+    int i;
+
+    if(opll->rhythm && ch >= 6)
+        inst = 16 + (ch - 6);
+    t = opll->tone[inst];
+
+    for(i = 0; i < 2; i += 1)
+    {
+        OPLL_SLOT *s = &opll->slot[ch * 2 + i];
+
+        s->am       = t[i] & 0x80;
+        s->pm       = t[i] & 0x40;
+        s->eg_type  = t[i] & 0x20;
+        s->ksr      = t[i] & 0x10;
+        s->mult     = t[i] & 0x0F;
+        s->ksl      = t[2 + i] >> 6;
+        s->wf       = i ? (t[3] >> 4) & 1 : (t[3] >> 3) & 1;
+        s->fb       = i ? 0 : t[3] & 7;
+        s->ar       = t[4 + i] >> 4;
+        s->dr       = t[4 + i] & 0x0F;
+        s->sl       = t[6 + i] >> 4;
+        s->rr       = t[6 + i] & 0x0F;
+
+        if(i)
+            s->tll = vol << 4;
+        else if(opll->rhythm && ch >= 7)
+            s->tll = (opll->reg[0x30 + ch] >> 4) << 4;     /* hi-hat, tom */
+        else
+            s->tll = (t[2] & 0x3F) << 2;
+
+        if(s->ksl && ksl_base > 0)
+            s->tll += ksl_base >> ksl_shift[s->ksl];
+
+        s->ksr_val = ((block << 1) | (fnum >> 8)) >> (s->ksr ? 0 : 2);
+        s->base_inc = slot_inc(fnum, block, s->mult);
+        s->inc = s->base_inc;
+        slot_att(opll, s);
+    }
+}
+
+static void slot_key(OPLL *opll, OPLL_SLOT *s, int on)
+{
+    if(on && !s->key)
+    {
+        s->state = EG_ATTACK;
+        s->phase = 0;
+        s->out[0] = s->out[1] = 0;
+        if(s->ar == 15) s->eg = 0;
+        slot_att(opll, s);
+    }
+    else if(!on && s->key && s->state != EG_FINISH)
+    {
+        s->state = EG_RELEASE;
+    }
+    s->key = on;
+}
+
+static void update_key(OPLL *opll, int ch)
+{
+    int key = opll->reg[0x20 + ch] & 0x10;
+    int r = opll->rhythm ? opll->reg[0x0E] : 0;
+
+    switch(ch)
+    {
+        case 6:
+            slot_key(opll, &opll->slot[12], key || (r & 0x10));
+            slot_key(opll, &opll->slot[13], key || (r & 0x10));
+            break;
+        case 7:
+            slot_key(opll, &opll->slot[14], key || (r & 0x01));
+            slot_key(opll, &opll->slot[15], key || (r & 0x08));
+            break;
+        case 8:
+            slot_key(opll, &opll->slot[16], key || (r & 0x04));
+            slot_key(opll, &opll->slot[17], key || (r & 0x02));
+            break;
+        default:
+            slot_key(opll, &opll->slot[ch * 2], key);
+            slot_key(opll, &opll->slot[ch * 2 + 1], key);
+            break;
+    }
+}
+
+void OPLL_writeReg(OPLL *opll, unsigned int reg, unsigned int data)
+{
+    int ch;
+
+    reg &= 0x3F;
+    data &= 0xFF;
+    opll->reg[reg] = data;
+
+    if(reg < 0x08)
+    {
+        opll->tone[0][reg] = data;
+        for(ch = 0; ch < opll->channels; ch += 1)
+            if((opll->reg[0x30 + ch] >> 4) == 0)
+                update_channel(opll, ch);
+        return;
+    }
+
+    if(reg == 0x0E)
+    {
+        if(opll->channels < 9) return;
+        opll->rhythm = (data & 0x20) ? 1 : 0;
+        for(ch = 6; ch < 9; ch += 1)
+        {
+            update_channel(opll, ch);
+            update_key(opll, ch);
+        }
+        return;
+    }
+
+    ch = reg & 0x0F;
+    if(reg < 0x10 || ch >= opll->channels) return;
+
+    switch(reg & 0xF0)
+    {
+        case 0x10:
+        case 0x30:
+            update_channel(opll, ch);
+            break;
+        case 0x20:
+            update_channel(opll, ch);
+            update_key(opll, ch);
+            break;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Envelopes                                                                */
+/*--------------------------------------------------------------------------*/
+
+static uint32_t eg_step(OPLL_SLOT *s, int rate, int n)
+{
+    int r;
+    if(!rate) return 0;
+    r = (rate << 2) + s->ksr_val;
+    return eg_rate_tab[r > 63 ? 63 : r] * n;
+}
+
+static void slot_envelope(OPLL_SLOT *s, int sus, int n)
+{
+    uint32_t d;
+
+    switch(s->state)
+    {
+        case EG_ATTACK:
+            d = eg_step(s, s->ar, n);
+            if(!d) break;
+            if(s->ar == 15)
+                s->eg = 0;
+            else
+            {
+                /* exponential approach, fast at first and slow near full volume */
+                d = ((s->eg >> EG_SHIFT) + 4) * (d >> 2);
+                s->eg = (d >= s->eg) ? 0 : s->eg - d;
+            }
+            if(!s->eg) s->state = EG_DECAY;
+            break;
+
+        case EG_DECAY:
+            s->eg += eg_step(s, s->dr, n);
+            if(s->eg >= (uint32_t)(s->sl << (3 + EG_SHIFT)))
+            {
+                s->eg = s->sl << (3 + EG_SHIFT);
+                s->state = EG_SUSTAIN;
+            }
+            break;
+
+        case EG_SUSTAIN:
+            /* percussive tones keep decaying at the release rate */
+            if(!s->eg_type)
+                s->eg += eg_step(s, s->rr, n);
+            break;
+
+        case EG_RELEASE:
+            s->eg += eg_step(s, sus ? 5 : s->eg_type ? s->rr : 7, n);
+            break;
+    }
+
+    if(s->eg >= EG_MAX)
+    {
+        s->eg = EG_MAX;
+        if(s->state != EG_ATTACK) s->state = EG_FINISH;
+    }
+}
+
+/* Step envelopes and LFOs over n samples and latch the next block's values */
+static void eg_tick(OPLL *opll, int n)
+{
+    int ch, i, tri;
+
+    opll->am_phase += am_step * n;
+    opll->pm_phase += pm_step * n;
+    tri = opll->am_phase >> 24;
+    tri = (tri < 128) ? tri : 255 - tri;
+    opll->am_val = (tri * 26) >> 7;                 /* 0 - 4.8 dB */
+    opll->pm_val = pm_tab[opll->pm_phase >> 29];
+
+    for(ch = 0; ch < opll->channels; ch += 1)
+    {
+        int sus = opll->reg[0x20 + ch] & 0x20;
+        for(i = 0; i < 2; i += 1)
+        {
+            OPLL_SLOT *s = &opll->slot[ch * 2 + i];
+            if(s->state == EG_FINISH) continue;
+            slot_envelope(s, sus, n);
+            slot_att(opll, s);
+            s->inc = s->pm ? s->base_inc + opll->pm_val * (int32_t)(s->base_inc >> 9) : s->base_inc;
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Synthesis                                                                */
+/*--------------------------------------------------------------------------*/
+
+/* One operator output: phase is a 10 bit table index, att8 in log-sin units */
+static __inline__ int op_out(unsigned int phase, int att8, int wf)
+{
+    unsigned int l;
+    int v;
+
+    if(wf && (phase & 0x200)) return 0;
+    l = logsin_tab[(phase & 0x100) ? (~phase & 0xFF) : (phase & 0xFF)] + att8;
+    v = (l < (12 << 8)) ? exp_tab[l & 0xFF] >> (l >> 8) : 0;
+    return (phase & 0x200) ? -v : v;
+}
+
+static void render_channel(OPLL_SLOT *m, OPLL_SLOT *c, int *buffer, int length, int gain)
+{
+    uint32_t mphase = m->phase, minc = m->inc;
+    uint32_t cphase = c->phase, cinc = c->inc;
+    int matt = m->att8, catt = c->att8;
+    int mwf = m->wf, cwf = c->wf;
+    int fb_shift = m->fb ? 9 - m->fb : 0;
+    int out0 = m->out[0], out1 = m->out[1];
+    int i;
+
+    for(i = 0; i < length; i += 1)
+    {
+        int fb = fb_shift ? (out0 + out1) >> fb_shift : 0;
+        int mo = op_out((mphase >> 22) + fb, matt, mwf);
+        out1 = out0;
+        out0 = mo;
+        buffer[i] += op_out((cphase >> 22) + mo, catt, cwf) * gain;
+        mphase += minc;
+        cphase += cinc;
+    }
+
+    m->phase = mphase;
+    c->phase = cphase;
+    m->out[0] = out0;
+    m->out[1] = out1;
+}
+
+/* Snare, hi-hat, tom and cymbal; the bass drum is an ordinary channel */
+static void render_rhythm(OPLL *opll, int *buffer, int length)
+{
+    OPLL_SLOT *hh = &opll->slot[14], *sd = &opll->slot[15];
+    OPLL_SLOT *tom = &opll->slot[16], *tcy = &opll->slot[17];
+    uint32_t noise = opll->noise;
+    int i;
+
+    for(i = 0; i < length; i += 1)
+    {
+        unsigned int p7 = hh->phase >> 22, p8 = tcy->phase >> 22;
+        unsigned int bit = (((p7 >> 2) ^ (p7 >> 7)) | ((p8 >> 3) ^ (p8 >> 5)) | (p7 >> 3)) & 1;
+        unsigned int n = noise & 1;
+        int out = 0;
+
+        if(hh->state != EG_FINISH)
+            out += op_out((bit << 9) | (n ? 0xD0 : 0x34), hh->att8, 0);
+        if(sd->state != EG_FINISH)
+            out += op_out((((p7 >> 8) & 1) << 9) | ((((p7 >> 8) & 1) ^ n) << 8), sd->att8, 0);
+        if(tom->state != EG_FINISH)
+            out += op_out(tom->phase >> 22, tom->att8, 0);
+        if(tcy->state != EG_FINISH)
+            out += op_out((bit << 9) | 0x100, tcy->att8, 0);
+        buffer[i] += out * 2;
+
+        noise = (noise >> 1) | ((((noise >> 14) ^ noise) & 1) << 22);
+        hh->phase += hh->inc;
+        sd->phase += sd->inc;
+        tom->phase += tom->inc;
+        tcy->phase += tcy->inc;
+    }
+
+    opll->noise = noise;
+}
+
+void OPLL_calc_block(OPLL *opll, int *buffer, int length)
+{
+    while(length > 0)
+    {
+        int n = (opll->eg_count < length) ? opll->eg_count : length;
+        int melodic = opll->rhythm ? 6 : opll->channels;
+        int ch;
+
+        for(ch = 0; ch < melodic; ch += 1)
+        {
+            OPLL_SLOT *c = &opll->slot[ch * 2 + 1];
+
+            /* keyed off and faded out: nothing to hear */
+            if(c->state == EG_FINISH) continue;
+            render_channel(c - 1, c, buffer, n, 1);
+        }
+
+        if(opll->rhythm)
+        {
+            if(opll->slot[13].state != EG_FINISH)
+                render_channel(&opll->slot[12], &opll->slot[13], buffer, n, 2);
+            if(opll->slot[14].state != EG_FINISH || opll->slot[15].state != EG_FINISH ||
+               opll->slot[16].state != EG_FINISH || opll->slot[17].state != EG_FINISH)
+                render_rhythm(opll, buffer, n);
+        }
+
+        buffer += n;
+        length -= n;
+        opll->eg_count -= n;
+        if(!opll->eg_count)
+        {
+            eg_tick(opll, OPLL_EG_BLOCK);
+            opll->eg_count = OPLL_EG_BLOCK;
+        }
+    }
+}
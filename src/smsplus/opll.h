@@ -0,0 +1,37 @@
+
+#ifndef _OPLL_H_
+#define _OPLL_H_
+
+/*
+    Table driven, integer only OPLL (YM2413 / VRC7) FM synthesis.
+
+    Shared by smsplus (the Mark III / Japanese Master System FM unit) and
+    nofrendo (Konami VRC7).  Output is rendered straight at the host sample
+    rate: the operators run off a log-sin / exp table pair, envelopes and
+    LFOs step once every OPLL_EG_BLOCK samples and channels whose carrier
+    has died away after key off are skipped.
+*/
+
+#define OPLL_2413_TONE      (0)     /* YM2413: 9 channels, rhythm section */
+#define OPLL_VRC7_TONE      (1)     /* VRC7: 6 channels, no rhythm */
+
+#define OPLL_EG_BLOCK       (16)    /* samples between envelope updates */
+
+/* what a frame of every channel playing may cost: 1/20 of a 60 Hz frame,
+   200000 cycles on a 240 MHz ESP32.  test/opll_test measures it on the host,
+   on the ESP32 it shows up in the audio share of the perf overlay */
+#define OPLL_FRAME_BUDGET_US (833)
+
+typedef struct OPLL_s OPLL;
+
+void OPLL_init(unsigned int clk, unsigned int rate);
+OPLL *OPLL_new(void);
+void OPLL_delete(OPLL *opll);
+void OPLL_reset(OPLL *opll);
+void OPLL_reset_patch(OPLL *opll, int type);
+void OPLL_writeReg(OPLL *opll, unsigned int reg, unsigned int data);
+
+/* adds 'length' samples of output to buffer */
+void OPLL_calc_block(OPLL *opll, int *buffer, int length);
+
+#endif /* _OPLL_H_ */
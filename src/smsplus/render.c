@@ -1,8 +1,16 @@
 
 #include "shared.h"
 
-/* Background drawing function */
+/* Background and sprite drawing functions */
 void (*render_bg)(int line);
+void (*render_spr)(int line);
+
+/* VRAM address lines forced low by the glitch renderers, 0 when clean */
+int render_glitch_mask = 0;
+
+/* Each renderer is written once with a mask argument and instanced twice,
+   so the clean versions fold the mask away and carry no glitch code */
+#define GLITCH_INLINE static __inline__ __attribute__((always_inline))
 
 /* Pointer to output buffer */
 uint8 *linebuf;
@@ -42,9 +50,13 @@ int vp_hend;
 void render_bg_sms(int line);
 void render_bg_gg(int line);
 void render_obj(int line);
+void render_bg_sms_glitch(int line);
+void render_bg_gg_glitch(int line);
+void render_obj_glitch(int line);
 void palette_sync(int index);
 void render_reset(void);
 void render_init(void);
+static void render_select(void);
 
 void vramMarkTileDirty(int index) {
 	int i=index;
@@ -59,11 +71,14 @@ void vramMarkTileDirty(int index) {
 	}
 }
 
-uint8 *getCache(int tile, int attr) {
+GLITCH_INLINE uint8 *get_cache(int tile, int attr, int mask) {
     int n, i, x, y, c;
     int b0, b1, b2, b3;
     int i0, i1, i2, i3;
 	int p;
+	//Glitched tiles read all their bytes from the tile with the masked lines low, cache under that tile
+	//so dirty marking on VRAM writes still finds them. Cache is flushed whenever the mask changes.
+	if (mask) tile &= ~(mask >> 5);
 	//See if we have this in cache.
 	if (cachePtr[tile+(attr<<9)]!=-1) return &cacheStore[cachePtr[tile+(attr<<9)]];
 
@@ -93,10 +108,10 @@ uint8 *getCache(int tile, int attr) {
 //	printf("Generating cache loc %d for tile %d attr %d\n", i, tile, attr);
 	//Calculate tile
 	for(y = 0; y < 8; y += 1) {
-		b0 = vdp.vram[(tile << 5) | (y << 2) | (0)];
-		b1 = vdp.vram[(tile << 5) | (y << 2) | (1)];
-		b2 = vdp.vram[(tile << 5) | (y << 2) | (2)];
-		b3 = vdp.vram[(tile << 5) | (y << 2) | (3)];
+		b0 = vdp.vram[((tile << 5) | (y << 2) | (0)) & ~mask];
+		b1 = vdp.vram[((tile << 5) | (y << 2) | (1)) & ~mask];
+		b2 = vdp.vram[((tile << 5) | (y << 2) | (2)) & ~mask];
+		b3 = vdp.vram[((tile << 5) | (y << 2) | (3)) & ~mask];
 		for(x = 0; x < 8; x += 1) {
 			i0 = (b0 >> (x ^ 7)) & 1;
 			i1 = (b1 >> (x ^ 7)) & 1;
@@ -114,6 +129,27 @@ uint8 *getCache(int tile, int attr) {
 	return &cacheStore[i<<6];
 }
 
+uint8 *getCache(int tile, int attr) {
+	return get_cache(tile, attr, 0);
+}
+
+/* Name table word, fetched a byte at a time through the masked lines when glitching */
+GLITCH_INLINE uint16 nt_read(uint16 *nt, int index, int mask)
+{
+    if (mask)
+    {
+        int a = (uint8 *)&nt[index] - vdp.vram;
+        uint8 lo = vdp.vram[a & ~mask];
+        uint8 hi = vdp.vram[(a + 1) & ~mask];
+#ifdef LSB_FIRST
+        return lo | (hi << 8);
+#else
+        return hi | (lo << 8);
+#endif
+    }
+    return nt[index];
+}
+
 
 /* Macros to access memory 32-bits at a time (from MAME's drawgfx.c) */
 
@@ -252,7 +288,38 @@ void render_reset(void)
     }
 
     /* Pick render routine */
-    render_bg = IS_GG ? render_bg_gg : render_bg_sms;
+    render_select();
+}
+
+/* Pick clean or glitched render routines */
+static void render_select(void)
+{
+    if (render_glitch_mask)
+    {
+        render_bg = IS_GG ? render_bg_gg_glitch : render_bg_sms_glitch;
+        render_spr = render_obj_glitch;
+    }
+    else
+    {
+        render_bg = IS_GG ? render_bg_gg : render_bg_sms;
+        render_spr = render_obj;
+    }
+}
+
+/* Force VRAM address lines low on every pattern, name table and sprite fetch */
+void render_glitch(int mask)
+{
+    int i;
+
+    mask &= 0x3FFF;
+    if (mask == render_glitch_mask) return;
+    render_glitch_mask = mask;
+
+    /* Cached tiles were decoded with the old mask */
+	for (i=0; i<512*4; i++) cachePtr[i]=-1;
+	for (i=0; i<CACHEDTILES; i++) cacheStoreUsed[i]=0;
+
+    render_select();
 }
 
 
@@ -282,7 +349,7 @@ void render_line(int line)
         render_bg(line);
 
         /* Draw sprites */
-        render_obj(line);
+        render_spr(line);
 
         /* Blank leftmost column of display */
         if(vdp.reg[0] & 0x20)
@@ -295,7 +362,7 @@ void render_line(int line)
 
 
 /* Draw the Master System background */
-void render_bg_sms(int line)
+GLITCH_INLINE void render_bg_sms_m(int line, int mask)
 {
     int locked = 0;
     int v_line = (line + vdp.reg[9]) % 224;
@@ -316,7 +383,7 @@ void render_bg_sms(int line)
     {
         int x, c, a;
 
-        attr = nt[(column + nt_scroll) & 0x1F];
+        attr = nt_read(nt, (column + nt_scroll) & 0x1F, mask);
 
 #ifndef LSB_FIRST
         attr = (((attr & 0xFF) << 8) | ((attr & 0xFF00) >> 8));
@@ -325,7 +392,7 @@ void render_bg_sms(int line)
 
         for(x = shift; x < 8; x += 1)
         {
-			ctp=getCache((attr&0x1ff), (attr>>9)&3);
+			ctp=get_cache((attr&0x1ff), (attr>>9)&3, mask);
             c = ctp[(v_row) | (x)];
             linebuf[(0 - shift) + (x)  ] = ((c) | (a));
         }
@@ -345,7 +412,7 @@ void render_bg_sms(int line)
         }
 
         /* Get name table attribute word */
-        attr = nt[(column + nt_scroll) & 0x1F];
+        attr = nt_read(nt, (column + nt_scroll) & 0x1F, mask);
 
 #ifndef LSB_FIRST
         attr = (((attr & 0xFF) << 8) | ((attr & 0xFF00) >> 8));
@@ -354,7 +421,7 @@ void render_bg_sms(int line)
         atex_mask = atex[(attr >> 11) & 3];
 
         /* Point to a line of pattern data in cache */
-		ctp=getCache((attr&0x1ff), (attr>>9)&3);
+		ctp=get_cache((attr&0x1ff), (attr>>9)&3, mask);
         cache_ptr = (uint32 *)&ctp[(v_row)];
         
         /* Copy the left half, adding the attribute bits in */
@@ -371,7 +438,7 @@ void render_bg_sms(int line)
 
         char *p = &linebuf[(0 - shift)+(column << 3)];
 
-        attr = nt[(column + nt_scroll) & 0x1F];
+        attr = nt_read(nt, (column + nt_scroll) & 0x1F, mask);
 
 #ifndef LSB_FIRST
         attr = (((attr & 0xFF) << 8) | ((attr & 0xFF00) >> 8));
@@ -380,7 +447,7 @@ void render_bg_sms(int line)
 
         for(x = 0; x < shift; x += 1)
         {
-			ctp=getCache((attr&0x1ff), (attr>>9)&3);
+			ctp=get_cache((attr&0x1ff), (attr>>9)&3, mask);
             c = ctp[(v_row) | (x)];
             p[x] = ((c) | (a));
         }
@@ -388,8 +455,19 @@ void render_bg_sms(int line)
 }
 
 
+void render_bg_sms(int line)
+{
+    render_bg_sms_m(line, 0);
+}
+
+void render_bg_sms_glitch(int line)
+{
+    render_bg_sms_m(line, render_glitch_mask);
+}
+
+
 /* Draw the Game Gear background */
-void render_bg_gg(int line)
+GLITCH_INLINE void render_bg_gg_m(int line, int mask)
 {
     int v_line = (line + vdp.reg[9]) % 224;
     int v_row  = (v_line & 7) << 3;
@@ -407,7 +485,7 @@ void render_bg_gg(int line)
     for(column = vp_hstart; column <= vp_hend; column += 1)
     {
         /* Get name table attribute word */
-        attr = nt[(column + nt_scroll) & 0x1F];
+        attr = nt_read(nt, (column + nt_scroll) & 0x1F, mask);
 
 #ifndef LSB_FIRST
         attr = (((attr & 0xFF) << 8) | ((attr & 0xFF00) >> 8));
@@ -416,7 +494,7 @@ void render_bg_gg(int line)
         atex_mask = atex[(attr >> 11) & 3];
 
         /* Point to a line of pattern data in cache */
-		ctp=getCache((attr&0x1ff), (attr>>9)&3);
+		ctp=get_cache((attr&0x1ff), (attr>>9)&3, mask);
         cache_ptr = (uint32 *)&ctp[(v_row)];
 
         /* Copy the left half, adding the attribute bits in */
@@ -429,7 +507,7 @@ void render_bg_gg(int line)
 
 
 /* Draw sprites */
-void render_obj(int line)
+GLITCH_INLINE void render_obj_m(int line, int mask)
 {
     int i;
 	uint8_t *ctp;
@@ -441,8 +519,8 @@ void render_obj(int line)
     int width = 8;
     int height = (vdp.reg[1] & 0x02) ? 16 : 8;
 
-    /* Pointer to sprite attribute table */
-    uint8 *st = (uint8 *)&vdp.vram[vdp.satb];
+    /* Sprite attribute table */
+#define SAT(o) (mask ? vdp.vram[(vdp.satb + (o)) & ~mask] : vdp.vram[vdp.satb + (o)])
 
     /* Adjust dimensions for double size sprites */
     if(vdp.reg[1] & 0x01)
@@ -455,7 +533,7 @@ void render_obj(int line)
     for(i = 0; i < 64; i += 1)
     {
         /* Sprite Y position */
-        int yp = st[i];
+        int yp = SAT(i);
 
         /* End of sprite list marker? */
         if(yp == 208) return;
@@ -476,10 +554,10 @@ void render_obj(int line)
             int end = width;
 
             /* Sprite X position */
-            int xp = st[0x80 + (i << 1)];
+            int xp = SAT(0x80 + (i << 1));
 
             /* Pattern name */
-            int n = st[0x81 + (i << 1)];
+            int n = SAT(0x81 + (i << 1));
 
             /* Bump sprite count */
             count += 1;
@@ -515,7 +593,7 @@ void render_obj(int line)
             if(vdp.reg[1] & 0x01)
             {
                 int x;
-				ctp=getCache((n&0x1ff)+((line - yp) >> 3), (n>>9)&3);
+				ctp=get_cache((n&0x1ff)+((line - yp) >> 3), (n>>9)&3, mask);
                 uint8 *cache_ptr = (uint8 *)&ctp[(((line - yp) >> 1) << 3)];
 
                 /* Draw sprite line */
@@ -541,7 +619,7 @@ void render_obj(int line)
             else /* Regular size sprite (8x8 / 8x16) */
             {
                 int x;
-				ctp=getCache((n&0x1ff)+((line - yp) >> 3), (n>>9)&3);
+				ctp=get_cache((n&0x1ff)+((line - yp) >> 3), (n>>9)&3, mask);
                 uint8 *cache_ptr = (uint8 *)&ctp[((line - yp) << 3)&0x38];
 
                 /* Draw sprite line */
@@ -568,6 +646,28 @@ void render_obj(int line)
     }
 }
 
+#undef SAT
+
+void render_bg_gg(int line)
+{
+    render_bg_gg_m(line, 0);
+}
+
+void render_bg_gg_glitch(int line)
+{
+    render_bg_gg_m(line, render_glitch_mask);
+}
+
+void render_obj(int line)
+{
+    render_obj_m(line, 0);
+}
+
+void render_obj_glitch(int line)
+{
+    render_obj_m(line, render_glitch_mask);
+}
+
 
 uint8_t cramd[0x20] = {0};  // in 3:3:2 r:g:b
 void palette_sync(int index)
@@ -16,6 +16,7 @@ void render_bg_gg(int line);
 void render_bg_sms(int line);
 void render_obj(int line);
 void render_line(int line);
+void render_glitch(int mask);
 void update_cache(void);
 void palette_sync(int index);
 void remap_8_to_16(int line);
@@ -1,5 +1,6 @@
 
 #include "shared.h"
+#include "../perf_counters.h"
 void ym2413_write(int chip, int offset, int data);
 
 /* SMS context */
@@ -38,7 +39,11 @@ void sms_frame(int skip_render)
         vdp_run();
 
         /* Draw the current frame */
-        if(!skip_render) render_line(vdp.line);
+        if(!skip_render) {
+            PERF_BEGIN(PERF_RENDER);
+            render_line(vdp.line);
+            PERF_END();
+        }
 
         /* Run the Z80 for a line */
         z80_execute(227);
@@ -74,6 +79,30 @@ void sms_frame(int skip_render)
         }
 */
         SN76496Update(0, snd.buffer, snd.bufsize, sms.psg_mask);
+
+        /* Mix in the YM2413 a block at a time */
+        if(sms.use_fm)
+        {
+            int fm[64];
+            int count, i, n;
+
+            PERF_BEGIN(PERF_AUDIO);
+            for(count = 0; count < snd.bufsize; count += n)
+            {
+                n = snd.bufsize - count;
+                if(n > 64) n = 64;
+                memset(fm, 0, n * sizeof(int));
+                OPLL_calc_block(opll, fm, n);
+                for(i = 0; i < n; i += 1)
+                {
+                    int left  = snd.buffer[0][count + i] + fm[i];
+                    int right = snd.buffer[1][count + i] + fm[i];
+                    snd.buffer[0][count + i] = (left  > 32767) ? 32767 : (left  < -32768) ? -32768 : left;
+                    snd.buffer[1][count + i] = (right > 32767) ? 32767 : (right < -32768) ? -32768 : right;
+                }
+            }
+            PERF_END();
+        }
     }
 }
 
@@ -17,16 +17,18 @@
 */
 
 #include "shared.h"
+#include "../title_arena.h"
 
 
 t_bitmap bitmap;
 t_cart cart;                
 t_snd snd;
 t_input input;
-//OPLL *opll;
+OPLL *opll;
 
 struct
 {
+    uint8 latch;
     char reg[64];
 }ym2413;
 
@@ -67,8 +69,8 @@ void audio_init(int rate)
     snd.bufsize = rate == 15720 ? 262 : 312;   // EWWWW
 
     /* Sound output */
-    snd.buffer[0] = (signed short int *)malloc(snd.bufsize * 2);
-    snd.buffer[1] = (signed short int *)malloc(snd.bufsize * 2);
+    snd.buffer[0] = (signed short int *)arena_alloc(snd.bufsize * 2, ARENA_INTERNAL);
+    snd.buffer[1] = (signed short int *)arena_alloc(snd.bufsize * 2, ARENA_INTERNAL);
     if(!snd.buffer[0] || !snd.buffer[1]) return;
     memset(snd.buffer[0], 0, snd.bufsize * 2);
     memset(snd.buffer[1], 0, snd.bufsize * 2);
@@ -89,10 +91,11 @@ void audio_init(int rate)
     SN76496_init(0, MASTER_CLOCK, 255, rate);
 
     /* Set up YM2413 emulation */
-//    OPLL_init(3579545, rate) ;
-//    opll = OPLL_new() ;
-//    OPLL_reset(opll) ;
-//    OPLL_reset_patch(opll,0) ;            /* if use default voice data. */ 
+    OPLL_init(3579545, rate);
+    if(!opll) opll = OPLL_new();
+    if(!opll) return;
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, OPLL_2413_TONE);
 
     /* Inform other functions that we can use sound */
     snd.enabled = 1;
@@ -103,8 +106,8 @@ void system_shutdown(void)
 {
     if(snd.enabled)
     {
-//        OPLL_delete(opll);
-//        OPLL_close();
+        OPLL_delete(opll);
+        opll = NULL;
     }
 }
 
@@ -118,8 +121,9 @@ void system_reset(void)
    // system_load_sram();
     if(snd.enabled)
     {
-//        OPLL_reset(opll) ;
-//        OPLL_reset_patch(opll,0) ;            /* if use default voice data. */ 
+        OPLL_reset(opll);
+        OPLL_reset_patch(opll, OPLL_2413_TONE);
+        memset(ym2413.reg, 0, sizeof(ym2413.reg));
     }
 }
 
@@ -206,10 +210,9 @@ void system_load_state(void *fd)
     /* Restore sound state */
     if(snd.enabled)
     {
-#if 0
         /* Clear YM2413 context */
-        OPLL_reset(opll) ;
-        OPLL_reset_patch(opll,0) ;            /* if use default voice data. */ 
+        OPLL_reset(opll);
+        OPLL_reset_patch(opll, OPLL_2413_TONE);
 
         /* Restore rhythm enable first */
         ym2413_write(0, 0, 0x0E);
@@ -242,17 +245,18 @@ void system_load_state(void *fd)
             ym2413_write(0, 0, i);
             ym2413_write(0, 1, reg[i]);
         }
-#endif
     }
 }
 
 void ym2413_write(int chip, int offset, int data)
 {
-//    static uint8 latch = 0;
-//    if(offset & 1)
-//        OPLL_writeReg(opll, latch, data);
-//    else
-//        latch = data;
+    if(offset & 1)
+    {
+        ym2413.reg[ym2413.latch & 0x3F] = data;
+        OPLL_writeReg(opll, ym2413.latch, data);
+    }
+    else
+        ym2413.latch = data;
 }
 
 
@@ -2,8 +2,10 @@
 #ifndef _SYSTEM_H_
 #define _SYSTEM_H_
 
-//void ym2413_write(int chip, int offset, int data);
-//extern OPLL *opll;
+#include "opll.h"
+
+void ym2413_write(int chip, int offset, int data);
+extern OPLL *opll;
 
 #define PALETTE_SIZE        (0x20)
 
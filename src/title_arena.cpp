@@ -0,0 +1,118 @@
+#include "title_arena.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+static const uint32_t _arena_caps[ARENA_COUNT] = { MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_32BIT };
+static inline void* heap_alloc(int size, int cls) { return heap_caps_malloc(size,_arena_caps[cls]); }
+static inline void heap_info(uint32_t* free_bytes, uint32_t* largest)
+{
+    *free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    *largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+#else
+#include <malloc.h>
+static inline void* heap_alloc(int size, int cls) { return malloc(size); }
+static inline void heap_info(uint32_t* free_bytes, uint32_t* largest)
+{
+    struct mallinfo2 mi = mallinfo2();
+    *free_bytes = mi.fordblks;      // free bytes still held by the allocator
+    *largest = mi.keepcost;         // contiguous top of heap, good enough on the host
+}
+#endif
+
+static const uint32_t _arena_align[ARENA_COUNT] = { 8, 4 };
+
+typedef struct {
+    uint8_t* base;
+    arena_region_stats s;
+} arena_region;
+
+static arena_region _arena[ARENA_COUNT];
+static bool _arena_open = false;
+
+void arena_init(int internal_size, int mem32_size)
+{
+    int sizes[ARENA_COUNT] = { internal_size, mem32_size };
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        arena_region* r = _arena + i;
+        free(r->base);
+        memset(r,0,sizeof(arena_region));
+        if (sizes[i] <= 0)
+            continue;
+        r->base = (uint8_t*)heap_alloc(sizes[i],i);
+        if (!r->base) {
+            printf("arena_init can't reserve %d bytes for region %d\n",sizes[i],i);
+            continue;
+        }
+        r->s.size = sizes[i];
+    }
+    _arena_open = false;
+}
+
+void arena_begin()
+{
+    for (int i = 0; i < ARENA_COUNT; i++)
+        _arena[i].s.used = 0;
+    _arena_open = true;
+}
+
+void arena_end()
+{
+    _arena_open = false;
+}
+
+void* arena_alloc(int size, int cls)
+{
+    if (size <= 0)
+        return NULL;
+    arena_region* r = _arena + cls;
+    if (_arena_open && r->base) {
+        uint32_t a = _arena_align[cls] - 1;
+        uint32_t n = (size + a) & ~a;
+        if (r->s.used + n <= r->s.size) {
+            void* p = r->base + r->s.used;
+            r->s.used += n;
+            if (r->s.used > r->s.peak)
+                r->s.peak = r->s.used;
+            return p;
+        }
+        r->s.spilled += n;
+        printf("arena region %d full, %d bytes from the heap\n",cls,size);
+    }
+    return heap_alloc(size,cls);
+}
+
+void arena_free(void* p)
+{
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        arena_region* r = _arena + i;
+        if ((uint8_t*)p >= r->base && (uint8_t*)p < r->base + r->s.size)
+            return; // released with the title
+    }
+    free(p);
+}
+
+void arena_stats(int cls, arena_region_stats* s)
+{
+    *s = _arena[cls].s;
+}
+
+void arena_trace()
+{
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+    uint32_t free_bytes, largest;
+    heap_info(&free_bytes,&largest);
+    const arena_region_stats* i = &_arena[ARENA_INTERNAL].s;
+    const arena_region_stats* m = &_arena[ARENA_MEM32].s;
+    TRACE_DEBUG(TRACE_ARENA_INTERNAL,i->used,i->peak);
+    TRACE_DEBUG(TRACE_ARENA_MEM32,m->used,m->peak);
+    TRACE_DEBUG(TRACE_ARENA_SPILLED,i->spilled + m->spilled,
+        free_bytes ? 100 - (uint32_t)((uint64_t)largest*100/free_bytes) : 0);
+    TRACE_DEBUG(TRACE_HEAP,free_bytes,largest);
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef TITLE_ARENA_H
+#define TITLE_ARENA_H
+
+#include <stdint.h>
+
+// Per-title arena. Everything an emulator core allocates while loading a cart or
+// disk comes out of two fixed regions reserved once at boot, and all of it is
+// dropped in one go when the next title loads - no free lists, no heap churn.
+// Outside of arena_begin/arena_end, or once a region is full, allocations fall
+// back to the heap. Only meant to be used from the emulator task.
+
+enum {
+    ARENA_INTERNAL,     // byte addressable internal ram, 8 byte aligned
+    ARENA_MEM32,        // 32 bit access only (may be IRAM), 4 byte aligned, word access only
+    ARENA_COUNT
+};
+
+typedef struct {
+    uint32_t size;      // capacity reserved at boot
+    uint32_t used;      // bytes handed out to the current title
+    uint32_t peak;      // high water mark across all titles
+    uint32_t spilled;   // bytes that went to the heap because the region was full
+} arena_region_stats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void arena_init(int internal_size, int mem32_size);    // once at boot, sizes are fixed after this
+void arena_begin(void);                 // release the previous title, take allocations until arena_end
+void arena_end(void);                   // title is loaded, later allocations go to the heap
+void* arena_alloc(int size, int cls);   // never freed individually
+void arena_free(void* p);               // no-op for arena memory, free() for heap fallbacks
+void arena_stats(int cls, arena_region_stats* s);
+void arena_trace(void);                 // used/peak per region and heap fragmentation, at TRACE_DEBUG
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TITLE_ARENA_H
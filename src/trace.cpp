@@ -0,0 +1,129 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include "Arduino.h"
+#define TRACE_CORES 2
+static inline uint32_t trace_time() { return xthal_get_ccount(); }
+static inline int trace_core() { return xPortGetCoreID(); }
+#else
+#include <time.h>
+#define TRACE_CORES 1
+static inline uint32_t trace_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec*1000000000ULL + ts.tv_nsec);
+}
+static inline int trace_core() { return 0; }
+#endif
+
+// printf formats for the two args of each event, which are always uintptr_t
+#define U   "%" PRIuPTR
+#define D   "%" PRIdPTR
+#define X   "%" PRIXPTR
+#define X2  "%02" PRIXPTR
+#define X4  "%04" PRIXPTR
+#define X8  "%08" PRIXPTR
+static const char* _trace_formats[TRACE_EVENT_COUNT] = {
+    "none",
+    "Analog glitch update called " U " times",
+    "ADC: " U " -> Glitch Slot/mask: " X8,
+    "key:" X2 " " X4,
+    "heap " U " free, " U " biggest",
+    "MALLOC32 allocating " U,
+    "MALLOC32 allocation of " U " at " X8,
+    "CrapFS::mmap mapping offset:" X8 " len:" U,
+    "CrapFS::mmap offset:" X8 " mapped to " X8,
+    "CrapFS::copy writing " U " of " U,
+    "CrapFS::created offset:" X8 " len:" U,
+    "VRAM read at $" X4 ", scanline " D,
+    "VRAM write " X4 " on active scan-line " D,
+    "ANTIC lines skipped:" U " drawn:" U,
+    "arena int used:" U " peak:" U,
+    "arena mem32 used:" U " peak:" U,
+    "arena spilled:" U " heap frag:" U "%%",
+};
+#undef U
+#undef D
+#undef X
+#undef X2
+#undef X4
+#undef X8
+
+// seq is a per slot seqlock: 0 while a writer is filling it in, then the
+// record's sequence + 1 once it's complete.
+typedef struct {
+    std::atomic<uint32_t> seq;
+    uint32_t time;              // cycle count on the recording core
+    uint16_t id;
+    uintptr_t a;
+    uintptr_t b;
+} trace_record;
+
+// one ring per core. writers on a core claim a slot with fetch_add so tasks
+// preempting each other can't collide; the reader follows behind on core 1.
+// when full the oldest records are overwritten and counted as dropped.
+struct TraceRing {
+    trace_record records[TRACE_RING_SIZE];
+    std::atomic<uint32_t> head;     // next sequence to write
+    uint32_t tail;                  // next sequence to read
+    uint32_t dropped;
+};
+static TraceRing _rings[TRACE_CORES];
+
+extern "C"
+void trace_event(uint16_t id, uintptr_t a, uintptr_t b)
+{
+    TraceRing& r = _rings[trace_core()];
+    uint32_t seq = r.head.fetch_add(1,std::memory_order_relaxed);
+    trace_record& t = r.records[seq & (TRACE_RING_SIZE-1)];
+    t.seq.store(0,std::memory_order_relaxed);      // a reader copying the old record will see this
+    std::atomic_thread_fence(std::memory_order_release);
+    t.time = trace_time();
+    t.id = id;
+    t.a = a;
+    t.b = b;
+    t.seq.store(seq + 1,std::memory_order_release);
+}
+
+extern "C"
+int trace_drain()
+{
+    int n = 0;
+    for (int c = 0; c < TRACE_CORES; c++) {
+        TraceRing& r = _rings[c];
+        uint32_t head = r.head.load(std::memory_order_acquire);
+        if (head - r.tail > TRACE_RING_SIZE) {
+            r.dropped += head - r.tail - TRACE_RING_SIZE;   // lapped
+            r.tail = head - TRACE_RING_SIZE;
+        }
+        while (r.tail != head) {
+            trace_record& rec = r.records[r.tail & (TRACE_RING_SIZE-1)];
+            uint32_t seq = rec.seq.load(std::memory_order_acquire);
+            if (seq != r.tail + 1)
+                break;                  // still being written, or already overwritten
+            uint32_t time = rec.time;
+            uint16_t id = rec.id;
+            uintptr_t a = rec.a;
+            uintptr_t b = rec.b;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (rec.seq.load(std::memory_order_relaxed) != seq)
+                break;                  // overwritten while we copied it
+            char buf[128];
+            const char* fmt = id < TRACE_EVENT_COUNT ? _trace_formats[id] : "event %" PRIuPTR " %" PRIuPTR;
+            snprintf(buf,sizeof(buf),fmt,a,b);
+            printf("[%d %10u] %s\n",c,(unsigned)time,buf);
+            r.tail++;
+            n++;
+        }
+        if (r.dropped) {
+            printf("[%d] trace dropped %u records\n",c,r.dropped);
+            r.dropped = 0;
+        }
+    }
+    return n;
+}
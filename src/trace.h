@@ -0,0 +1,75 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Binary trace log. Records are a timestamp, an event id and two args written to a
+// per-core lock-free ring; formatting is deferred to trace_drain() on core 1.
+// Use these in place of printf anywhere near the emulator core or an interrupt.
+// Args are plain integers: by the time a record is drained whatever a pointer
+// pointed at may be gone, so formats never use %s and pointers only print as hex.
+
+// Compile time levels, anything above TRACE_LEVEL compiles to nothing
+#define TRACE_LEVEL_OFF   0
+#define TRACE_LEVEL_WARN  1
+#define TRACE_LEVEL_INFO  2
+#define TRACE_LEVEL_DEBUG 3
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+// Event ids, format strings live in trace.cpp
+enum {
+    TRACE_NONE,
+    TRACE_GLITCH_UPDATE,        // calls
+    TRACE_GLITCH_SLOT,          // adc, slot << 16 | mask
+    TRACE_KEY,                  // keycode, pressed << 8 | mods
+    TRACE_HEAP,                 // free, biggest
+    TRACE_MALLOC32,             // size
+    TRACE_MALLOC32_PTR,         // size, ptr
+    TRACE_CRAPFS_MMAP,          // offset, len
+    TRACE_CRAPFS_MAPPED,        // offset, ptr
+    TRACE_CRAPFS_COPY,          // written, len
+    TRACE_CRAPFS_CREATED,       // offset, len
+    TRACE_PPU_VRAM_READ,        // vaddr, scanline
+    TRACE_PPU_VRAM_WRITE,       // vaddr, scanline
+    TRACE_ANTIC_LINES,          // skipped, drawn
+    TRACE_ARENA_INTERNAL,       // used, peak
+    TRACE_ARENA_MEM32,          // used, peak
+    TRACE_ARENA_SPILLED,        // bytes, heap fragmentation %
+    TRACE_EVENT_COUNT
+};
+
+#define TRACE_RING_SIZE 256     // records per core, power of 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void trace_event(uint16_t id, uintptr_t a, uintptr_t b);
+int trace_drain(void);          // format pending records, returns # drained
+
+#ifdef __cplusplus
+}
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_WARN
+#define TRACE_WARN(_id,_a,_b) trace_event(_id,(uintptr_t)(_a),(uintptr_t)(_b))
+#else
+#define TRACE_WARN(_id,_a,_b) do {} while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(_id,_a,_b) trace_event(_id,(uintptr_t)(_a),(uintptr_t)(_b))
+#else
+#define TRACE_INFO(_id,_a,_b) do {} while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(_id,_a,_b) trace_event(_id,(uintptr_t)(_a),(uintptr_t)(_b))
+#else
+#define TRACE_DEBUG(_id,_a,_b) do {} while (0)
+#endif
+
+#endif // TRACE_H
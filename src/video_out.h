@@ -38,6 +38,7 @@ int _pal_ = 0;
 #include "rom/gpio.h"
 #include "rom/lldesc.h"
 #include "driver/periph_ctrl.h"
+#include "trace.h"
 #include "driver/dac.h"
 #include "driver/gpio.h"
 #include "driver/i2s.h"
@@ -222,15 +223,15 @@ static void freqs()
 extern "C"
 void* MALLOC32(int x, const char* label)
 {
-    printf("MALLOC32 %d free, %d biggest, allocating %s:%d\n",
-      heap_caps_get_free_size(MALLOC_CAP_32BIT),heap_caps_get_largest_free_block(MALLOC_CAP_32BIT),label,x);
+    TRACE_INFO(TRACE_HEAP,heap_caps_get_free_size(MALLOC_CAP_32BIT),heap_caps_get_largest_free_block(MALLOC_CAP_32BIT));
+    TRACE_INFO(TRACE_MALLOC32,x,0);
     void * r = heap_caps_malloc(x,MALLOC_CAP_32BIT);
     if (!r) {
         printf("MALLOC32 FAILED allocation of %s:%d!!!!####################\n",label,x);
         esp_restart();
     }
     else
-        printf("MALLOC32 allocation of %s:%d %08X\n",label,x,r);
+        TRACE_INFO(TRACE_MALLOC32_PTR,x,r);
     return r;
 }
 
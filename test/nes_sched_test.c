@@ -0,0 +1,330 @@
+/*
+** nes_sched_test.c
+**
+** CPU cycle event scheduler and the mapper IRQ counters that run off it,
+** against a stand-in CPU that only counts cycles.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "noftypes.h"
+#include "nes.h"
+#include "nes6502.h"
+#include "nes_mmc.h"
+#include "nes_sched.h"
+#include "vrcirq.h"
+
+static int failures;
+
+#define  CHECK(cond) \
+   do { if (!(cond)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* stand-in CPU: executes instructions of cpu_step cycles, and can make one
+** write from "inside" an instruction at a given cycle
+*/
+static uint32 cpu_cycles;
+static int cpu_step = 1;
+static bool cpu_released;
+static uint32 poke_at;
+static void (*poke_func)(void);
+
+uint32 nes6502_getcycles(bool reset_flag)
+{
+   UNUSED(reset_flag);
+   return cpu_cycles;
+}
+
+void nes6502_release(void)
+{
+   cpu_released = true;
+}
+
+int nes6502_execute(int total_cycles)
+{
+   int ran = 0;
+
+   cpu_released = false;
+   while (ran < total_cycles && !cpu_released)
+   {
+      cpu_cycles += cpu_step;
+      ran += cpu_step;
+      if (poke_func && (int32) (cpu_cycles - poke_at) >= 0)
+      {
+         void (*func)(void) = poke_func;
+
+         poke_func = NULL;
+         func();
+      }
+   }
+   return ran;
+}
+
+/* rest of the machine the mappers touch */
+static uint32 irq_at[32];
+static int irq_count;
+static bool irq_line;
+
+void nes_irq(void)
+{
+   if (irq_count < 32)
+      irq_at[irq_count] = cpu_cycles;
+   irq_count++;
+   irq_line = true;
+}
+
+void nes_irq_ack(void)
+{
+   irq_line = false;
+}
+
+void mmc_bankrom(int size, uint32 address, int bank)
+{
+   UNUSED(size); UNUSED(address); UNUSED(bank);
+}
+
+void ppu_mirror(int nt1, int nt2, int nt3, int nt4)
+{
+   UNUSED(nt1); UNUSED(nt2); UNUSED(nt3); UNUSED(nt4);
+}
+
+static void start(uint32 cycle, int step)
+{
+   sched_reset();
+   cpu_cycles = cycle;
+   cpu_step = step;
+   poke_func = NULL;
+   irq_count = 0;
+   irq_line = false;
+}
+
+/* events fired, in order */
+static char fired[16];
+static uint32 fired_at[16];
+static int fired_count;
+
+static void fire(char what)
+{
+   if (fired_count < 16)
+   {
+      fired[fired_count] = what;
+      fired_at[fired_count] = cpu_cycles;
+   }
+   fired_count++;
+}
+
+static void ev_nmi(void) { fire('N'); }
+static void ev_fiq(void) { fire('F'); }
+static void ev_mapper(void) { fire('M'); }
+
+static void ev_periodic(void)
+{
+   fire('P');
+   sched_at(SCHED_FIQ, sched_when(SCHED_FIQ) + 100, ev_periodic);
+}
+
+static void test_order(void)
+{
+   start(1000, 1);
+   fired_count = 0;
+   sched_in(SCHED_NMI, 100, ev_nmi);
+   sched_in(SCHED_FIQ, 50, ev_fiq);
+   sched_in(SCHED_MAPPER, 75, ev_mapper);
+   CHECK(sched_left(SCHED_FIQ) == 50);
+   CHECK(sched_run(200) == 200);
+   CHECK(3 == fired_count);
+   CHECK(0 == memcmp(fired, "FMN", 3));
+   CHECK(1050 == fired_at[0] && 1075 == fired_at[1] && 1100 == fired_at[2]);
+   CHECK(0 == sched_left(SCHED_NMI));
+}
+
+static void test_cancel_and_move(void)
+{
+   start(0, 1);
+   fired_count = 0;
+   sched_in(SCHED_NMI, 30, ev_nmi);
+   sched_in(SCHED_FIQ, 10, ev_fiq);
+   sched_in(SCHED_MAPPER, 20, ev_mapper);
+   sched_cancel(SCHED_FIQ);
+   sched_in(SCHED_NMI, 5, ev_nmi);     /* setting a slot again moves it */
+   sched_run(100);
+   CHECK(2 == fired_count);
+   CHECK(0 == memcmp(fired, "NM", 2));
+   CHECK(5 == fired_at[0] && 20 == fired_at[1]);
+}
+
+/* instructions overshoot the deadline, the event fires straight after */
+static void test_overshoot(void)
+{
+   start(0, 7);
+   fired_count = 0;
+   sched_in(SCHED_MAPPER, 10, ev_mapper);
+   sched_run(100);
+   CHECK(1 == fired_count && 14 == fired_at[0]);
+}
+
+/* set by a CPU write while a slice is running: the slice stops early */
+static void poke_mapper(void)
+{
+   sched_in(SCHED_MAPPER, 10, ev_mapper);
+}
+
+static void test_set_from_cpu(void)
+{
+   start(0, 1);
+   fired_count = 0;
+   poke_at = 40;
+   poke_func = poke_mapper;
+   sched_run(1000);
+   CHECK(1 == fired_count && 50 == fired_at[0]);
+}
+
+static void test_periodic_and_wrap(void)
+{
+   start(0xFFFFFF00, 1);
+   fired_count = 0;
+   sched_in(SCHED_FIQ, 100, ev_periodic);
+   sched_run(1000);
+   CHECK(10 == fired_count);
+   CHECK(0xFFFFFF64 == fired_at[0]);
+   CHECK(0x000002E8 == fired_at[9]);
+}
+
+static void mapper_write(mapintf_t *intf, uint32 address, uint8 value)
+{
+   map_memwrite *mw;
+
+   for (mw = intf->mem_write; mw->write_func; mw++)
+   {
+      if (address >= mw->min_range && address <= mw->max_range)
+      {
+         mw->write_func(address, value);
+         return;
+      }
+   }
+}
+
+extern mapintf_t map42_intf, map50_intf, map73_intf;
+
+/* 42 and 50 count M2 cycles from the enabling write */
+static void test_m2_counter(mapintf_t *intf, uint32 reg, uint8 on, int cycles)
+{
+   SnssMapperBlock state;
+
+   start(0, 1);
+   intf->init();
+   mapper_write(intf, reg, on);
+   sched_run(cycles - 1);
+   CHECK(0 == irq_count);
+   sched_run(1);
+   CHECK(1 == irq_count && (uint32) cycles == irq_at[0] && irq_line);
+
+   /* once is all: the counter stops until enabled again */
+   sched_run(cycles * 2);
+   CHECK(1 == irq_count);
+
+   /* disabling acks the line and stops the count */
+   mapper_write(intf, reg, 0);
+   CHECK(false == irq_line);
+   mapper_write(intf, reg, on);
+   sched_run(cycles / 2);
+   mapper_write(intf, reg, 0);
+   sched_run(cycles * 2);
+   CHECK(1 == irq_count);
+
+   /* a snapshot taken a quarter of the way in strikes three quarters later */
+   start(0, 1);
+   intf->init();
+   mapper_write(intf, reg, on);
+   sched_run(cycles / 4);
+   memset(&state, 0, sizeof(state));
+   intf->get_state(&state);
+   start(5000, 1);
+   intf->init();
+   intf->set_state(&state);
+   sched_run(cycles);
+   CHECK(1 == irq_count && 5000 + (uint32) (cycles - cycles / 4) == irq_at[0]);
+}
+
+/* VRC3 counts up from the reload value and strikes on overflow into Q16 */
+static void test_vrc3(void)
+{
+   SnssMapperBlock state;
+
+   start(0, 1);
+   map73_intf.init();
+   mapper_write(&map73_intf, 0x8000, 0x0);
+   mapper_write(&map73_intf, 0x9000, 0x0);
+   mapper_write(&map73_intf, 0xA000, 0xF);
+   mapper_write(&map73_intf, 0xB000, 0xF);
+   mapper_write(&map73_intf, 0xC000, 0x02);
+   sched_run(0x1000);
+   CHECK(1 == irq_count && 0x100 == irq_at[0]);
+
+   /* acked by the control write */
+   mapper_write(&map73_intf, 0xC000, 0x00);
+   CHECK(false == irq_line);
+
+   /* snapshot halfway: counter reads 0xFF80 and the rest runs on restore */
+   start(0, 1);
+   map73_intf.init();
+   mapper_write(&map73_intf, 0xA000, 0xF);
+   mapper_write(&map73_intf, 0xB000, 0xF);
+   mapper_write(&map73_intf, 0xC000, 0x02);
+   sched_run(0x80);
+   memset(&state, 0, sizeof(state));
+   map73_intf.get_state(&state);
+   CHECK(0x80 == state.extraData.mapper73.irqCounterLowByte);
+   CHECK(0xFF == state.extraData.mapper73.irqCounterHighByte);
+   CHECK(state.extraData.mapper73.irqCounterEnabled);
+   start(300, 1);
+   map73_intf.init();
+   map73_intf.set_state(&state);
+   sched_run(0x1000);
+   CHECK(1 == irq_count && 300 + 0x80 == irq_at[0]);
+}
+
+/* VRC4/6/7: scanline mode clocks every 341 dots, cycle mode every cycle,
+** and the counter reloads from the latch on each overflow
+*/
+static void test_vrcirq(void)
+{
+   int i;
+
+   start(0, 1);
+   vrcirq_reset();
+   vrcirq_latch(0xF0);
+   vrcirq_control(0x02);
+   sched_run(20000);
+   CHECK(irq_count >= 10);
+   for (i = 0; i < 10; i++)
+      CHECK(irq_at[i] == (uint32) (((i + 1) * 16 * 341 + 2) / 3));
+
+   start(0, 1);
+   vrcirq_reset();
+   vrcirq_latch(0xF0);
+   vrcirq_control(0x06);
+   sched_run(160);
+   CHECK(10 == irq_count && 16 == irq_at[0] && 160 == irq_at[9]);
+
+   /* ack without wait state stops it */
+   vrcirq_ack();
+   CHECK(false == irq_line);
+   sched_run(160);
+   CHECK(10 == irq_count);
+}
+
+int main(void)
+{
+   test_order();
+   test_cancel_and_move();
+   test_overshoot();
+   test_set_from_cpu();
+   test_periodic_and_wrap();
+   test_m2_counter(&map42_intf, 0xE002, 0x02, 0x6000);
+   test_m2_counter(&map50_intf, 0x4120, 0x01, 0x1000);
+   test_vrc3();
+   test_vrcirq();
+
+   printf("nes_sched_test: %s\n", failures ? "FAILED" : "ok");
+   return failures ? 1 : 0;
+}
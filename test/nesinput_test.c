@@ -0,0 +1,187 @@
+/*
+** nesinput_test.c
+**
+** $4016/$4017 port devices: what each one shifts out after a strobe, and
+** when the host poll hook gets pulled.
+*/
+
+#include <stdio.h>
+#include "noftypes.h"
+#include "nesinput.h"
+
+static int failures;
+
+#define  CHECK(cond) \
+   do { if (!(cond)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* rest of the machine: a cycle counter and a 16x16 lit box for the zapper */
+static uint32 cpu_cycles;
+
+uint32 nes6502_getcycles(bool reset_flag)
+{
+   UNUSED(reset_flag);
+   return cpu_cycles;
+}
+
+bool ppu_checkzapperhit(int x, int y)
+{
+   return x >= 120 && x < 136 && y >= 96 && y < 112;
+}
+
+static nesinput_t pad[4] =
+{
+   { INP_JOYPAD0, 0 }, { INP_JOYPAD1, 0 }, { INP_JOYPAD2, 0 }, { INP_JOYPAD3, 0 }
+};
+static nesinput_t zapper = { INP_ZAPPER, 0 };
+static nesinput_t arkanoid = { INP_ARKANOID, 0 };
+static nesinput_t powerpad = { INP_POWERPAD, 0 };
+
+static int polls;
+
+static void poll(void)
+{
+   polls++;
+}
+
+/* n reads of a port, bit i of the result is bit `bit` of read i */
+static uint32 shift_out(int num, int bit, int n)
+{
+   uint32 bits = 0;
+   int i;
+
+   for (i = 0; i < n; i++)
+   {
+      uint8 value = input_read(num);
+
+      CHECK(value & 0x40);
+      bits |= (uint32) ((value >> bit) & 1) << i;
+   }
+   return bits;
+}
+
+static void test_joypad(void)
+{
+   input_setport(0, INP_DEV_JOYPAD);
+   input_setport(1, INP_DEV_JOYPAD);
+   pad[0].data = INP_PAD_A | INP_PAD_START | INP_PAD_LEFT;
+   pad[1].data = INP_PAD_B | INP_PAD_UP | INP_PAD_DOWN;   /* up+down is masked */
+
+   input_strobe();
+   CHECK(0x49 == shift_out(0, 0, 8));
+   CHECK(0x02 == shift_out(1, 0, 8));
+
+   /* runs dry into 1s */
+   CHECK(0xFFFFFF == shift_out(0, 0, 24));
+
+   /* a new strobe reloads, D3/D4 stay low */
+   input_strobe();
+   CHECK(0x49 == shift_out(0, 0, 8));
+   input_strobe();
+   CHECK(0 == shift_out(0, 3, 8) && 0 == shift_out(0, 4, 8));
+}
+
+static void test_fourscore(void)
+{
+   input_setport(0, INP_DEV_FOURSCORE);
+   CHECK(INP_DEV_FOURSCORE == input_getport(0) && INP_DEV_FOURSCORE == input_getport(1));
+   pad[0].data = 0x11;
+   pad[1].data = 0x22;
+   pad[2].data = 0x44;
+   pad[3].data = 0x88;
+
+   /* pads 0 and 2, then the signature; pads 1 and 3 on the other port */
+   input_strobe();
+   CHECK(0xFF084411 == shift_out(0, 0, 32));
+   input_strobe();
+   CHECK(0xFF048822 == shift_out(1, 0, 32));
+
+   /* replacing either side drops it */
+   input_setport(1, INP_DEV_ZAPPER);
+   CHECK(INP_DEV_JOYPAD == input_getport(0));
+}
+
+static void test_zapper(void)
+{
+   input_setport(1, INP_DEV_ZAPPER);
+
+   /* no shift register: every read looks at the screen */
+   zapper.data = INP_POS(128, 104);
+   CHECK(INP_ZAPPER_HIT == (input_read(1) & 0x18));
+   CHECK(INP_ZAPPER_HIT == (input_read(1) & 0x18));
+   zapper.data = INP_POS(40, 40) | INP_ZAPPER_TRIG;
+   CHECK((INP_ZAPPER_MISS | INP_ZAPPER_TRIG) == (input_read(1) & 0x18));
+}
+
+static void test_arkanoid(void)
+{
+   input_setport(0, INP_DEV_JOYPAD);
+   input_setport(1, INP_DEV_ARKANOID);
+
+   /* knob goes out on D4, inverted and MSB first; fire is live on D3 */
+   arkanoid.data = INP_POS(0x5B, 0) | INP_ARKANOID_FIRE;
+   input_strobe();
+   CHECK(0x25 == shift_out(1, 4, 8));
+   input_strobe();
+   CHECK(0xFF == shift_out(1, 3, 8));
+   CHECK(0 == (input_read(1) & 0x01));
+}
+
+static void test_powerpad(void)
+{
+   input_setport(1, INP_DEV_POWERPAD);
+
+   /* lower byte on D3, upper nibble on D4 */
+   powerpad.data = INP_PPAD_1 | INP_PPAD_9 | INP_PPAD_3 | INP_PPAD_12;
+   input_strobe();
+   CHECK(0x0A == (shift_out(1, 3, 8) & 0xFF));
+   input_strobe();
+   CHECK(0x6 == (shift_out(1, 4, 4) & 0xF));
+}
+
+/* the host is asked for fresh state when the game strobes, at most once a
+** scanline
+*/
+static void test_poll(void)
+{
+   input_setport(0, INP_DEV_JOYPAD);
+   input_setport(1, INP_DEV_ZAPPER);
+   cpu_cycles = 1000;
+   input_setpoll(poll);
+   polls = 0;
+
+   input_strobe();
+   CHECK(1 == polls);
+   cpu_cycles += 50;
+   input_strobe();
+   input_read(1);
+   CHECK(1 == polls);
+   cpu_cycles += 64;
+   input_read(1);
+   CHECK(2 == polls);
+
+   input_setpoll(NULL);
+   cpu_cycles += 1000;
+   input_strobe();
+   CHECK(2 == polls);
+}
+
+int main(void)
+{
+   int i;
+
+   for (i = 0; i < 4; i++)
+      input_register(&pad[i]);
+   input_register(&zapper);
+   input_register(&arkanoid);
+   input_register(&powerpad);
+
+   test_joypad();
+   test_fourscore();
+   test_zapper();
+   test_arkanoid();
+   test_powerpad();
+   test_poll();
+
+   printf("nesinput_test: %s\n", failures ? "FAILED" : "ok");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+/*
+    opll_test.c
+
+    OPLL FM core: pitch, key off, golden renders of the VRC7 and YM2413
+    patch sets, and what a frame of it costs.
+
+    opll_test -w also writes the golden renders out as .wav files to
+    listen to.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "opll.h"
+
+#define CLOCK       3579545
+#define RATE        15720               /* nofrendo and smsplus output rate */
+#define FRAME       (RATE / 60)
+
+static int failures;
+
+#define CHECK(cond) \
+    do { if(!(cond)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while(0)
+
+/* set a channel up and key it on or off */
+static void key(OPLL *opll, int ch, int inst, int vol, int fnum, int block, int on)
+{
+    OPLL_writeReg(opll, 0x30 + ch, (inst << 4) | vol);
+    OPLL_writeReg(opll, 0x10 + ch, fnum & 0xFF);
+    OPLL_writeReg(opll, 0x20 + ch, (on ? 0x10 : 0) | (block << 1) | (fnum >> 8));
+}
+
+/* user patch 0: a bare sine carrier that sustains and releases fast */
+static void sine_patch(OPLL *opll)
+{
+    static const int regs[8] = { 0x21, 0x21, 0x3F, 0x00, 0xF0, 0xF0, 0x0F, 0x0F };
+    int i;
+
+    for(i = 0; i < 8; i++)
+        OPLL_writeReg(opll, i, regs[i]);
+}
+
+static double rms(const int *buf, int n)
+{
+    double sum = 0;
+    int i;
+
+    for(i = 0; i < n; i++)
+        sum += (double)buf[i] * buf[i];
+    return sqrt(sum / n);
+}
+
+static void wav(const char *name, const int *buf, int n, int rate)
+{
+    FILE *fp = fopen(name, "wb");
+    unsigned int hdr[11] = { 0x46464952, 36 + n * 2, 0x45564157, 0x20746D66, 16,
+                             0x00010001, rate, rate * 2, 0x00100002, 0x61746164, n * 2 };
+    int i;
+
+    if(!fp)
+        return;
+    fwrite(hdr, 4, 11, fp);
+    for(i = 0; i < n; i++)
+    {
+        int s = buf[i] > 32767 ? 32767 : buf[i] < -32768 ? -32768 : buf[i];
+        fputc(s & 0xFF, fp);
+        fputc((s >> 8) & 0xFF, fp);
+    }
+    fclose(fp);
+}
+
+static void test_pitch(int rate)
+{
+    OPLL *opll;
+    int *buf = calloc(rate, sizeof(int));
+    int i, crossings = 0;
+    double hz;
+
+    OPLL_init(CLOCK, rate);
+    opll = OPLL_new();
+    OPLL_reset(opll);
+    sine_patch(opll);
+    key(opll, 0, 0, 0, 290, 4, 1);     /* A4: fnum 290 in block 4 */
+    OPLL_calc_block(opll, buf, rate);
+
+    /* half a second once the attack is over */
+    for(i = rate / 10 + 1; i <= rate * 6 / 10; i++)
+        crossings += (buf[i - 1] < 0) != (buf[i] < 0);
+    hz = crossings / 2.0 / 0.5;
+    printf("A4 at %d Hz: %.1f Hz\n", rate, hz);
+    CHECK(fabs(hz - 440.0) <= 2.0);
+
+    OPLL_delete(opll);
+    free(buf);
+}
+
+/* a released note fades away and the channel goes quiet */
+static void test_release(void)
+{
+    OPLL *opll;
+    int *buf = calloc(RATE * 2, sizeof(int));
+    double on, tail;
+
+    OPLL_init(CLOCK, RATE);
+    opll = OPLL_new();
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, OPLL_VRC7_TONE);
+    key(opll, 0, 1, 0, 290, 4, 1);
+    OPLL_calc_block(opll, buf, RATE);
+    key(opll, 0, 1, 0, 290, 4, 0);
+    OPLL_calc_block(opll, buf + RATE, RATE);
+
+    on = rms(buf + RATE / 2, RATE / 10);
+    tail = rms(buf + RATE * 2 - RATE / 10, RATE / 10);
+    printf("release: %.0f rms held, %.1f rms after a second\n", on, tail);
+    CHECK(on > 500);
+    CHECK(tail < on / 100);
+
+    OPLL_delete(opll);
+    free(buf);
+}
+
+/* FNV-1a over the samples */
+static unsigned int hash(const int *buf, int n)
+{
+    unsigned int h = 2166136261u;
+    int i;
+
+    for(i = 0; i < n; i++)
+    {
+        h = (h ^ (buf[i] & 0xFFFF)) * 16777619u;
+        h = (h ^ ((buf[i] >> 16) & 0xFFFF)) * 16777619u;
+    }
+    return h;
+}
+
+/* VRC7: six ROM patches as a chord, keyed off halfway */
+static void render_vrc7(OPLL *opll, int *buf, int n, int block)
+{
+    int ch, i;
+
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, OPLL_VRC7_TONE);
+    for(ch = 0; ch < 6; ch++)
+        key(opll, ch, ch + 1, ch, 172 + ch * 40, 4, 1);
+    for(i = 0; i < n; i += block)
+    {
+        int end = (i < n / 2) ? n / 2 : n;
+
+        if(i == n / 2)
+            for(ch = 0; ch < 6; ch++)
+                key(opll, ch, ch + 1, ch, 172 + ch * 40, 4, 0);
+        if(block > end - i)
+            block = end - i;
+        OPLL_calc_block(opll, buf + i, block);
+    }
+}
+
+/* YM2413: six melody channels and the rhythm section */
+static void render_2413(OPLL *opll, int *buf, int n)
+{
+    int ch;
+
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, OPLL_2413_TONE);
+    for(ch = 0; ch < 6; ch++)
+        key(opll, ch, ch + 1, 2, 172 + ch * 40, 4, 1);
+    OPLL_writeReg(opll, 0x16, 0x20);
+    OPLL_writeReg(opll, 0x17, 0x50);
+    OPLL_writeReg(opll, 0x18, 0xC0);
+    OPLL_writeReg(opll, 0x26, 0x05);
+    OPLL_writeReg(opll, 0x27, 0x05);
+    OPLL_writeReg(opll, 0x28, 0x01);
+    OPLL_writeReg(opll, 0x36, 0x00);
+    OPLL_writeReg(opll, 0x37, 0x00);
+    OPLL_writeReg(opll, 0x38, 0x00);
+    OPLL_writeReg(opll, 0x0E, 0x3F);
+    OPLL_calc_block(opll, buf, n / 2);
+    OPLL_writeReg(opll, 0x0E, 0x20);
+    OPLL_calc_block(opll, buf + n / 2, n - n / 2);
+}
+
+/* golden renders: these change only when the synthesis does, on purpose */
+#define GOLDEN_VRC7     0xD754B6C3u
+#define GOLDEN_2413     0xB2B1EB4Bu
+
+static void test_golden(int write)
+{
+    OPLL *opll;
+    int *a = calloc(RATE, sizeof(int));
+    int *b = calloc(RATE, sizeof(int));
+    unsigned int h;
+
+    OPLL_init(CLOCK, RATE);
+    opll = OPLL_new();
+
+    /* where the block boundaries fall makes no difference */
+    render_vrc7(opll, a, RATE, 64);
+    render_vrc7(opll, b, RATE, 7);
+    CHECK(0 == memcmp(a, b, RATE * sizeof(int)));
+    h = hash(a, RATE);
+    printf("vrc7 render %08X\n", h);
+    CHECK(GOLDEN_VRC7 == h);
+    if(write)
+        wav("opll_vrc7.wav", a, RATE, RATE);
+
+    memset(a, 0, RATE * sizeof(int));
+    render_2413(opll, a, RATE);
+    h = hash(a, RATE);
+    printf("ym2413 render %08X\n", h);
+    CHECK(GOLDEN_2413 == h);
+    if(write)
+        wav("opll_2413.wav", a, RATE, RATE);
+
+    OPLL_delete(opll);
+    free(a);
+    free(b);
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* a frame of every channel playing, against the budget in opll.h */
+static void bench(void)
+{
+    OPLL *opll;
+    int buf[FRAME];
+    int ch, f, frames = 60 * 60;
+    double t, vrc7, ym2413;
+
+    OPLL_init(CLOCK, RATE);
+    opll = OPLL_new();
+
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, OPLL_VRC7_TONE);
+    for(ch = 0; ch < 6; ch++)
+        key(opll, ch, ch + 1, 0, 200 + ch * 20, 4, 1);
+    t = now_us();
+    for(f = 0; f < frames; f++)
+    {
+        memset(buf, 0, sizeof(buf));
+        OPLL_calc_block(opll, buf, FRAME);
+    }
+    vrc7 = (now_us() - t) / frames;
+
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, OPLL_2413_TONE);
+    for(ch = 0; ch < 9; ch++)
+        key(opll, ch, ch + 1, 0, 200 + ch * 20, 4, 1);
+    OPLL_writeReg(opll, 0x0E, 0x3F);
+    t = now_us();
+    for(f = 0; f < frames; f++)
+    {
+        memset(buf, 0, sizeof(buf));
+        OPLL_calc_block(opll, buf, FRAME);
+    }
+    ym2413 = (now_us() - t) / frames;
+
+    printf("per %d sample frame: vrc7 %.1f us, ym2413 + rhythm %.1f us, budget %d us\n",
+        FRAME, vrc7, ym2413, OPLL_FRAME_BUDGET_US);
+    CHECK(vrc7 < OPLL_FRAME_BUDGET_US);
+    CHECK(ym2413 < OPLL_FRAME_BUDGET_US);
+
+    OPLL_delete(opll);
+}
+
+int main(int argc, char **argv)
+{
+    int write = argc > 1 && 0 == strcmp(argv[1], "-w");
+
+    test_pitch(RATE);
+    test_pitch(44100);
+    test_release();
+    test_golden(write);
+    bench();
+
+    printf("opll_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
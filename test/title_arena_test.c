@@ -0,0 +1,170 @@
+/*
+** title_arena_test.c
+**
+** The per-title arena on its own, then 100 NES cart loads and ejects
+** through the nofrendo core with the host heap checked before and after.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <malloc.h>
+#include "noftypes.h"
+#include "osd.h"
+#include "title_arena.h"
+
+static int failures;
+
+#define  CHECK(cond) \
+   do { if (!(cond)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+/* what emu_nofrendo.cpp reserves */
+#define  NES_ARENA_SIZE    (32 * 1024)
+
+/* the bits of the host nofrendo asks for */
+static unsigned char rom[16 + 16384 * 8 + 8192 * 8];
+
+char *osd_getromdata(void) { return (char *) rom; }
+void osd_getsoundinfo(sndinfo_t *info) { info->sample_rate = 15720; info->bps = 8; }
+void osd_setsound(void (*playfunc)(void *buffer, int size)) { UNUSED(playfunc); }
+void osd_shutdown(void) {}
+int analog_glitch_mask(void) { return 0; }
+void perf_begin(int id) { UNUSED(id); }
+void perf_end(void) {}
+
+extern int nes_emulate_init(const char *path, int width, int height);
+extern uint8 **nes_emulate_frame(bool draw_flag);
+
+static void test_regions(void)
+{
+   arena_region_stats s;
+   void *a, *b, *c, *late;
+
+   arena_init(1024, 256);
+   arena_begin();
+   a = arena_alloc(3, ARENA_INTERNAL);
+   b = arena_alloc(5, ARENA_INTERNAL);
+   c = arena_alloc(6, ARENA_MEM32);
+   CHECK(a && b && c);
+   CHECK(0 == ((uintptr_t) b & 7) && (uint8_t *) b - (uint8_t *) a == 8);
+   CHECK(0 == ((uintptr_t) c & 3));
+
+   /* a full region spills to the heap, and those blocks really get freed */
+   late = arena_alloc(2000, ARENA_INTERNAL);
+   CHECK(late);
+   arena_stats(ARENA_INTERNAL, &s);
+   CHECK(16 == s.used && 2000 == s.spilled);
+   arena_free(late);
+   arena_free(a);
+   arena_end();
+
+   /* outside of a load everything is the heap's */
+   late = arena_alloc(16, ARENA_INTERNAL);
+   arena_stats(ARENA_INTERNAL, &s);
+   CHECK(16 == s.used);
+   arena_free(late);
+
+   /* the next title starts from empty, the peak stays */
+   arena_begin();
+   arena_alloc(100, ARENA_INTERNAL);
+   arena_end();
+   arena_stats(ARENA_INTERNAL, &s);
+   CHECK(104 == s.used && 104 == s.peak);
+}
+
+/* iNES image: a JMP to itself at the reset vector of every bank */
+static void make_rom(int mapper, int prg, int chr)
+{
+   int b;
+
+   memset(rom, 0, sizeof(rom));
+   memcpy(rom, "NES\x1a", 4);
+   rom[4] = prg;
+   rom[5] = chr;
+   rom[6] = ((mapper & 0x0F) << 4) | 0x02;
+   rom[7] = mapper & 0xF0;
+   for (b = 0; b < prg; b++)
+   {
+      unsigned char *p = rom + 16 + b * 16384;
+
+      p[0] = 0x4C; p[1] = 0x00; p[2] = 0xC0;
+      p[16384 - 6] = 0x00; p[16384 - 5] = 0xC0;
+      p[16384 - 4] = 0x00; p[16384 - 3] = 0xC0;
+      p[16384 - 2] = 0x00; p[16384 - 1] = 0xC0;
+   }
+}
+
+typedef struct
+{
+   size_t in_use, free, top;
+} heap_t;
+
+static heap_t heap_now(void)
+{
+   struct mallinfo2 mi = mallinfo2();
+   heap_t h = { mi.uordblks, mi.fordblks, mi.keepcost };
+
+   return h;
+}
+
+static int frag(heap_t h)
+{
+   return h.free ? 100 - (int) (h.top * 100 / h.free) : 0;
+}
+
+/* NROM, VRC7, MMC3, MMC1 and UNROM, round and round */
+static void test_load_eject(void)
+{
+   static const int carts[5][3] = { { 0, 2, 1 }, { 85, 8, 0 }, { 4, 8, 8 }, { 1, 8, 0 }, { 2, 8, 0 } };
+   heap_t first = { 0, 0, 0 }, h;
+   size_t peak = 0;
+   arena_region_stats s;
+   int i, f;
+
+   arena_init(NES_ARENA_SIZE, 0);
+   for (i = 0; i <= 100; i++)
+   {
+      const int *cart = carts[i % 5];
+      void *stray;
+
+      make_rom(cart[0], cart[1], cart[2]);
+      if (nes_emulate_init("test.nes", 256, 240))
+      {
+         printf("load %d of mapper %d failed\n", i, cart[0]);
+         failures++;
+         return;
+      }
+      for (f = 0; f < 2; f++)
+         nes_emulate_frame(true);
+
+      /* the gui allocates in between loads too */
+      stray = malloc(3000 + i * 16);
+      h = heap_now();
+      if (h.in_use > peak)
+         peak = h.in_use;
+      free(stray);
+
+      h = heap_now();
+      if (0 == i)
+         first = h;
+   }
+
+   arena_stats(ARENA_INTERNAL, &s);
+   printf("heap in use %zu -> %zu after 100 loads, peak %zu, fragmentation %d%% -> %d%%\n",
+          first.in_use, h.in_use, peak, frag(first), frag(h));
+   printf("arena %u of %u used, peak %u, %u spilled\n", s.used, s.size, s.peak, s.spilled);
+
+   /* the same cart as the first load leaves the heap where it was */
+   CHECK(h.in_use <= first.in_use);
+   CHECK(0 == s.spilled && s.peak <= NES_ARENA_SIZE);
+}
+
+int main(void)
+{
+   test_regions();
+   test_load_eject();
+
+   printf("title_arena_test: %s\n", failures ? "FAILED" : "ok");
+   return failures ? 1 : 0;
+}